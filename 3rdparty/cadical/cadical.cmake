@@ -1,7 +1,7 @@
 include(ExternalProject)
 
-SET(CADICAL_PREFIX cadical06w)
-SET(CADICAL_URL https://github.com/arminbiere/cadical/archive/rel-06w.zip)
+SET(CADICAL_PREFIX cadical195)
+SET(CADICAL_URL https://github.com/arminbiere/cadical/archive/rel-1.9.5.zip)
 
 ExternalProject_Add(${CADICAL_PREFIX}
 	PREFIX ${CADICAL_PREFIX}
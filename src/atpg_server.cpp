@@ -0,0 +1,274 @@
+#include "atpg_server.h"
+
+#include "util/log.h"
+#include "util/timer.h"
+
+#include <sstream>
+
+#ifdef __unix__
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+static std::string trim(const std::string& str)
+{
+	size_t begin = str.find_first_not_of(" \t\r\n");
+	if (begin == std::string::npos) {
+		return {};
+	}
+	size_t end = str.find_last_not_of(" \t\r\n");
+	return str.substr(begin, end - begin + 1);
+}
+
+AtpgServer::AtpgServer(const CircuitGraph& circuit, GateEncoding gate_encoding)
+	: m_circuit(circuit)
+	, m_gate_encoding(gate_encoding)
+	, m_fault_manager(circuit)
+{
+	make_solver();
+}
+
+void AtpgServer::set_solver_limits(size_t max_faults, size_t max_clauses)
+{
+	m_max_solver_faults = max_faults;
+	m_max_solver_clauses = max_clauses;
+}
+
+bool AtpgServer::set_solver_options(const std::vector<std::pair<std::string, int>>& options, int64_t conflict_limit)
+{
+	m_solver_options = options;
+	m_conflict_limit = conflict_limit;
+	return make_solver();
+}
+
+bool AtpgServer::make_solver()
+{
+	m_solver.reset();
+	std::unique_ptr<SatSolver> solver = SolverFactory::make_solver();
+	bool options_ok = true;
+	for (const auto& option : m_solver_options) {
+		options_ok = solver->set_option(option.first, option.second) && options_ok;
+	}
+	solver->set_conflict_limit(m_conflict_limit);
+	m_solver.reset(new IncrementalFaultSolver(m_circuit, std::move(solver), m_gate_encoding));
+	m_circuit_clauses = m_solver->get_solver().get_clause_count();
+	m_solver_faults = 0;
+	return options_ok;
+}
+
+std::string AtpgServer::handle_request(const std::string& request)
+{
+	++m_requests;
+
+	std::string line = trim(request);
+	size_t command_end = line.find(' ');
+	std::string command = line.substr(0, command_end);
+	std::string args = command_end == std::string::npos ? std::string() : trim(line.substr(command_end));
+
+	std::string response;
+	if (command == "faults") {
+		for (size_t id = 0; id < m_fault_manager.get_fault_count(); ++id) {
+			response += get_unique_fault_name(m_fault_manager.get_fault(id));
+			response += "\n";
+		}
+	} else if (command == "test") {
+		handle_test(args, false, response);
+	} else if (command == "testable") {
+		handle_test(args, true, response);
+	} else if (command == "inputs") {
+		for (const Line* input : m_circuit.get_inputs()) {
+			response += input->name;
+			response += "\n";
+		}
+	} else if (command == "stats") {
+		response += "requests " + std::to_string(m_requests) + "\n";
+		response += "solved_faults " + std::to_string(m_solved_faults) + "\n";
+		response += "solve_time_ms " + std::to_string(m_solve_time_us / 1000) + "\n";
+		response += "solver_rebuilds " + std::to_string(m_solver_rebuilds) + "\n";
+	} else if (command == "quit") {
+		m_connection_closed = true;
+	} else if (command == "shutdown") {
+		m_connection_closed = true;
+		m_shut_down = true;
+	} else if (command.empty()) {
+		return {};
+	} else {
+		return "ERROR unknown command " + command + "\n";
+	}
+
+	response += "OK\n";
+	return response;
+}
+
+void AtpgServer::handle_test(const std::string& args, bool only_detectability, std::string& response)
+{
+	std::stringstream ss(args);
+	for (std::string name; std::getline(ss, name, ',');) {
+		name = trim(name);
+		if (name.empty()) {
+			continue;
+		}
+
+		size_t fault_id = 0;
+		if (!m_fault_manager.find_fault(name, fault_id)) {
+			response += name + ": ERROR no such fault\n";
+			continue;
+		}
+
+		size_t max_clauses = m_max_solver_clauses ? m_max_solver_clauses : 4 * m_circuit_clauses;
+		if (m_solver_faults >= m_max_solver_faults || m_solver->get_solver().get_clause_count() > max_clauses) {
+			make_solver();
+			++m_solver_rebuilds;
+		}
+
+		ElapsedTimer t(true);
+		SatSolver::SolveStatus status = m_solver->solve(m_fault_manager.get_fault(fault_id));
+		m_solve_time_us += t.get_elapsed_us();
+		++m_solved_faults;
+		++m_solver_faults;
+
+		response += name + ": ";
+		if (only_detectability) {
+			response += status == SatSolver::Sat ? "1" : (status == SatSolver::Unsat ? "0" : "?");
+		} else if (status == SatSolver::Sat) {
+			response += "DETECTABLE " + m_solver->get_pattern();
+		} else if (status == SatSolver::Unsat) {
+			response += "UNDETECTABLE";
+		} else {
+			response += "UNKNOWN";
+		}
+		response += "\n";
+	}
+}
+
+void AtpgServer::serve(std::istream& is, std::ostream& os)
+{
+	m_connection_closed = false;
+	for (std::string line; !m_connection_closed && std::getline(is, line);) {
+		os << handle_request(line);
+		os.flush();
+	}
+}
+
+#ifdef __unix__
+
+// Stream buffer over connected socket
+class SocketStreamBuf : public std::streambuf
+{
+public:
+	SocketStreamBuf(int fd)
+		: m_fd(fd)
+	{
+		setg(m_in, m_in, m_in);
+		setp(m_out, m_out + sizeof(m_out));
+	}
+
+	~SocketStreamBuf()
+	{
+		sync();
+	}
+
+protected:
+	int_type underflow() override
+	{
+		ssize_t size = ::read(m_fd, m_in, sizeof(m_in));
+		if (size <= 0) {
+			return traits_type::eof();
+		}
+		setg(m_in, m_in, m_in + size);
+		return traits_type::to_int_type(m_in[0]);
+	}
+
+	int_type overflow(int_type c) override
+	{
+		if (sync() != 0) {
+			return traits_type::eof();
+		}
+		if (!traits_type::eq_int_type(c, traits_type::eof())) {
+			*pptr() = traits_type::to_char_type(c);
+			pbump(1);
+		}
+		return traits_type::not_eof(c);
+	}
+
+	int sync() override
+	{
+		for (char* p = pbase(); p < pptr();) {
+			ssize_t size = ::write(m_fd, p, pptr() - p);
+			if (size <= 0) {
+				return -1;
+			}
+			p += size;
+		}
+		setp(m_out, m_out + sizeof(m_out));
+		return 0;
+	}
+
+private:
+	int m_fd = -1;
+	char m_in[1 << 12];
+	char m_out[1 << 12];
+};
+
+bool AtpgServer::serve_socket(const std::string& path)
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path)) {
+		log_error() << "socket path is too long:" << path;
+		return false;
+	}
+	std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+	int server_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server_fd < 0) {
+		log_error() << "can't create socket";
+		return false;
+	}
+
+	::unlink(path.c_str());
+	if (::bind(server_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(server_fd, 8) != 0) {
+		log_error() << "can't listen on socket" << path;
+		::close(server_fd);
+		return false;
+	}
+
+	while (!m_shut_down) {
+		int connection_fd = ::accept(server_fd, nullptr, nullptr);
+		if (connection_fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			// Other errors (e.g. EMFILE) would fail again right away
+			log_error() << "can't accept connection:" << strerror(errno);
+			::close(server_fd);
+			::unlink(path.c_str());
+			return false;
+		}
+		{
+			SocketStreamBuf buf(connection_fd);
+			std::istream is(&buf);
+			std::ostream os(&buf);
+			serve(is, os);
+		}
+		::close(connection_fd);
+	}
+
+	::close(server_fd);
+	::unlink(path.c_str());
+	return true;
+}
+
+#else
+
+bool AtpgServer::serve_socket(const std::string& path)
+{
+	log_error() << "unix domain sockets are not supported on this platform:" << path;
+	return false;
+}
+
+#endif
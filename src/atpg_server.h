@@ -0,0 +1,71 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "fault_manager.h"
+#include "incremental_solver.h"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Long running ATPG server that keeps circuit, fault list and incremental solver loaded.
+// Line based protocol, every request is answered with zero or more data lines
+// followed by "OK" or "ERROR <message>" line:
+// 	faults                     - list names of all faults, "<line>/PO" for primary outputs with fanout
+// 	test <fault>[, <fault>...] - generate tests: "<fault>: DETECTABLE <pattern>", "<fault>: UNDETECTABLE" or "<fault>: UNKNOWN"
+// 	testable <fault>[, ...]    - same as test but answers with 1, 0 or ? for each fault
+// 	inputs                     - circuit input names in pattern order
+// 	stats                      - query statistics
+// 	quit                       - close connection
+// 	shutdown                   - stop server
+class AtpgServer
+{
+public:
+	AtpgServer(const CircuitGraph& circuit, GateEncoding gate_encoding = GateEncoding::Expanded);
+
+	// Clauses of every solved fault stay in the incremental solver, so it is rebuilt from the circuit
+	// after max_faults faults or when it has more than max_clauses clauses (0 is four times the circuit CNF)
+	void set_solver_limits(size_t max_faults, size_t max_clauses);
+
+	// Rebuilds the solver with these options, faults over the conflict limit are answered UNKNOWN.
+	// Returns false if the solver rejects an option.
+	bool set_solver_options(const std::vector<std::pair<std::string, int>>& options, int64_t conflict_limit);
+	size_t get_solver_rebuilds() const { return m_solver_rebuilds; }
+
+	// Returns response for one request line
+	std::string handle_request(const std::string& request);
+
+	bool is_connection_closed() const { return m_connection_closed; }
+	bool is_shut_down() const { return m_shut_down; }
+
+	// Serves requests until connection is closed or server is shut down
+	void serve(std::istream& is, std::ostream& os);
+
+	// Serves connections on unix domain socket one after another until shut down
+	bool serve_socket(const std::string& path);
+
+private:
+	void handle_test(const std::string& args, bool only_detectability, std::string& response);
+	bool make_solver();
+
+	const CircuitGraph& m_circuit;
+	GateEncoding m_gate_encoding;
+	FaultManager m_fault_manager;
+	std::unique_ptr<IncrementalFaultSolver> m_solver;
+	std::vector<std::pair<std::string, int>> m_solver_options;
+	int64_t m_conflict_limit = -1;
+	size_t m_max_solver_faults = 1000;
+	size_t m_max_solver_clauses = 0;
+	size_t m_circuit_clauses = 0;
+	size_t m_solver_faults = 0;
+	size_t m_solver_rebuilds = 0;
+
+	bool m_connection_closed = false;
+	bool m_shut_down = false;
+
+	size_t m_requests = 0;
+	size_t m_solved_faults = 0;
+	uint64_t m_solve_time_us = 0;
+};
@@ -0,0 +1,95 @@
+#include "benchmark.h"
+
+#include "../util/timer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+void BenchmarkRunner::run(const std::string& name, const Function& function)
+{
+	if (name.find(m_filter) == std::string::npos) {
+		return;
+	}
+
+	// Warm-up, also fills caches built on first use
+	function();
+
+	BenchmarkResult result;
+	result.name = name;
+	result.iterations = 1;
+	while (true) {
+		ElapsedTimer timer(true);
+		for (uint64_t i = 0; i < result.iterations; ++i) {
+			function();
+		}
+		if (timer.get_elapsed_ms() >= m_min_sample_ms) {
+			break;
+		}
+		result.iterations *= 2;
+	}
+
+	std::vector<double> times;
+	for (size_t sample = 0; sample < m_samples; ++sample) {
+		ElapsedTimer timer(true);
+		for (uint64_t i = 0; i < result.iterations; ++i) {
+			function();
+		}
+		times.push_back(timer.get_elapsed_us() * 1000.0 / result.iterations);
+	}
+
+	std::sort(times.begin(), times.end());
+	result.samples = times.size();
+	result.median_ns = times.size() % 2 ? times[times.size() / 2] : (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+	result.min_ns = times.front();
+	for (double time : times) {
+		result.mean_ns += time;
+	}
+	result.mean_ns /= times.size();
+	for (double time : times) {
+		result.stddev_ns += (time - result.mean_ns) * (time - result.mean_ns);
+	}
+	result.stddev_ns = times.size() > 1 ? std::sqrt(result.stddev_ns / (times.size() - 1)) : 0;
+
+	m_results.push_back(result);
+}
+
+void write_results_table(std::ostream& os, const std::vector<BenchmarkResult>& results)
+{
+	size_t name_width = 10;
+	for (const BenchmarkResult& result : results) {
+		name_width = std::max(name_width, result.name.size());
+	}
+
+	os << std::left << std::setw(name_width) << "benchmark" << std::right
+		<< std::setw(14) << "median us" << std::setw(14) << "min us" << std::setw(10) << "stddev" << std::setw(12) << "iterations" << "\n";
+	for (const BenchmarkResult& result : results) {
+		double relative_stddev = result.mean_ns ? 100 * result.stddev_ns / result.mean_ns : 0;
+		os << std::left << std::setw(name_width) << result.name << std::right << std::fixed << std::setprecision(3)
+			<< std::setw(14) << result.median_ns / 1000 << std::setw(14) << result.min_ns / 1000
+			<< std::setprecision(1) << std::setw(9) << relative_stddev << "%" << std::setw(12) << result.iterations << "\n";
+	}
+}
+
+void write_results_csv(std::ostream& os, const std::vector<BenchmarkResult>& results)
+{
+	os << "name,iterations,samples,median_ns,min_ns,mean_ns,stddev_ns\n";
+	os << std::fixed << std::setprecision(1);
+	for (const BenchmarkResult& result : results) {
+		os << result.name << "," << result.iterations << "," << result.samples << "," << result.median_ns << ","
+			<< result.min_ns << "," << result.mean_ns << "," << result.stddev_ns << "\n";
+	}
+}
+
+void write_results_json(std::ostream& os, const std::vector<BenchmarkResult>& results)
+{
+	os << "{\"benchmarks\": [";
+	os << std::fixed << std::setprecision(1);
+	for (size_t i = 0; i < results.size(); ++i) {
+		const BenchmarkResult& result = results[i];
+		os << (i ? ",\n" : "\n") << "  {\"name\": \"" << result.name << "\", \"iterations\": " << result.iterations
+			<< ", \"samples\": " << result.samples << ", \"median_ns\": " << result.median_ns << ", \"min_ns\": " << result.min_ns
+			<< ", \"mean_ns\": " << result.mean_ns << ", \"stddev_ns\": " << result.stddev_ns << "}";
+	}
+	os << "\n]}\n";
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct BenchmarkResult
+{
+	std::string name;
+	uint64_t iterations = 0; // runs per sample
+	size_t samples = 0;
+	double median_ns = 0; // per run
+	double min_ns = 0;
+	double mean_ns = 0;
+	double stddev_ns = 0;
+};
+
+// Runs each benchmark function repeatedly: after a warm-up run, iterations per sample are doubled until a sample
+// takes at least min_sample_ms, then the configured number of samples is timed. Median per run is the main result,
+// min and standard deviation show how stable it is.
+class BenchmarkRunner
+{
+public:
+	using Function = std::function<void()>;
+
+	void set_samples(size_t samples) { m_samples = samples; }
+	void set_min_sample_ms(uint64_t min_sample_ms) { m_min_sample_ms = min_sample_ms; }
+	// Only benchmarks with this substring in their name are run
+	void set_filter(const std::string& filter) { m_filter = filter; }
+
+	void run(const std::string& name, const Function& function);
+
+	const std::vector<BenchmarkResult>& get_results() const { return m_results; }
+
+private:
+	size_t m_samples = 10;
+	uint64_t m_min_sample_ms = 20;
+	std::string m_filter;
+	std::vector<BenchmarkResult> m_results;
+};
+
+void write_results_table(std::ostream& os, const std::vector<BenchmarkResult>& results);
+void write_results_csv(std::ostream& os, const std::vector<BenchmarkResult>& results);
+void write_results_json(std::ostream& os, const std::vector<BenchmarkResult>& results);
@@ -0,0 +1,239 @@
+#include "benchmark.h"
+
+#include "../circuit_graph.h"
+#include "../circuit_to_cnf.h"
+#include "../fault_cnf.h"
+#include "../fault_manager.h"
+#include "../iscas89_parser.h"
+#include "../netlist_generator.h"
+#include "../solver_proxy.h"
+#include "../tests/circuit_strings.h"
+
+#include "../util/log.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+// Counts clauses instead of storing them, so make_fault is measured without solver or allocation costs
+class NullCnf : public ICnf
+{
+public:
+	ICnf& operator=(const Cnf& other) override final
+	{
+		m_clauses = other.get_clauses().size();
+		return *this;
+	}
+
+	void reserve(size_t) override final {}
+	void clear() override final { m_clauses = 0; }
+	void add_clause(clause_t) override final { ++m_clauses; }
+	void add_clause(literal_t, literal_t, literal_t, literal_t, literal_t) override final { ++m_clauses; }
+	void add_clauses(std::vector<clause_t>& from) override final { m_clauses += from.size(); }
+
+	size_t get_clause_count() const { return m_clauses; }
+
+private:
+	size_t m_clauses = 0;
+};
+
+static std::string make_generated_bench(size_t gates, size_t max_fanin)
+{
+	NetlistGeneratorConfig config;
+	config.gates = gates;
+	config.max_fanin = max_fanin;
+	// Enough inputs for the widest gates already on the first level
+	config.inputs = std::max<size_t>(gates / 20, max_fanin);
+	config.outputs = std::max<size_t>(gates / 40, 1);
+	std::ostringstream os;
+	NetlistGenerator(config).write_bench(os);
+	return os.str();
+}
+
+struct BenchCircuit
+{
+	std::string name;
+	std::string bench;
+	CircuitGraph graph;
+	std::unique_ptr<FaultManager> fault_manager;
+};
+
+static bool load_circuit(BenchCircuit& circuit)
+{
+	std::istringstream is(circuit.bench);
+	Iscas89Parser parser;
+	if (!parser.parse(is, circuit.graph)) {
+		log_error() << "Can't parse benchmark circuit" << circuit.name;
+		return false;
+	}
+	circuit.fault_manager.reset(new FaultManager(circuit.graph));
+	return true;
+}
+
+static std::vector<const Gate*> get_output_gates(const CircuitGraph& graph)
+{
+	std::vector<const Gate*> gates;
+	for (const Line* output : graph.get_outputs()) {
+		if (output->source) {
+			gates.push_back(output->source);
+		}
+	}
+	return gates;
+}
+
+static void run_benchmarks(BenchmarkRunner& runner, BenchCircuit& circuit, size_t max_sampled_faults, bool has_solver)
+{
+	const CircuitGraph& graph = circuit.graph;
+	const FaultManager& faults = *circuit.fault_manager;
+
+	// Per fault work grows with the circuit, so large circuits use an evenly spread sample of faults
+	std::vector<size_t> fault_ids;
+	size_t stride = (faults.get_fault_count() + max_sampled_faults - 1) / max_sampled_faults;
+	for (size_t fault_id = 0; fault_id < faults.get_fault_count(); fault_id += stride) {
+		fault_ids.push_back(fault_id);
+	}
+
+	// Results are summed into this so the compiler can't drop the measured work
+	static volatile size_t sink = 0;
+
+	runner.run("parse/" + circuit.name, [&circuit]() {
+		CircuitGraph parsed;
+		std::istringstream is(circuit.bench);
+		Iscas89Parser parser;
+		parser.parse(is, parsed);
+		sink = sink + parsed.get_lines().size();
+	});
+
+	runner.run("fanout_cone/" + circuit.name, [&faults, &fault_ids]() {
+		for (size_t fault_id : fault_ids) {
+			sink = sink + make_fanout_cone(faults.get_fault(fault_id)).lines_inside.size();
+		}
+	});
+
+	std::vector<const Gate*> output_gates = get_output_gates(graph);
+	runner.run("walk_bfs/" + circuit.name, [&output_gates]() {
+		size_t gates = 0;
+		walk_gates_breadth_first(output_gates, [&gates](const Gate*) { ++gates; }, false, true);
+		sink = sink + gates;
+	});
+
+	runner.run("make_cnf/" + circuit.name, [&graph]() {
+		CircuitToCnfTransformer transformer;
+		sink = sink + transformer.make_cnf(graph).get_clauses().size();
+	});
+
+	// Wide gates are expanded into chains of two-input gates or encoded directly (_nary)
+	for (GateEncoding encoding : {GateEncoding::Expanded, GateEncoding::Nary}) {
+		std::string suffix = encoding == GateEncoding::Nary ? "_nary/" : "/";
+		FaultCnfMaker fault_cnf_maker(graph, encoding);
+		runner.run("make_fault" + suffix + circuit.name, [&faults, &fault_ids, &fault_cnf_maker]() {
+			NullCnf cnf;
+			for (size_t fault_id : fault_ids) {
+				fault_cnf_maker.make_fault(faults.get_fault(fault_id), cnf);
+			}
+			sink = sink + cnf.get_clause_count();
+		});
+
+		if (!has_solver) {
+			continue;
+		}
+
+		runner.run("end_to_end" + suffix + circuit.name, [&graph, &faults, &fault_ids, encoding]() {
+			std::unique_ptr<SatSolver> solver = SolverFactory::make_solver();
+			ProxyCnf proxy(*solver);
+			FaultCnfMaker maker(graph, encoding);
+			for (size_t fault_id : fault_ids) {
+				maker.make_fault(faults.get_fault(fault_id), proxy);
+				sink = sink + solver->solve_prepared();
+			}
+		});
+	}
+}
+
+static void print_usage()
+{
+	std::cerr << "Usage: bench [--filter <substring>] [--samples N] [--min-time-ms N] [--large-gates N] [--wide-fanin N] [--faults N] [--json | --csv] [--output <file>]\n";
+}
+
+int main(int argc, char* argv[])
+{
+	BenchmarkRunner runner;
+	size_t large_gates = 2000;
+	size_t wide_fanin = 16;
+	size_t max_sampled_faults = 100;
+	std::string format = "table";
+	std::string output_path;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		try {
+			if (arg == "--filter" && has_value) {
+				runner.set_filter(argv[++i]);
+			} else if (arg == "--samples" && has_value) {
+				runner.set_samples(std::max(1, std::stoi(argv[++i])));
+			} else if (arg == "--min-time-ms" && has_value) {
+				runner.set_min_sample_ms(std::stoul(argv[++i]));
+			} else if (arg == "--large-gates" && has_value) {
+				large_gates = std::max(1, std::stoi(argv[++i]));
+			} else if (arg == "--wide-fanin" && has_value) {
+				wide_fanin = std::max(2, std::stoi(argv[++i]));
+			} else if (arg == "--faults" && has_value) {
+				max_sampled_faults = std::max(1, std::stoi(argv[++i]));
+			} else if (arg == "--json" || arg == "--csv") {
+				format = arg.substr(2);
+			} else if (arg == "--output" && has_value) {
+				output_path = argv[++i];
+			} else {
+				print_usage();
+				return 1;
+			}
+		} catch (const std::exception&) {
+			log_error() << "invalid value for" << arg << argv[i];
+			print_usage();
+			return 1;
+		}
+	}
+
+	bool has_solver = SolverFactory::make_solver() != nullptr;
+	if (!has_solver) {
+		log_warning() << "No SAT solver, end to end benchmarks are skipped";
+	}
+
+	BenchCircuit circuits[4];
+	circuits[0].name = "c17";
+	circuits[0].bench = get_c17_bench();
+	circuits[1].name = "s27";
+	circuits[1].bench = get_s27_bench();
+	circuits[2].name = "large";
+	circuits[2].bench = make_generated_bench(large_gates, NetlistGeneratorConfig().max_fanin);
+	circuits[3].name = "wide";
+	circuits[3].bench = make_generated_bench(large_gates, wide_fanin);
+
+	for (BenchCircuit& circuit : circuits) {
+		if (!load_circuit(circuit)) {
+			return 1;
+		}
+		run_benchmarks(runner, circuit, max_sampled_faults, has_solver);
+	}
+
+	std::ofstream output_file;
+	if (!output_path.empty()) {
+		output_file.open(output_path);
+		if (!output_file) {
+			log_error() << "Can't open" << output_path;
+			return 1;
+		}
+	}
+	std::ostream& os = output_path.empty() ? std::cout : output_file;
+
+	if (format == "json") {
+		write_results_json(os, runner.get_results());
+	} else if (format == "csv") {
+		write_results_csv(os, runner.get_results());
+	} else {
+		write_results_table(os, runner.get_results());
+	}
+	return 0;
+}
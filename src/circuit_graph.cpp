@@ -2,6 +2,7 @@
 
 #include "util/log.h"
 
+#include <algorithm>
 #include <sstream>
 #include <map>
 #include <set>
@@ -41,6 +42,13 @@ const char* make_gate_name(Gate::Type type)
 	return "???";
 }
 
+struct Gate::Expansion
+{
+	std::deque<Gate> gates;
+	std::deque<Line> lines;
+	std::vector<size_t> input_indices; // two per expanded gate
+};
+
 Gate::Gate(IdMaker& id_maker, Gate::Type type, Line* output, std::vector<Line*>&& inputs)
 	: m_id_maker(id_maker)
 	, m_type(type)
@@ -49,62 +57,145 @@ Gate::Gate(IdMaker& id_maker, Gate::Type type, Line* output, std::vector<Line*>&
 	, m_id(id_maker.gate_make_id())
 {
 
-	bool is_expandable = inputs.size() > 2;
+	bool is_expandable = m_inputs.size() > 2;
 	if (!is_expandable) {
 		m_expanded_gate_ptrs = { this };
-	} else {
-		Type top_gate = Type::Undefined;
-		Type other_gates = Type::Undefined;
-		switch (m_type) {
-			case Type::And:
-				top_gate = Type::And;
-				other_gates = Type::And;
-				break;
-			case Type::Nand:
-				top_gate = Type::Nand;
-				other_gates = Type::And;
-				break;
-			case Type::Or:
-				top_gate = Type::Or;
-				other_gates = Type::Or;
-				break;
-			case Type::Nor:
-				top_gate = Type::Nor;
-				other_gates = Type::Or;
-				break;
-			default:
-				assert(false);
-				break;
-		}
+		return;
+	}
+
+	Type top_gate = Type::Undefined;
+	Type other_gates = Type::Undefined;
+	switch (m_type) {
+		case Type::And:
+			top_gate = Type::And;
+			other_gates = Type::And;
+			break;
+		case Type::Nand:
+			top_gate = Type::Nand;
+			other_gates = Type::And;
+			break;
+		case Type::Or:
+			top_gate = Type::Or;
+			other_gates = Type::Or;
+			break;
+		case Type::Nor:
+			top_gate = Type::Nor;
+			other_gates = Type::Or;
+			break;
+		default:
+			assert(false);
+			break;
+	}
 
-		Line* second_input = m_inputs.back();
-		for (auto it = m_inputs.rbegin() + 1; it != m_inputs.rend(); ++it) {
-			bool is_top_gate = it == m_inputs.rend() - 1;
+	// n - 1 two-input gates and n - 2 lines between them for any shape, set_expansion connects them
+	m_expansion.reset(new Expansion);
+	for (size_t i = 0; i + 1 < m_inputs.size(); ++i) {
+		bool is_top_gate = i + 2 == m_inputs.size();
+
+		Line* output = m_output;
+		if (!is_top_gate) {
+			m_expansion->lines.emplace_back(id_maker.line_make_id(), true);
+			Line& line = m_expansion->lines.back();
+			line.name = m_output->name;
+			line.name += "_E_";
+			line.name += std::to_string(i + 1);
+			output = &line;
+		}
 
-			Line* first_input = *it;
+		m_expansion->gates.emplace_back(id_maker, is_top_gate ? top_gate : other_gates, output, std::vector<Line*>{nullptr, nullptr});
+		m_expanded_gate_ptrs.push_back(&m_expansion->gates.back());
+	}
+	set_expansion(GateExpansion::Chain, {});
+}
 
-			Type type = is_top_gate ? top_gate : other_gates;
+Gate::~Gate() = default;
 
-			Line* output = nullptr;
-			if (is_top_gate) {
-				output = m_output;
-			} else {
-				m_expanded_lines.emplace_back(id_maker.line_make_id(), true);
-				Line& line = m_expanded_lines.back();
-				line.name = m_output->name;
-				line.name += "_E_";
-				line.name += std::to_string(std::distance(m_inputs.rbegin(), it));
-				output = &line;
+// Pairs of nodes joined by two-input gates. Nodes 0..n-1 are gate inputs, the pair k makes node n + k.
+static std::vector<std::pair<size_t, size_t>> make_expansion_pairs(GateExpansion expansion, const std::vector<size_t>& input_levels, size_t n)
+{
+	std::vector<std::pair<size_t, size_t>> pairs;
+	switch (expansion) {
+		case GateExpansion::Chain: {
+			size_t last = n - 1;
+			for (size_t i = n - 1; i-- > 0; ) {
+				pairs.emplace_back(i, last);
+				last = n + pairs.size() - 1;
 			}
+			break;
+		}
+		case GateExpansion::Balanced: {
+			std::vector<size_t> layer(n);
+			for (size_t i = 0; i < n; ++i) {
+				layer[i] = i;
+			}
+			while (layer.size() > 1) {
+				std::vector<size_t> next;
+				for (size_t i = 0; i < layer.size(); i += 2) {
+					if (i + 1 < layer.size()) {
+						pairs.emplace_back(layer[i], layer[i + 1]);
+						next.push_back(n + pairs.size() - 1);
+					} else {
+						next.push_back(layer[i]);
+					}
+				}
+				layer.swap(next);
+			}
+			break;
+		}
+		case GateExpansion::Level: {
+			// (level, node), ties go to the node made first. Equal levels give the least depth but not always
+			// the balanced shape, e.g. with 5 inputs the fifth is paired with the first new node instead of last
+			assert(input_levels.size() == n);
+			std::vector<std::pair<size_t, size_t>> ready;
+			for (size_t i = 0; i < n; ++i) {
+				ready.emplace_back(input_levels[i], i);
+			}
+			while (ready.size() > 1) {
+				std::partial_sort(ready.begin(), ready.begin() + 2, ready.end());
+				pairs.emplace_back(ready[0].second, ready[1].second);
+				size_t level = std::max(ready[0].first, ready[1].first) + 1;
+				ready.erase(ready.begin(), ready.begin() + 2);
+				ready.emplace_back(level, n + pairs.size() - 1);
+			}
+			break;
+		}
+	}
+	assert(pairs.size() == n - 1);
+	return pairs;
+}
 
-			m_expanded_gate.emplace_back(id_maker, type, output, std::vector<Line*>{first_input, second_input});
-			Gate& gate = m_expanded_gate.back();
+void Gate::set_expansion(GateExpansion expansion, const std::vector<size_t>& input_levels)
+{
+	const size_t n = m_inputs.size();
+	if (!m_expansion) {
+		return;
+	}
 
-			m_expanded_gate_ptrs.push_back(&gate);
+	std::vector<std::pair<size_t, size_t>> pairs = make_expansion_pairs(expansion, input_levels, n);
+	const size_t no_input = std::numeric_limits<size_t>::max();
+	auto node_line = [this, n](size_t node) {
+		return node < n ? m_inputs[node] : &m_expansion->lines[node - n];
+	};
+
+	// Pairs are in topological order and the last one is the top gate
+	std::vector<size_t>& input_indices = m_expansion->input_indices;
+	input_indices.clear();
+	for (size_t k = 0; k < pairs.size(); ++k) {
+		Gate& gate = m_expansion->gates[k];
+		gate.inputs() = {node_line(pairs[k].first), node_line(pairs[k].second)};
+		gate.output() = k + 1 == pairs.size() ? m_output : &m_expansion->lines[k];
+		input_indices.push_back(pairs[k].first < n ? pairs[k].first : no_input);
+		input_indices.push_back(pairs[k].second < n ? pairs[k].second : no_input);
+	}
+}
 
-			second_input = gate.get_output();
-		}
+size_t Gate::get_expanded_input_idx(size_t expanded_idx, size_t input) const
+{
+	if (!m_expansion) {
+		assert(expanded_idx == 0);
+		return input;
 	}
+	return m_expansion->input_indices.at(2 * expanded_idx + input);
 }
 
 const std::vector<Gate*>& Gate::get_expanded() const
@@ -124,6 +215,90 @@ std::string Gate::get_str() const
 	return ss.str();
 }
 
+std::vector<const Gate*> make_topological_order(const CircuitGraph& circuit)
+{
+	std::vector<size_t> pending_inputs(circuit.gate_id_end(), 0);
+	std::vector<const Gate*> order;
+	order.reserve(circuit.get_gates().size());
+
+	for (const Gate& gate : circuit.get_gates()) {
+		for (const Line* input : gate.get_inputs()) {
+			if (input->source) {
+				++pending_inputs[gate.get_id()];
+			}
+		}
+		if (!pending_inputs[gate.get_id()]) {
+			order.push_back(&gate);
+		}
+	}
+
+	for (size_t i = 0; i < order.size(); ++i) {
+		for (const Line::Connection& connection : order[i]->get_output()->destinations) {
+			if (!--pending_inputs[connection.gate->get_id()]) {
+				order.push_back(connection.gate);
+			}
+		}
+	}
+
+	assert(order.size() == circuit.get_gates().size() && "circuit has combinational loops");
+	return order;
+}
+
+std::vector<const Line*> make_immediate_post_dominators(const CircuitGraph& circuit)
+{
+	std::vector<const Line*> order;
+	for (const Line& line : circuit.get_lines()) {
+		if (!line.source) {
+			order.push_back(&line);
+		}
+	}
+	for (const Gate* gate : make_topological_order(circuit)) {
+		order.push_back(gate->get_output());
+	}
+
+	// Lines later in topological order are closer to outputs, virtual sink after all outputs goes last
+	const size_t sink = order.size();
+	const size_t unreachable = std::numeric_limits<size_t>::max();
+	std::vector<size_t> line_to_index(circuit.line_id_end(), unreachable);
+	for (size_t i = 0; i < order.size(); ++i) {
+		line_to_index[order[i]->id] = i;
+	}
+
+	std::vector<size_t> idom(order.size(), unreachable);
+	auto intersect = [&idom](size_t a, size_t b) {
+		while (a != b) {
+			while (a < b) {
+				a = idom[a];
+			}
+			while (b < a) {
+				b = idom[b];
+			}
+		}
+		return a;
+	};
+
+	for (size_t i = order.size(); i-- > 0;) {
+		const Line* line = order[i];
+		size_t dominator = line->is_output ? sink : unreachable;
+		for (const Gate* gate : line->destination_gates) {
+			size_t successor = line_to_index[gate->get_output()->id];
+			if (idom[successor] == unreachable) {
+				continue;
+			}
+			dominator = dominator == unreachable ? successor : intersect(dominator, successor);
+		}
+		idom[i] = dominator;
+	}
+
+	std::vector<const Line*> result(circuit.line_id_end(), nullptr);
+	for (size_t i = 0; i < order.size(); ++i) {
+		if (idom[i] != unreachable && idom[i] != sink) {
+			result[order[i]->id] = order[idom[i]];
+		}
+	}
+	return result;
+}
+
 Line* CircuitGraph::add_input(const std::string& name)
 {
 	Line* p_line = ensure_line(name);
@@ -257,6 +432,59 @@ std::string CircuitGraph::get_graph_stats() const
 	return ss.str();
 }
 
+void CircuitGraph::set_gate_expansion(GateExpansion expansion)
+{
+	// Arrival level of every line, primary inputs are on level 0
+	std::vector<size_t> levels(line_id_end(), 0);
+	for (const Gate* gate : make_topological_order(*this)) {
+		size_t level = 0;
+		for (const Line* input : gate->get_inputs()) {
+			level = std::max(level, levels[input->id]);
+		}
+		levels[gate->get_output()->id] = level + 1;
+	}
+
+	std::vector<size_t> input_levels;
+	for (Gate& gate : m_gates) {
+		input_levels.clear();
+		for (const Line* input : gate.get_inputs()) {
+			input_levels.push_back(levels[input->id]);
+		}
+		gate.set_expansion(expansion, input_levels);
+	}
+}
+
+// FNV-1a
+static void hash_combine(uint64_t& hash, const std::string& str)
+{
+	for (char c : str) {
+		hash ^= static_cast<uint8_t>(c);
+		hash *= 0x100000001b3ull;
+	}
+	hash ^= 0xff;
+	hash *= 0x100000001b3ull;
+}
+
+uint64_t CircuitGraph::get_hash() const
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+
+	for (const Line* input : m_inputs) {
+		hash_combine(hash, input->name);
+	}
+	for (const Line* output : m_outputs) {
+		hash_combine(hash, output->name);
+	}
+	for (const Gate& gate : m_gates) {
+		hash_combine(hash, make_gate_name(gate.get_type()));
+		hash_combine(hash, gate.get_output()->name);
+		for (const Line* input : gate.get_inputs()) {
+			hash_combine(hash, input->name);
+		}
+	}
+	return hash;
+}
+
 Line* CircuitGraph::ensure_line(const std::string& name)
 {
 	auto it = m_name_to_line.find(name);
@@ -5,6 +5,7 @@
 #include <limits>
 #include <vector>
 #include <deque>
+#include <memory>
 #include <set>
 #include <unordered_map>
 #include <cassert>
@@ -13,7 +14,12 @@
 #include "util/log.h"
 
 class Gate;
-class CircuitGraph;
+
+// Orders gates by id, so walks over destination gates don't depend on where gates were allocated
+struct GateIdLess
+{
+	bool operator()(const Gate* a, const Gate* b) const;
+};
 
 struct Line
 {
@@ -54,7 +60,7 @@ struct Line
 		}
 	};
 	std::vector<Connection> destinations;
-	std::set<Gate*> destination_gates;
+	std::set<Gate*, GateIdLess> destination_gates;
 
 	bool is_output = false;
 	bool is_generated = false;
@@ -80,6 +86,14 @@ private:
 	size_t m_line_id = 0;
 };
 
+// Shape of the two-input gates an AND/OR gate with more than two inputs is expanded into
+enum class GateExpansion
+{
+	Chain, // in[0] goes to the top gate, the last two inputs to the bottom one, n - 1 levels
+	Balanced, // neighbouring inputs are paired level by level, log2(n) levels
+	Level, // two inputs with the lowest arrival level are paired first, so late inputs are close to the output
+};
+
 class Gate
 {
 public:
@@ -100,6 +114,7 @@ public:
 	Gate(IdMaker& id_maker, Type type, Line* output, std::vector<Line*>&& inputs);
 
 	Gate(const Gate&) = delete;
+	~Gate();
 
 	Type get_type() const { return m_type; }
 	Type& type() { return m_type; }
@@ -108,6 +123,12 @@ public:
 	std::vector<Line*>& inputs() { return m_inputs; }
 
 	const std::vector<Gate*>& get_expanded() const;
+	// Index of the gate input connected to input (0 or 1) of get_expanded()[expanded_idx],
+	// std::numeric_limits<size_t>::max() if it's a line made by the expansion
+	size_t get_expanded_input_idx(size_t expanded_idx, size_t input) const;
+	// Rebuilds the expansion, input_levels (arrival level of every input) are used by GateExpansion::Level
+	void set_expansion(GateExpansion expansion, const std::vector<size_t>& input_levels);
+
 	std::string get_str() const;
 
 	Line* get_output() const { return m_output; }
@@ -126,10 +147,16 @@ private:
 
 	std::vector<Gate*> m_expanded_gate_ptrs;
 
-	std::deque<Gate> m_expanded_gate;
-	std::deque<Line> m_expanded_lines;
+	// Gates and lines of the expansion, only gates with more than two inputs have it
+	struct Expansion;
+	std::unique_ptr<Expansion> m_expansion;
 };
 
+inline bool GateIdLess::operator()(const Gate* a, const Gate* b) const
+{
+	return a->get_id() < b->get_id();
+}
+
 template<typename Func>
 void walk_gates_breadth_first(const std::vector<const Gate*>& from, Func func, bool toward_outputs = true, bool expand_gates = false)
 {
@@ -178,6 +205,19 @@ void walk_gates_breadth_first(const std::vector<const Gate*>& from, Func func, b
 	}
 }
 
+// Gate type as written in .bench files, e.g. "NAND"
+const char* make_gate_name(Gate::Type type);
+
+class CircuitGraph;
+
+// Gates (without expansion) ordered so that each gate goes after the gates driving its inputs
+std::vector<const Gate*> make_topological_order(const CircuitGraph& circuit);
+
+// Immediate post-dominator of every line (by line id) toward primary outputs:
+// the closest line that all paths from the line to primary outputs go through.
+// nullptr if there is no such line (paths end at different outputs) or the line doesn't reach any output.
+std::vector<const Line*> make_immediate_post_dominators(const CircuitGraph& circuit);
+
 class CircuitGraph : public IdMaker
 {
 public:
@@ -198,6 +238,12 @@ public:
 
 	std::string get_graph_stats() const;
 
+	// Gates are expanded into chains when added, this rebuilds the expansion of every wide gate
+	void set_gate_expansion(GateExpansion expansion);
+
+	// Structural hash of the circuit, stays the same between runs on the same netlist
+	uint64_t get_hash() const;
+
 private:
 	Line* ensure_line(const std::string& name);
 
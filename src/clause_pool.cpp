@@ -0,0 +1,72 @@
+#include "clause_pool.h"
+
+#include <cassert>
+
+constexpr size_t ClausePool::max_clause_size;
+
+ClausePool::ClausePool(size_t capacity)
+	: m_capacity(capacity)
+	, m_slots(new Slot[capacity])
+	, m_next(0)
+{
+	assert(capacity);
+	for (size_t i = 0; i < capacity; ++i) {
+		m_slots[i].sequence.store(0, std::memory_order_relaxed);
+	}
+}
+
+void ClausePool::add(const clause_t& clause, size_t source_id)
+{
+	if (clause.empty() || clause.size() > max_clause_size) {
+		return;
+	}
+
+	uint64_t index = m_next.fetch_add(1, std::memory_order_relaxed);
+	Slot& slot = m_slots[index % m_capacity];
+
+	// Slot is claimed only if it holds an older complete clause
+	uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+	if ((sequence & 1) || sequence > 2 * index
+		|| !slot.sequence.compare_exchange_strong(sequence, 2 * index + 1, std::memory_order_acquire)) {
+		return;
+	}
+
+	slot.source_id.store(source_id, std::memory_order_relaxed);
+	slot.size.store(clause.size(), std::memory_order_relaxed);
+	for (size_t i = 0; i < clause.size(); ++i) {
+		slot.literals[i].store(clause[i], std::memory_order_relaxed);
+	}
+	slot.sequence.store(2 * index + 2, std::memory_order_release);
+}
+
+uint64_t ClausePool::collect(uint64_t position, size_t source_id, std::vector<clause_t>& clauses) const
+{
+	uint64_t end = m_next.load(std::memory_order_acquire);
+	if (end - position > m_capacity) {
+		position = end - m_capacity;
+	}
+
+	clause_t clause;
+	for (; position < end; ++position) {
+		const Slot& slot = m_slots[position % m_capacity];
+		uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+		if (sequence == 2 * position + 1) {
+			// Still being written, continue from here next time
+			break;
+		}
+		if (sequence != 2 * position + 2 || slot.source_id.load(std::memory_order_relaxed) == source_id) {
+			continue;
+		}
+
+		clause.resize(slot.size.load(std::memory_order_relaxed));
+		for (size_t i = 0; i < clause.size(); ++i) {
+			clause[i] = slot.literals[i].load(std::memory_order_relaxed);
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == sequence) {
+			clauses.push_back(clause);
+		}
+	}
+	return position;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cnf.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Lock-free ring of short clauses shared between solver threads.
+// Every thread appends its clauses and reads clauses of others from its own position.
+// Sharing is best effort: a clause is dropped if its slot is being written by a lagging writer
+// and clauses that were overwritten before a reader got to them are skipped.
+class ClausePool
+{
+public:
+	static constexpr size_t max_clause_size = 8;
+
+	ClausePool(size_t capacity = 1 << 14);
+
+	// Clauses longer than max_clause_size are ignored
+	void add(const clause_t& clause, size_t source_id);
+
+	// Appends clauses of other sources added after position, returns position to continue from
+	uint64_t collect(uint64_t position, size_t source_id, std::vector<clause_t>& clauses) const;
+
+	uint64_t get_added_clauses() const { return m_next.load(std::memory_order_relaxed); }
+
+private:
+	struct Slot
+	{
+		// 2 * index + 1 while clause `index` is written, 2 * index + 2 when it is complete
+		std::atomic<uint64_t> sequence;
+		std::atomic<uint32_t> source_id;
+		std::atomic<uint32_t> size;
+		std::atomic<literal_t> literals[max_clause_size];
+	};
+
+	size_t m_capacity;
+	std::unique_ptr<Slot[]> m_slots;
+	std::atomic<uint64_t> m_next;
+};
@@ -0,0 +1,103 @@
+#include "cnf_cost_model.h"
+
+#include "circuit_to_cnf.h"
+
+#include <algorithm>
+
+constexpr size_t CnfCostModel::exploration_interval;
+
+CnfCostModel::CnfCostModel(const CircuitGraph& circuit, bool expand_gates)
+	: m_output_clauses(circuit.line_id_end(), 0)
+	, m_has_output_clauses(circuit.line_id_end(), 0)
+{
+	for (const Gate& gate : circuit.get_gates()) {
+		size_t clauses = 0;
+		if (!expand_gates) {
+			clauses = CircuitToCnfTransformer::make_clauses(gate).size();
+		} else {
+			for (const Gate* expanded_gate : gate.get_expanded()) {
+				clauses += CircuitToCnfTransformer::make_clauses(*expanded_gate).size();
+			}
+		}
+		if (gate.get_id() >= m_gate_clauses.size()) {
+			m_gate_clauses.resize(gate.get_id() + 1, 0);
+		}
+		m_gate_clauses[gate.get_id()] = clauses;
+		m_full_clauses += clauses;
+	}
+}
+
+bool CnfCostModel::choose_partial(const std::set<const Line*>& outputs)
+{
+	m_last_max = 0;
+	m_last_sum = 0;
+	for (const Line* output : outputs) {
+		size_t clauses = get_output_clauses(output);
+		m_last_max = std::max(m_last_max, clauses);
+		m_last_sum += clauses;
+	}
+
+	double partial_clauses = m_last_max + get_overlap_factor() * (m_last_sum - m_last_max);
+	partial_clauses = std::min<double>(partial_clauses, m_full_clauses);
+
+	// Both kinds are sampled first, so the cost of the kind that looks worse is measured too
+	++m_choices;
+	if (!m_partial.count) {
+		return true;
+	}
+	if (!m_full.count) {
+		return false;
+	}
+
+	double partial_cost = m_partial.clauses ? double(m_partial.time_us) / m_partial.clauses : 1;
+	double full_cost = m_full.clauses ? double(m_full.time_us) / m_full.clauses : 1;
+	bool is_partial = partial_clauses * partial_cost < m_full_clauses * full_cost;
+	// Costs change during the run (e.g. learned clauses), the other kind is sampled again now and then
+	if (m_choices % exploration_interval == 0) {
+		return !is_partial;
+	}
+	return is_partial;
+}
+
+void CnfCostModel::add_cnf(bool is_partial, size_t clauses, uint64_t time_us)
+{
+	m_last = is_partial ? &m_partial : &m_full;
+	++m_last->count;
+	m_last->clauses += clauses;
+	m_last->time_us += time_us;
+
+	if (is_partial && m_last_sum > m_last_max) {
+		m_overlap_clauses += clauses - std::min(clauses, m_last_max);
+		m_overlap_estimate += m_last_sum - m_last_max;
+	}
+}
+
+void CnfCostModel::add_solve_time(uint64_t time_us)
+{
+	if (m_last) {
+		m_last->time_us += time_us;
+	}
+}
+
+double CnfCostModel::get_overlap_factor() const
+{
+	if (!m_overlap_estimate) {
+		return 0.5;
+	}
+	return std::min(1.0, double(m_overlap_clauses) / m_overlap_estimate);
+}
+
+size_t CnfCostModel::get_output_clauses(const Line* output)
+{
+	if (!m_has_output_clauses[output->id]) {
+		size_t clauses = 0;
+		if (output->source) {
+			walk_gates_breadth_first({output->source}, [this, &clauses](const Gate* gate) {
+				clauses += m_gate_clauses[gate->get_id()];
+			}, false);
+		}
+		m_output_clauses[output->id] = clauses;
+		m_has_output_clauses[output->id] = 1;
+	}
+	return m_output_clauses[output->id];
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "circuit_graph.h"
+
+#include <cstdint>
+#include <set>
+#include <vector>
+
+// Chooses between partial CNF (fanin cones of primary outputs reached by the fault) and full circuit CNF.
+// Clause count of the fanin cone of every output is computed once, clauses shared by cones of several
+// outputs are accounted by an overlap factor learned from partial CNFs actually made.
+// Cost of a clause (making the CNF and solving it) is learned separately for both kinds of CNF.
+// Both kinds are made once before the model is used, and every exploration_interval-th choice
+// takes the kind the model doesn't prefer, so neither cost is left unmeasured.
+class CnfCostModel
+{
+public:
+	static constexpr size_t exploration_interval = 64;
+
+	// Gates are counted as encoded, expanded into two-input gates or with clauses over all inputs
+	CnfCostModel(const CircuitGraph& circuit, bool expand_gates = true);
+
+	// Returns true if partial CNF of these outputs is estimated to be cheaper than full CNF
+	bool choose_partial(const std::set<const Line*>& outputs);
+
+	// Statistics of the CNF made after the last choose_partial call
+	void add_cnf(bool is_partial, size_t clauses, uint64_t time_us);
+	void add_solve_time(uint64_t time_us);
+
+	size_t get_partial_count() const { return m_partial.count; }
+	size_t get_full_count() const { return m_full.count; }
+	size_t get_full_clauses() const { return m_full_clauses; }
+	double get_overlap_factor() const;
+
+private:
+	struct Statistics
+	{
+		size_t count = 0;
+		uint64_t clauses = 0;
+		uint64_t time_us = 0;
+	};
+
+	size_t get_output_clauses(const Line* output);
+
+	std::vector<size_t> m_gate_clauses; // by gate id, expanded gates included if gates are expanded
+	std::vector<size_t> m_output_clauses; // by line id, computed on first use
+	std::vector<uint8_t> m_has_output_clauses;
+	size_t m_full_clauses = 0;
+
+	// Sum of clauses of the largest cone and of all cones for the last choice
+	size_t m_last_max = 0;
+	size_t m_last_sum = 0;
+
+	// Partial clauses beyond the largest cone and their estimate without overlap, for the overlap factor
+	uint64_t m_overlap_clauses = 0;
+	uint64_t m_overlap_estimate = 0;
+
+	size_t m_choices = 0;
+	Statistics m_partial;
+	Statistics m_full;
+	Statistics* m_last = nullptr;
+};
@@ -0,0 +1,108 @@
+#include "cube_solver.h"
+
+#include "circuit_to_cnf.h"
+#include "incremental_solver.h"
+
+#include "util/trace.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+constexpr size_t CubeSolver::max_depth;
+
+CubeSolver::CubeSolver(const CircuitGraph& circuit, size_t thread_count, size_t depth)
+	: m_circuit(circuit)
+	, m_thread_count(std::max<size_t>(thread_count, 1))
+	, m_depth(std::min(depth, max_depth))
+{}
+
+std::vector<const Line*> CubeSolver::select_split_lines(const Fault& fault) const
+{
+	std::vector<const Line*> lines;
+	if (fault.line->source) {
+		walk_gates_breadth_first({fault.line->source}, [&lines](const Gate* gate) {
+			for (const Line* input : gate->get_inputs()) {
+				lines.push_back(input);
+			}
+		}, false);
+	}
+
+	std::sort(lines.begin(), lines.end(), [](const Line* a, const Line* b) {
+		if (a->destinations.size() != b->destinations.size()) {
+			return a->destinations.size() > b->destinations.size();
+		}
+		return a->id < b->id;
+	});
+	lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+	lines.erase(std::remove(lines.begin(), lines.end(), fault.line), lines.end());
+
+	if (lines.size() > m_depth) {
+		lines.resize(m_depth);
+	}
+	return lines;
+}
+
+SatSolver::SolveStatus CubeSolver::solve(const Cnf& cnf, const Fault& fault)
+{
+	std::vector<const Line*> split_lines = select_split_lines(fault);
+	size_t cube_count = size_t(1) << split_lines.size();
+
+	std::atomic<size_t> next_cube(0);
+	std::atomic<bool> stop(false);
+	std::mutex mutex;
+	bool has_unknown = false;
+	bool is_sat = false;
+	m_pattern.clear();
+
+	// Cube threads run at the same time, every one needs its own timeline row
+	auto thread_main = [&](size_t thread_index) {
+		TRACE_THREAD_NAME("cube solver " + std::to_string(thread_index));
+		(void)thread_index;
+		std::unique_ptr<SatSolver> solver = SolverFactory::make_solver();
+		if (!solver) {
+			std::lock_guard<std::mutex> lock(mutex);
+			has_unknown = true;
+			return;
+		}
+		solver->set_terminate_flag(&stop);
+		solver->set_conflict_limit(m_conflict_limit);
+		for (const clause_t& clause : cnf.get_clauses()) {
+			solver->add_clause(clause);
+		}
+
+		for (size_t cube = next_cube++; cube < cube_count && !stop; cube = next_cube++) {
+			for (size_t i = 0; i < split_lines.size(); ++i) {
+				literal_t lit = line_to_literal(split_lines[i]->id);
+				solver->assume((cube >> i) & 1 ? lit : -lit);
+			}
+			SatSolver::SolveStatus status = solver->solve_prepared();
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (status == SatSolver::Unknown) {
+				// Either stopped because other cube is satisfiable or solver gave up
+				has_unknown = true;
+				continue;
+			}
+			++m_solved_cubes;
+			if (status == SatSolver::Sat && !is_sat) {
+				is_sat = true;
+				m_pattern = make_pattern(*solver, m_circuit);
+				stop = true;
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < std::min(m_thread_count, cube_count); ++i) {
+		threads.emplace_back(thread_main, i);
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	if (is_sat) {
+		return SatSolver::Sat;
+	}
+	return has_unknown ? SatSolver::Unknown : SatSolver::Unsat;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "cnf.h"
+#include "fault_cnf.h"
+#include "sat/sat_solver.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Cube-and-conquer for hard faults: values of 2^depth combinations of splitting lines from the fanin cone
+// of the fault site are solved as assumptions in parallel threads. Fault is detectable as soon as one cube
+// is satisfiable and undetectable when all cubes are unsatisfiable.
+class CubeSolver
+{
+public:
+	// Every cube gets the whole conflict limit, so deeper splits don't finish in practice
+	static constexpr size_t max_depth = 20;
+
+	// Depth is limited to max_depth
+	CubeSolver(const CircuitGraph& circuit, size_t thread_count, size_t depth);
+
+	// Every cube gives up with Unknown after this many conflicts, negative means no limit
+	void set_conflict_limit(int64_t conflicts) { m_conflict_limit = conflicts; }
+
+	// Lines with most fanouts in the fanin cone of the fault site, fault line itself is excluded
+	std::vector<const Line*> select_split_lines(const Fault& fault) const;
+
+	SatSolver::SolveStatus solve(const Cnf& cnf, const Fault& fault);
+
+	// Test pattern from the satisfiable cube
+	const std::string& get_pattern() const { return m_pattern; }
+
+	size_t get_solved_cubes() const { return m_solved_cubes; }
+
+private:
+	const CircuitGraph& m_circuit;
+	size_t m_thread_count;
+	size_t m_depth;
+	int64_t m_conflict_limit = -1;
+
+	std::string m_pattern;
+	size_t m_solved_cubes = 0;
+};
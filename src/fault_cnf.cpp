@@ -1,13 +1,19 @@
 #include "fault_cnf.h"
 
+#include "implication.h"
+
 #include "util/log.h"
+#include "util/timer.h"
+#include "util/trace.h"
 
+#include <algorithm>
 #include <unordered_set>
 #include <cassert>
 #include <sstream>
 
 FanoutConeInfo make_fanout_cone(const Fault& fault)
 {
+	TRACE_SCOPE("cone build");
 	FanoutConeInfo fanout_cone;
 	fanout_cone.lines_inside.insert(fault.line);
 
@@ -54,16 +60,66 @@ FanoutConeInfo make_fanout_cone(const Fault& fault)
 	return fanout_cone;
 }
 
+UniqueSensitization make_unique_sensitization(const Fault& fault, const FanoutConeInfo& fanout_cone, const std::vector<const Line*>& post_dominators)
+{
+	UniqueSensitization sensitization;
+
+	// Branch fault can only propagate through its gate
+	const Line* dominator = nullptr;
+	if (fault.is_stem) {
+		dominator = post_dominators[fault.line->id];
+	} else if (!fault.is_primary_output) {
+		dominator = fault.connection.gate->get_output();
+	}
+
+	for (; dominator; dominator = post_dominators[dominator->id]) {
+		sensitization.dominators.push_back(dominator);
+
+		const Gate* gate = dominator->source;
+		int8_t controlling;
+		int8_t inversion;
+		if (!get_controlling_value(gate->get_type(), controlling, inversion)) {
+			continue;
+		}
+
+		// Value of side input outside of fault cone is the same in faulty circuit and must not block the fault
+		const std::vector<Line*>& inputs = gate->get_inputs();
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			bool is_side_input = !fanout_cone.lines_inside.count(inputs[i]);
+			if (inputs[i] == fault.line && !fault.is_stem) {
+				is_side_input = gate != fault.connection.gate || i != fault.connection.input_idx;
+			}
+			if (is_side_input) {
+				sensitization.side_inputs.emplace_back(inputs[i], !controlling);
+			}
+		}
+	}
+	return sensitization;
+}
+
 void FaultCnfMaker::make_fault(Fault fault, ICnf& cnf)
 {
+	TRACE_SCOPE("encode");
 	cnf.clear();
 	m_context.init(m_circuit, fault);
 
-	size_t output_size_threshold = m_circuit.get_outputs().size() * m_threshold_ratio;
-
 	FanoutConeInfo fanout_cone = make_fanout_cone(m_context.fault);
+	m_last_info.cone_lines = fanout_cone.lines_inside.size();
+	m_last_info.cone_outputs = fanout_cone.primary_outputs_inside.size();
+
+	bool use_partial = false;
+	if (m_cost_model) {
+		use_partial = m_cost_model->choose_partial(fanout_cone.primary_outputs_inside);
+	} else {
+		size_t output_size_threshold = m_circuit.get_outputs().size() * m_threshold_ratio;
+		use_partial = fanout_cone.primary_outputs_inside.size() < output_size_threshold;
+	}
 
-	if (fanout_cone.primary_outputs_inside.size() < output_size_threshold) {
+	m_last_info.is_partial = use_partial;
+
+	ElapsedTimer timer(true);
+	size_t circuit_clauses = 0;
+	if (use_partial) {
 		std::vector<const Gate*> out_gates;
 
 		out_gates.reserve(fanout_cone.primary_outputs_inside.size());
@@ -72,32 +128,128 @@ void FaultCnfMaker::make_fault(Fault fault, ICnf& cnf)
 				out_gates.push_back(l->source);
 		}
 
-		auto add_gate_to_cnf = [&cnf](const Gate* gate) {
+		std::vector<const Gate*> cnf_gates;
+		auto add_gate_to_cnf = [&cnf, &cnf_gates, &circuit_clauses](const Gate* gate) {
 			auto gate_clauses = CircuitToCnfTransformer::make_clauses(*gate);
 			cnf.add_clauses(gate_clauses);
+			cnf_gates.push_back(gate);
+			circuit_clauses += gate_clauses.size();
 		};
-		walk_gates_breadth_first(out_gates, add_gate_to_cnf, false, true);
+		walk_gates_breadth_first(out_gates, add_gate_to_cnf, false, m_gate_encoding == GateEncoding::Expanded);
+
+		if (!m_learned_clauses.empty()) {
+			add_learned_clauses(cnf, cnf_gates);
+		}
 	} else {
-		if (m_circuit_cnf.get_clauses().empty()) {
-			CircuitToCnfTransformer transfromer;
-			m_circuit_cnf = transfromer.make_cnf(m_circuit, true);
+		cnf = get_circuit_cnf();
+		circuit_clauses = m_circuit_cnf.get_clauses().size() - m_learned_clauses.size();
+	}
+
+	if (m_cost_model) {
+		m_cost_model->add_cnf(use_partial, circuit_clauses, timer.get_elapsed_us());
+	}
+
+	add_fault_clauses(cnf, fanout_cone);
+
+	m_context.reset();
+}
+
+void FaultCnfMaker::set_use_cost_model(bool use_cost_model)
+{
+	if (!use_cost_model) {
+		m_cost_model.reset();
+	} else if (!m_cost_model) {
+		m_cost_model.reset(new CnfCostModel(m_circuit, m_gate_encoding == GateEncoding::Expanded));
+	}
+}
+
+const Cnf& FaultCnfMaker::get_circuit_cnf()
+{
+	if (m_circuit_cnf.get_clauses().empty()) {
+		CircuitToCnfTransformer transfromer;
+		m_circuit_cnf = transfromer.make_cnf(m_circuit, m_gate_encoding == GateEncoding::Expanded);
+		for (const clause_t& clause : m_learned_clauses) {
+			m_circuit_cnf.add_clause(clause);
+		}
+	}
+	return m_circuit_cnf;
+}
+
+void FaultCnfMaker::set_learned_clauses(const std::vector<clause_t>& clauses)
+{
+	m_learned_clauses = clauses;
+	m_line_to_learned_clauses.assign(m_circuit.line_id_end(), {});
+	for (size_t i = 0; i < m_learned_clauses.size(); ++i) {
+		assert(!m_learned_clauses[i].empty());
+		m_line_to_learned_clauses[literal_to_line(m_learned_clauses[i].front())].push_back(i);
+	}
+	m_circuit_cnf.clear();
+}
+
+void FaultCnfMaker::add_learned_clauses(ICnf& cnf, const std::vector<const Gate*>& gates)
+{
+	m_line_in_cnf.assign(m_circuit.line_id_end(), 0);
+	std::vector<const Line*> lines;
+	auto add_line = [this, &lines](const Line* line) {
+		if (!m_line_in_cnf[line->id]) {
+			m_line_in_cnf[line->id] = 1;
+			lines.push_back(line);
+		}
+	};
+	for (const Gate* gate : gates) {
+		add_line(gate->get_output());
+		for (const Line* input : gate->get_inputs()) {
+			add_line(input);
 		}
-		cnf = m_circuit_cnf;
 	}
 
+	for (const Line* line : lines) {
+		for (size_t clause_idx : m_line_to_learned_clauses[line->id]) {
+			const clause_t& clause = m_learned_clauses[clause_idx];
+			bool all_in_cnf = std::all_of(clause.begin(), clause.end(), [this](literal_t l) {
+				return m_line_in_cnf[literal_to_line(l)];
+			});
+			if (all_in_cnf) {
+				cnf.add_clause(clause);
+			}
+		}
+	}
+}
+
+literal_t FaultCnfMaker::make_fault_clauses(Fault fault, ICnf& cnf, literal_t first_literal)
+{
+	TRACE_SCOPE("encode");
+	m_context.init(m_circuit, fault);
+	m_context.max_literal = std::max(m_context.max_literal, first_literal);
+
+	FanoutConeInfo fanout_cone = make_fanout_cone(m_context.fault);
+	m_last_info.cone_lines = fanout_cone.lines_inside.size();
+	m_last_info.cone_outputs = fanout_cone.primary_outputs_inside.size();
+	m_last_info.is_partial = false;
+	add_fault_clauses(cnf, fanout_cone);
+
+	literal_t next_literal = m_context.max_literal;
+	m_context.reset();
+	return next_literal;
+}
+
+void FaultCnfMaker::add_fault_clauses(ICnf& cnf, const FanoutConeInfo& fanout_cone)
+{
 	// Sensitization clause set
 	add_sensitization(cnf, fanout_cone);
 
 	// Fault activation clause set
 	add_fault_activation(cnf);
 
+	if (m_use_dominators) {
+		add_unique_sensitization(cnf, fanout_cone);
+	}
+
 	// Boundary scan clause set
 	add_boundary_scan(cnf, fanout_cone);
 
 	// Fault presentation clause set
 	add_fault_presentation(cnf, fanout_cone);
-
-	m_context.reset();
 }
 
 /*
@@ -199,49 +351,125 @@ void FaultCnfMaker::add_gate_sensitization(ICnf& cnf, const Gate& gate, bool use
 
 void FaultCnfMaker::add_gate_sensitization_with_expansion(ICnf& cnf, const Line::Connection& connection)
 {
-	size_t inputs_size = connection.gate->get_inputs().size();
-	for (size_t i = 0; i < connection.gate->get_expanded().size(); ++i) {
-		const Gate* expanded_gate = connection.gate->get_expanded()[i];
+	const Gate* gate = connection.gate;
+	for (size_t i = 0; i < gate->get_expanded().size(); ++i) {
+		const Gate* expanded_gate = gate->get_expanded()[i];
 		assert(expanded_gate->get_inputs().size() <= 2);
 
+		// The faulty connection is the leaf of the expansion with the same input index,
+		// other connections of the fault line see the fault free value
 		bool use_spec_x = false;
 		bool use_spec_y = false;
 
 		Line* line_x = expanded_gate->get_inputs().front();
 		if (line_x == m_context.fault.line) {
-			use_spec_x = m_context.fault.connection.gate != connection.gate;
-			if (!use_spec_x) {
-				size_t inp_idx = inputs_size > 1 ? inputs_size - 2 - i : 0;
-				use_spec_x = m_context.fault.connection.input_idx != inp_idx;
-			}
+			use_spec_x = m_context.fault.connection.gate != gate
+				|| m_context.fault.connection.input_idx != gate->get_expanded_input_idx(i, 0);
 		}
 
 		Line* line_y = expanded_gate->get_inputs().size() < 2 ? nullptr : expanded_gate->get_inputs().back();
 		if (line_y == m_context.fault.line) {
-			use_spec_y = m_context.fault.connection.gate != connection.gate;
-			if (!use_spec_y) {
-				assert(inputs_size >= 2);
-				size_t inp_idx = inputs_size - 2 - i + 1;
-				use_spec_y = m_context.fault.connection.input_idx != inp_idx;
-			}
+			use_spec_y = m_context.fault.connection.gate != gate
+				|| m_context.fault.connection.input_idx != gate->get_expanded_input_idx(i, 1);
 		}
 
 		add_gate_sensitization(cnf, *expanded_gate, use_spec_x, use_spec_y);
 	}
 }
 
+/*
+	Sensitization constraints for z = (N)AND(x_1, ..., x_n) without expansion, OR gates are the same with
+	inverted input and output values. z is the good value of AND before inversion.
+	- If any input is 0 and not sensitized, z_s = 0.
+	- If no input is sensitized, z_s = 0.
+	- If z = 0 (so every 0 input is sensitized), a sensitized input with value 1 blocks the fault: z_s = 0.
+	- If z = 1 and any input is sensitized, all faulty inputs are 0: z_s = 1.
+	- If z = 0 and every input differs from its sensitization variable (0 inputs are sensitized,
+	1 inputs are not), all faulty inputs are 1: z_s = 1. The last clause needs a new variable
+	e_i -> (x_i == x_i_s) for every input that can be sensitized.
+	Inputs outside of the fanout cone are never sensitized, so most clauses of them are satisfied and skipped.
+*/
+void FaultCnfMaker::add_nary_gate_sensitization(ICnf& cnf, const Gate& gate, const FanoutConeInfo& fanout_cone)
+{
+	bool is_or = false;
+	bool is_inverted = false;
+	switch (gate.get_type()) {
+		case Gate::Type::And:
+			break;
+		case Gate::Type::Nand:
+			is_inverted = true;
+			break;
+		case Gate::Type::Or:
+			is_or = true;
+			is_inverted = true;
+			break;
+		case Gate::Type::Nor:
+			is_or = true;
+			break;
+		default:
+			assert(false);
+			break;
+	}
+
+	const Fault& fault = m_context.fault;
+	literal_t z = (is_inverted ? -1 : 1) * get_lit(gate.get_output());
+	literal_t z_s = get_sensitization_lit(gate.get_output());
+
+	clause_t any_sensitized = {-z_s};
+	clause_t all_flipped = {z_s, z};
+	const std::vector<Line*>& inputs = gate.get_inputs();
+	for (size_t i = 0; i < inputs.size(); ++i) {
+		const Line* input = inputs[i];
+		literal_t x = (is_or ? -1 : 1) * get_lit(input);
+
+		literal_t x_s = 0;
+		if (input == fault.line && (fault.connection.gate != &gate || fault.connection.input_idx != i)) {
+			if (!fanout_cone.boundary_lines.count(input)) {
+				x_s = m_context.get_spec_lit();
+			}
+		} else if (fanout_cone.lines_inside.count(input)) {
+			x_s = get_sensitization_lit(input);
+		}
+
+		if (!x_s) {
+			cnf.add_clause(x, -z_s);
+			all_flipped.push_back(-x);
+			continue;
+		}
+
+		literal_t e = m_context.make_new_lit();
+		cnf.add_clause( x,  x_s,     -z_s);
+		cnf.add_clause(-x, -x_s,  z, -z_s);
+		cnf.add_clause(    -x_s, -z,  z_s);
+		cnf.add_clause( x, -x_s, -e);
+		cnf.add_clause(-x,  x_s, -e);
+		any_sensitized.push_back(x_s);
+		all_flipped.push_back(e);
+	}
+	cnf.add_clause(any_sensitized);
+	cnf.add_clause(all_flipped);
+}
+
 void FaultCnfMaker::add_sensitization(ICnf& cnf, const FanoutConeInfo& fanout_cone)
 {
 	assert(m_context.valid());
 	// Make sensitization variables for each gate
 	// in fanout cone of fault site
-	// Use gate expansion to sensitize gates with input n > 2
+	// Use gate expansion or n-ary clauses to sensitize gates with input n > 2
+	auto add_gate = [this, &cnf, &fanout_cone](const Line::Connection& connection) {
+		const Gate& gate = *connection.gate;
+		if (m_gate_encoding == GateEncoding::Nary && gate.get_inputs().size() > 2) {
+			add_nary_gate_sensitization(cnf, gate, fanout_cone);
+		} else {
+			add_gate_sensitization_with_expansion(cnf, connection);
+		}
+	};
 
 	IdObjectSet<const Gate*> sensitized_gates(m_circuit.gate_id_end());
 	if (!m_context.fault.is_stem && !m_context.fault.is_primary_output) {
 		assert(m_context.fault.connection.gate);
 		sensitized_gates.insert(m_context.fault.connection.gate);
-		add_gate_sensitization_with_expansion(cnf, m_context.fault.connection);
+		add_gate(m_context.fault.connection);
 	}
 
 	for (const Line* line : fanout_cone.lines_inside) {
@@ -253,7 +481,7 @@ void FaultCnfMaker::add_sensitization(ICnf& cnf, const FanoutConeInfo& fanout_co
 				continue;
 			}
 			sensitized_gates.insert(connection.gate);
-			add_gate_sensitization_with_expansion(cnf, connection);
+			add_gate(connection);
 		}
 	}
 }
@@ -266,6 +494,22 @@ void FaultCnfMaker::add_fault_activation(ICnf& cnf)
 	cnf.add_clause((f.stuck_at == 0 ? 1 : -1) * get_lit(f.line));
 }
 
+void FaultCnfMaker::add_unique_sensitization(ICnf& cnf, const FanoutConeInfo& fanout_cone)
+{
+	assert(m_context.valid());
+	if (m_post_dominators.empty()) {
+		m_post_dominators = make_immediate_post_dominators(m_circuit);
+	}
+
+	UniqueSensitization sensitization = make_unique_sensitization(m_context.fault, fanout_cone, m_post_dominators);
+	for (const Line* dominator : sensitization.dominators) {
+		cnf.add_clause(get_sensitization_lit(dominator));
+	}
+	for (const auto& side_input : sensitization.side_inputs) {
+		cnf.add_clause((side_input.second ? 1 : -1) * get_lit(side_input.first));
+	}
+}
+
 void FaultCnfMaker::add_boundary_scan(ICnf& cnf, const FanoutConeInfo& fanout_cone)
 {
 	assert(m_context.valid());
@@ -3,9 +3,12 @@
 #include "cnf.h"
 #include "circuit_graph.h"
 #include "circuit_to_cnf.h"
+#include "cnf_cost_model.h"
 
 #include "util/log.h"
 
+#include <memory>
+
 struct Fault
 {
 	Fault() = default;
@@ -45,29 +48,96 @@ struct FanoutConeInfo
 
 FanoutConeInfo make_fanout_cone(const Fault& fault);
 
+// Requirements that hold for every test of the fault
+struct UniqueSensitization
+{
+	std::vector<const Line*> dominators; // lines that all propagation paths go through, must be sensitized
+	std::vector<std::pair<const Line*, int8_t>> side_inputs; // good values of dominator side inputs outside the fault cone
+};
+
+// post_dominators are made by make_immediate_post_dominators
+UniqueSensitization make_unique_sensitization(const Fault& fault, const FanoutConeInfo& fanout_cone, const std::vector<const Line*>& post_dominators);
+
+// Describes the CNF made for the last fault
+struct FaultCnfInfo
+{
+	size_t cone_lines = 0; // lines in the fanout cone of the fault
+	size_t cone_outputs = 0; // primary outputs reached by the fault
+	bool is_partial = false; // only fanin cones of reached outputs instead of whole circuit
+};
+
+// How AND/OR gates with more than two inputs are encoded
+enum class GateEncoding
+{
+	Expanded, // chain of two-input gates (Gate::get_expanded), nine sensitization clauses per stage
+	Nary, // clauses over all inputs at once, no lines or variables for the chain
+};
+
 class FaultCnfMaker
 {
 public:
-	FaultCnfMaker(const CircuitGraph& circuit)
+	FaultCnfMaker(const CircuitGraph& circuit, GateEncoding gate_encoding = GateEncoding::Expanded)
 		: m_circuit(circuit)
+		, m_gate_encoding(gate_encoding)
 	{}
 
+	GateEncoding get_gate_encoding() const { return m_gate_encoding; }
+
+	// Full circuit CNF is used if the fault reaches at least this part of primary outputs
 	void set_threshold_ratio(float threshold_ratio)
 	{
 		m_threshold_ratio = threshold_ratio;
 	}
 
+	// Chooses between partial and full CNF by estimated cost instead of the threshold ratio
+	void set_use_cost_model(bool use_cost_model);
+	const CnfCostModel* get_cost_model() const { return m_cost_model.get(); }
+
+	// Solve time of the CNF made by the last make_fault call, cost model includes it in its estimates
+	void add_solve_time(uint64_t solve_time_us)
+	{
+		if (m_cost_model) {
+			m_cost_model->add_solve_time(solve_time_us);
+		}
+	}
+
+	// Adds unique sensitization clauses: every line that dominates the fault site toward primary outputs
+	// must be sensitized and its side inputs outside of the fault cone must have non-controlling values
+	void set_use_dominators(bool use_dominators)
+	{
+		m_use_dominators = use_dominators;
+	}
+
 	void make_fault(Fault fault, ICnf& cnf);
 	bool make_and_solve_fault(Fault fault);
 
+	// Adds only fault specific clauses for incremental solving, cnf should already contain full circuit clauses.
+	// New variables start from first_literal, returns first literal that is still unused
+	literal_t make_fault_clauses(Fault fault, ICnf& cnf, literal_t first_literal);
+
+	// CNF made by the last make_fault or make_fault_clauses call
+	const FaultCnfInfo& get_last_info() const { return m_last_info; }
+
+	// Clauses of the whole circuit in the gate encoding of the maker, built once and reused between faults
+	const Cnf& get_circuit_cnf();
+
+	// Clauses implied by the good circuit (e.g. from static learning) added to every fault CNF.
+	// CNF of a fault only gets clauses whose lines are all in it.
+	void set_learned_clauses(const std::vector<clause_t>& clauses);
+
 private:
+	void add_fault_clauses(ICnf& cnf, const FanoutConeInfo& fanout_cone);
+	void add_learned_clauses(ICnf& cnf, const std::vector<const Gate*>& gates);
+
 	void add_sensitization(ICnf& cnf, const FanoutConeInfo& fanout_cone);
 	void add_fault_activation(ICnf& cnf);
+	void add_unique_sensitization(ICnf& cnf, const FanoutConeInfo& fanout_cone);
 	void add_boundary_scan(ICnf& cnf, const FanoutConeInfo& fanout_cone);
 	void add_fault_presentation(ICnf& cnf, const FanoutConeInfo& fanout_cone);
 
 	void add_gate_sensitization(ICnf& cnf, const Gate& gate, bool use_spec_x, bool use_spec_y);
 	void add_gate_sensitization_with_expansion(ICnf& cnf, const Line::Connection& connection);
+	void add_nary_gate_sensitization(ICnf& cnf, const Gate& gate, const FanoutConeInfo& fanout_cone);
 
 	literal_t get_sensitization_lit(const Line* line);
 	literal_t get_lit(const Line* line);
@@ -124,6 +194,14 @@ private:
 
 	Context m_context;
 	const CircuitGraph& m_circuit;
+	GateEncoding m_gate_encoding;
 	Cnf m_circuit_cnf;
+	std::vector<clause_t> m_learned_clauses;
+	std::vector<std::vector<size_t>> m_line_to_learned_clauses; // by line of the first literal
+	std::vector<uint8_t> m_line_in_cnf;
+	std::vector<const Line*> m_post_dominators;
+	bool m_use_dominators = false;
 	double m_threshold_ratio = 0.6;
+	std::unique_ptr<CnfCostModel> m_cost_model;
+	FaultCnfInfo m_last_info;
 };
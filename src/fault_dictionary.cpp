@@ -0,0 +1,198 @@
+#include "fault_dictionary.h"
+
+#include "fault_simulator.h"
+
+#include "util/trace.h"
+
+#include <algorithm>
+#include <bitset>
+
+static size_t count_bits(uint64_t mask)
+{
+	return std::bitset<64>(mask).count();
+}
+
+void FaultDictionary::build(const CircuitGraph& circuit, const FaultManager& fault_manager, const std::vector<std::string>& patterns)
+{
+	TRACE_SCOPE("fault dictionary");
+	const size_t fault_count = fault_manager.get_fault_count();
+	m_pattern_count = patterns.size();
+	m_pattern_offsets.assign(1, 0);
+	m_pattern_blocks.clear();
+
+	FaultSimulator simulator(circuit);
+	std::vector<FaultSimulator::OutputMask> outputs;
+	for (size_t first = 0; first < patterns.size(); first += FaultSimulator::patterns_per_pass) {
+		simulator.load_patterns(patterns, first);
+		size_t begin = m_pattern_blocks.size();
+		for (size_t id = 0; id < fault_count; ++id) {
+			if (m_type == Type::PassFail) {
+				uint64_t mask = simulator.simulate_fault(fault_manager.get_fault(id));
+				if (mask) {
+					m_pattern_blocks.push_back({static_cast<uint32_t>(id), 0, mask});
+				}
+				continue;
+			}
+			simulator.simulate_fault(fault_manager.get_fault(id), outputs);
+			for (const FaultSimulator::OutputMask& output : outputs) {
+				m_pattern_blocks.push_back({static_cast<uint32_t>(id), static_cast<uint32_t>(output.output_idx), output.mask});
+			}
+		}
+		// Blocks were added in fault order, stable sort keeps it for every output
+		std::stable_sort(m_pattern_blocks.begin() + begin, m_pattern_blocks.end(),
+			[](const Block& a, const Block& b) { return a.output_idx < b.output_idx; });
+		m_pattern_offsets.push_back(m_pattern_blocks.size());
+	}
+
+	// Counting sort by fault, blocks of a fault stay ordered by pattern block and output
+	m_fault_offsets.assign(fault_count + 1, 0);
+	m_failure_counts.assign(fault_count, 0);
+	for (const Block& block : m_pattern_blocks) {
+		++m_fault_offsets[block.id + 1];
+		m_failure_counts[block.id] += count_bits(block.mask);
+	}
+	for (size_t id = 0; id < fault_count; ++id) {
+		m_fault_offsets[id + 1] += m_fault_offsets[id];
+	}
+	m_fault_blocks.resize(m_pattern_blocks.size());
+	std::vector<size_t> next(m_fault_offsets.begin(), m_fault_offsets.end() - 1);
+	for (size_t pattern_block = 0; pattern_block + 1 < m_pattern_offsets.size(); ++pattern_block) {
+		for (size_t i = m_pattern_offsets[pattern_block]; i < m_pattern_offsets[pattern_block + 1]; ++i) {
+			const Block& block = m_pattern_blocks[i];
+			m_fault_blocks[next[block.id]++] = {static_cast<uint32_t>(pattern_block), block.output_idx, block.mask};
+		}
+	}
+}
+
+size_t FaultDictionary::get_memory_bytes() const
+{
+	return (m_fault_blocks.size() + m_pattern_blocks.size()) * sizeof(Block)
+		+ (m_fault_offsets.size() + m_pattern_offsets.size() + m_failure_counts.size()) * sizeof(size_t);
+}
+
+std::pair<const FaultDictionary::Block*, const FaultDictionary::Block*> FaultDictionary::find_blocks(size_t fault_id, size_t pattern_block) const
+{
+	const Block* begin = m_fault_blocks.data() + m_fault_offsets.at(fault_id);
+	const Block* end = m_fault_blocks.data() + m_fault_offsets.at(fault_id + 1);
+	begin = std::lower_bound(begin, end, pattern_block, [](const Block& block, size_t id) { return block.id < id; });
+	end = std::upper_bound(begin, end, pattern_block, [](size_t id, const Block& block) { return id < block.id; });
+	return {begin, end};
+}
+
+bool FaultDictionary::is_detected(size_t fault_id, size_t pattern) const
+{
+	auto blocks = find_blocks(fault_id, pattern / FaultSimulator::patterns_per_pass);
+	uint64_t bit = 1ull << (pattern % FaultSimulator::patterns_per_pass);
+	for (const Block* block = blocks.first; block != blocks.second; ++block) {
+		if (block->mask & bit) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::vector<size_t> FaultDictionary::get_detecting_patterns(size_t fault_id) const
+{
+	std::vector<size_t> patterns;
+	const Block* end = m_fault_blocks.data() + m_fault_offsets.at(fault_id + 1);
+	for (const Block* block = m_fault_blocks.data() + m_fault_offsets.at(fault_id); block != end; ) {
+		// Union over outputs of the pattern block
+		uint32_t pattern_block = block->id;
+		uint64_t mask = 0;
+		for (; block != end && block->id == pattern_block; ++block) {
+			mask |= block->mask;
+		}
+		for (size_t bit = 0; bit < FaultSimulator::patterns_per_pass; ++bit) {
+			if ((mask >> bit) & 1) {
+				patterns.push_back(pattern_block * FaultSimulator::patterns_per_pass + bit);
+			}
+		}
+	}
+	return patterns;
+}
+
+std::vector<size_t> FaultDictionary::get_failing_outputs(size_t fault_id, size_t pattern) const
+{
+	std::vector<size_t> outputs;
+	if (m_type == Type::PassFail) {
+		return outputs;
+	}
+	auto blocks = find_blocks(fault_id, pattern / FaultSimulator::patterns_per_pass);
+	uint64_t bit = 1ull << (pattern % FaultSimulator::patterns_per_pass);
+	for (const Block* block = blocks.first; block != blocks.second; ++block) {
+		if (block->mask & bit) {
+			outputs.push_back(block->output_idx);
+		}
+	}
+	return outputs;
+}
+
+std::vector<FaultDictionary::Candidate> FaultDictionary::diagnose(const std::vector<Failure>& observed, size_t max_candidates) const
+{
+	TRACE_SCOPE("diagnosis");
+	auto block_less = [](const Block& a, const Block& b) { return a.id < b.id || (a.id == b.id && a.output_idx < b.output_idx); };
+
+	// Observed failures in the same blocks, duplicates are merged
+	std::vector<Block> observed_blocks;
+	for (const Failure& failure : observed) {
+		uint32_t output_idx = m_type == Type::PassFail ? 0 : static_cast<uint32_t>(failure.output_idx);
+		observed_blocks.push_back({static_cast<uint32_t>(failure.pattern / FaultSimulator::patterns_per_pass), output_idx,
+			1ull << (failure.pattern % FaultSimulator::patterns_per_pass)});
+	}
+	std::sort(observed_blocks.begin(), observed_blocks.end(), block_less);
+	size_t merged = 0;
+	for (size_t i = 0; i < observed_blocks.size(); ++i) {
+		if (merged && !block_less(observed_blocks[merged - 1], observed_blocks[i])) {
+			observed_blocks[merged - 1].mask |= observed_blocks[i].mask;
+		} else {
+			observed_blocks[merged++] = observed_blocks[i];
+		}
+	}
+	observed_blocks.resize(merged);
+
+	size_t observed_count = 0;
+	std::vector<size_t> matches(get_fault_count(), 0);
+	std::vector<size_t> matched_faults;
+	for (const Block& failures : observed_blocks) {
+		observed_count += count_bits(failures.mask);
+		if (failures.id + 1 >= m_pattern_offsets.size()) {
+			continue;
+		}
+		const Block* begin = m_pattern_blocks.data() + m_pattern_offsets[failures.id];
+		const Block* end = m_pattern_blocks.data() + m_pattern_offsets[failures.id + 1];
+		auto range = std::equal_range(begin, end, failures,
+			[](const Block& a, const Block& b) { return a.output_idx < b.output_idx; });
+		for (const Block* block = range.first; block != range.second; ++block) {
+			size_t common = count_bits(block->mask & failures.mask);
+			if (!common) {
+				continue;
+			}
+			if (!matches[block->id]) {
+				matched_faults.push_back(block->id);
+			}
+			matches[block->id] += common;
+		}
+	}
+
+	std::vector<Candidate> candidates;
+	candidates.reserve(matched_faults.size());
+	for (size_t fault_id : matched_faults) {
+		size_t matched = matches[fault_id];
+		candidates.push_back({fault_id, matched, m_failure_counts[fault_id] - matched, observed_count - matched});
+	}
+	auto is_better = [](const Candidate& a, const Candidate& b) {
+		size_t a_errors = a.mispredictions + a.nonpredictions;
+		size_t b_errors = b.mispredictions + b.nonpredictions;
+		if (a_errors != b_errors) {
+			return a_errors < b_errors;
+		}
+		if (a.matches != b.matches) {
+			return a.matches > b.matches;
+		}
+		return a.fault_id < b.fault_id;
+	};
+	size_t count = std::min(max_candidates, candidates.size());
+	std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), is_better);
+	candidates.resize(count);
+	return candidates;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "fault_manager.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Fault dictionary for diagnosis: which patterns detect which faults and, in a full response dictionary,
+// at which primary outputs. Every pattern is simulated against every fault without fault dropping.
+// Results are kept as a sparse bit matrix of 64-pattern blocks (one per pass of the simulator),
+// only non-zero blocks are stored. Blocks are sorted by fault for lookups and by pattern block
+// and output for diagnosis, which only visits faults that explain some observed failure.
+class FaultDictionary
+{
+public:
+	enum class Type
+	{
+		PassFail, // patterns detecting a fault
+		FullResponse, // patterns and outputs detecting a fault
+	};
+
+	// Failing pattern, and output for a full response dictionary
+	struct Failure
+	{
+		size_t pattern;
+		size_t output_idx; // index in CircuitGraph::get_outputs(), ignored for pass/fail
+	};
+
+	struct Candidate
+	{
+		size_t fault_id;
+		size_t matches; // observed failures predicted by the fault
+		size_t mispredictions; // predicted failures that were not observed
+		size_t nonpredictions; // observed failures the fault doesn't predict
+	};
+
+	FaultDictionary(Type type = Type::FullResponse)
+		: m_type(type)
+	{}
+
+	// Pattern has '0', '1' or 'X' for every circuit input
+	void build(const CircuitGraph& circuit, const FaultManager& fault_manager, const std::vector<std::string>& patterns);
+
+	Type get_type() const { return m_type; }
+	size_t get_fault_count() const { return m_fault_offsets.empty() ? 0 : m_fault_offsets.size() - 1; }
+	size_t get_pattern_count() const { return m_pattern_count; }
+	size_t get_block_count() const { return m_fault_blocks.size(); }
+	// Memory used by both block orders and their offsets
+	size_t get_memory_bytes() const;
+
+	bool is_detected(size_t fault_id, size_t pattern) const;
+	std::vector<size_t> get_detecting_patterns(size_t fault_id) const;
+	// Empty for pass/fail dictionary
+	std::vector<size_t> get_failing_outputs(size_t fault_id, size_t pattern) const;
+
+	// Faults ranked by how well they explain observed failures: fewest mispredictions plus nonpredictions first,
+	// then most matches. Only faults predicting at least one observed failure are candidates.
+	std::vector<Candidate> diagnose(const std::vector<Failure>& observed, size_t max_candidates) const;
+
+private:
+	struct Block
+	{
+		uint32_t id; // pattern block in fault order, fault in pattern block order
+		uint32_t output_idx;
+		uint64_t mask;
+	};
+
+	// Blocks of a fault with given pattern block
+	std::pair<const Block*, const Block*> find_blocks(size_t fault_id, size_t pattern_block) const;
+
+	Type m_type;
+	size_t m_pattern_count = 0;
+
+	std::vector<size_t> m_fault_offsets; // blocks of fault i are [m_fault_offsets[i], m_fault_offsets[i + 1])
+	std::vector<Block> m_fault_blocks; // sorted by pattern block, then output
+	std::vector<size_t> m_pattern_offsets; // same for pattern blocks
+	std::vector<Block> m_pattern_blocks; // sorted by output, then fault
+	std::vector<size_t> m_failure_counts; // predicted failures of every fault
+};
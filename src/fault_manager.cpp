@@ -1,11 +1,35 @@
 #include "fault_manager.h"
 
 #include "util/log.h"
+#include "util/trace.h"
 
 #include <algorithm>
 
+std::string get_fault_name(const Fault& fault)
+{
+	std::string name;
+	if (fault.is_stem || fault.is_primary_output) {
+		name = fault.line->name + "/O";
+	} else {
+		name = fault.connection.gate->get_output()->name + "/I" + std::to_string(fault.connection.input_idx + 1);
+	}
+	name += " S-A-";
+	name += std::to_string(fault.stuck_at);
+	return name;
+}
+
+std::string get_unique_fault_name(const Fault& fault)
+{
+	if (fault.is_primary_output && !fault.is_stem) {
+		return fault.line->name + "/PO S-A-" + std::to_string(fault.stuck_at);
+	}
+	return get_fault_name(fault);
+}
+
 FaultManager::FaultManager(const CircuitGraph& circuit)
+	: m_circuit(circuit)
 {
+	TRACE_SCOPE("fault generation");
 	for (const Line& line : circuit.get_lines()) {
 		// line needs two faults <=> line leads to output OR line gate has fanout >= 2
 		// Otherwise gate needs output determined by line destination
@@ -53,17 +77,98 @@ FaultManager::FaultManager(const CircuitGraph& circuit)
 		}
 
 	}
-	m_it = m_faults.begin();
+	m_skipped.resize(m_faults.size(), 0);
 }
 
 bool FaultManager::has_faults_left()
 {
-	return m_it != m_faults.end();
+	while (m_next < m_faults.size() && m_skipped[m_next]) {
+		++m_next;
+	}
+	return m_next < m_faults.size();
 }
 
 Fault FaultManager::next_fault()
 {
-	return *m_it++;
+	has_faults_left();
+	assert(m_next < m_faults.size());
+	m_current = m_next++;
+	return m_faults[m_current];
+}
+
+bool FaultManager::find_fault(const std::string& name, size_t& fault_id)
+{
+	if (m_name_to_fault.empty()) {
+		for (size_t id = 0; id < m_faults.size(); ++id) {
+			m_name_to_fault.emplace(get_unique_fault_name(m_faults[id]), id);
+		}
+	}
+
+	auto it = m_name_to_fault.find(name);
+	if (it == m_name_to_fault.end()) {
+		return false;
+	}
+	fault_id = it->second;
+	return true;
+}
+
+void FaultManager::skip_fault(size_t fault_id)
+{
+	assert(fault_id < m_skipped.size());
+	m_skipped[fault_id] = 1;
+}
+
+void FaultManager::select_shard(size_t index, size_t count, ShardMode mode)
+{
+	assert(count > 0);
+	assert(index < count);
+
+	if (mode == ShardMode::Interleaved) {
+		for (size_t id = 0; id < m_faults.size(); ++id) {
+			if (id % count != index) {
+				skip_fault(id);
+			}
+		}
+		return;
+	}
+
+	// Index of the first primary output in fanout of each line,
+	// faults with the same output share most of the encoded circuit
+	const size_t no_output = std::numeric_limits<size_t>::max();
+	std::vector<size_t> line_output(m_circuit.line_id_end(), no_output);
+	for (size_t i = 0; i < m_circuit.get_outputs().size(); ++i) {
+		size_t& output = line_output[m_circuit.get_outputs()[i]->id];
+		output = std::min(output, i);
+	}
+
+	std::vector<const Gate*> order = make_topological_order(m_circuit);
+	for (auto it = order.rbegin(); it != order.rend(); ++it) {
+		size_t output = line_output[(*it)->get_output()->id];
+		for (const Line* input : (*it)->get_inputs()) {
+			line_output[input->id] = std::min(line_output[input->id], output);
+		}
+	}
+
+	std::vector<size_t> fault_ids(m_faults.size());
+	std::vector<size_t> fault_keys(m_faults.size());
+	for (size_t id = 0; id < m_faults.size(); ++id) {
+		const Fault& f = m_faults[id];
+		bool is_branch = !f.is_stem && !f.is_primary_output;
+		fault_ids[id] = id;
+		fault_keys[id] = line_output[is_branch ? f.connection.gate->get_output()->id : f.line->id];
+	}
+
+	std::stable_sort(fault_ids.begin(), fault_ids.end(), [&fault_keys](size_t a, size_t b) {
+		return fault_keys[a] < fault_keys[b];
+	});
+
+	size_t begin = m_faults.size() * index / count;
+	size_t end = m_faults.size() * (index + 1) / count;
+	for (size_t i = 0; i < fault_ids.size(); ++i) {
+		if (i < begin || i >= end) {
+			skip_fault(fault_ids[i]);
+		}
+	}
 }
 
 void FaultManager::add_stem_fault(const Line& line)
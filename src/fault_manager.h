@@ -3,20 +3,57 @@
 #include "circuit_graph.h"
 #include "fault_cnf.h"
 
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+// Fault names look like "<line>/O S-A-1" for stem and primary output faults
+// and "<gate output>/I<input number> S-A-1" for fanout branch faults, input numbers start at 1
+std::string get_fault_name(const Fault& fault);
+
+// Same as get_fault_name, except "<line>/PO S-A-1" for a primary output fault of a line with fanout,
+// which otherwise has the name of the stem fault of the line
+std::string get_unique_fault_name(const Fault& fault);
+
 class FaultManager
 {
 public:
+	enum class ShardMode
+	{
+		Interleaved, // fault i goes to shard i % count
+		Cone, // faults sorted by output cone they are observed in and split in contiguous ranges
+	};
+
 	FaultManager(const CircuitGraph& circuit);
 
 	bool has_faults_left();
 	Fault next_fault();
 
+	// Id of the fault last returned by next_fault, ids are indices in generation order
+	size_t get_current_fault_id() const { return m_current; }
+
+	size_t get_fault_count() const { return m_faults.size(); }
+	const Fault& get_fault(size_t fault_id) const { return m_faults.at(fault_id); }
+
+	// Returns false if there is no fault with this get_unique_fault_name
+	bool find_fault(const std::string& name, size_t& fault_id);
+
+	// Fault will not be returned by next_fault, e.g. because it was classified in previous run
+	void skip_fault(size_t fault_id);
+	bool is_skipped(size_t fault_id) const { return m_skipped.at(fault_id); }
+
+	// Skips all faults not belonging to shard `index` out of `count`.
+	// Assignment depends only on the circuit, so shards in different processes don't overlap.
+	void select_shard(size_t index, size_t count, ShardMode mode);
+
 private:
 	void add_stem_fault(const Line& line);
 	void add_gate_input_fault(const Line& line, const Line::Connection& connection, bool is_stem);
 
+	const CircuitGraph& m_circuit;
 	std::vector<Fault> m_faults;
-	std::vector<Fault>::iterator m_it;
+	std::vector<uint8_t> m_skipped;
+	std::unordered_map<std::string, size_t> m_name_to_fault;
+	size_t m_next = 0;
+	size_t m_current = 0;
 };
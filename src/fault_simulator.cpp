@@ -0,0 +1,257 @@
+#include "fault_simulator.h"
+
+#include "util/trace.h"
+
+#include <algorithm>
+#include <cassert>
+
+constexpr size_t FaultSimulator::patterns_per_pass;
+
+using Value = FaultSimulator::Value;
+
+static Value make_constant(int8_t value, uint64_t mask)
+{
+	Value result;
+	if (value) {
+		result.one = mask;
+	} else {
+		result.zero = mask;
+	}
+	return result;
+}
+
+static uint64_t make_difference(const Value& good, const Value& faulty)
+{
+	return (good.one & faulty.zero) | (good.zero & faulty.one);
+}
+
+FaultSimulator::FaultSimulator(const CircuitGraph& circuit)
+	: m_circuit(circuit)
+	, m_order(make_topological_order(circuit))
+	, m_gate_level(circuit.gate_id_end(), 0)
+	, m_good(circuit.line_id_end())
+	, m_faulty(circuit.line_id_end())
+	, m_output_index(circuit.line_id_end(), 0)
+	, m_scheduled(circuit.gate_id_end(), 0)
+{
+	for (size_t i = 0; i < circuit.get_outputs().size(); ++i) {
+		m_output_index[circuit.get_outputs()[i]->id] = i;
+	}
+
+	size_t max_level = 0;
+	for (const Gate* gate : m_order) {
+		size_t level = 0;
+		for (const Line* input : gate->get_inputs()) {
+			if (input->source) {
+				level = std::max(level, m_gate_level[input->source->get_id()] + 1);
+			}
+		}
+		m_gate_level[gate->get_id()] = level;
+		max_level = std::max(max_level, level);
+	}
+	m_level_queue.resize(max_level + 1);
+}
+
+size_t FaultSimulator::load_patterns(const std::vector<std::string>& patterns, size_t first)
+{
+	TRACE_SCOPE("good simulation");
+	assert(first <= patterns.size());
+	size_t count = std::min(patterns_per_pass, patterns.size() - first);
+	m_pattern_mask = count == patterns_per_pass ? ~0ull : ((1ull << count) - 1);
+
+	const auto& inputs = m_circuit.get_inputs();
+	for (const Line* input : inputs) {
+		m_good[input->id] = {};
+	}
+
+	for (size_t p = 0; p < count; ++p) {
+		const std::string& pattern = patterns[first + p];
+		assert(pattern.size() == inputs.size());
+		uint64_t bit = 1ull << p;
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			if (pattern[i] == '1') {
+				m_good[inputs[i]->id].one |= bit;
+			} else if (pattern[i] == '0') {
+				m_good[inputs[i]->id].zero |= bit;
+			}
+		}
+	}
+
+	for (const Gate* gate : m_order) {
+		m_good[gate->get_output()->id] = evaluate(*gate, m_good, nullptr);
+	}
+
+	m_faulty = m_good;
+	return count;
+}
+
+Value FaultSimulator::evaluate(const Gate& gate, const std::vector<Value>& values, const Fault* fault) const
+{
+	const std::vector<Line*>& inputs = gate.get_inputs();
+
+	auto input_value = [&](size_t idx) {
+		if (fault && fault->connection.gate == &gate && fault->connection.input_idx == idx) {
+			return make_constant(fault->stuck_at, m_pattern_mask);
+		}
+		return values[inputs[idx]->id];
+	};
+
+	Value result;
+	switch (gate.get_type()) {
+		case Gate::Type::Buff:
+			//[[fallthrough]];
+		case Gate::Type::Not:
+			result = input_value(0);
+			break;
+		case Gate::Type::And:
+			//[[fallthrough]];
+		case Gate::Type::Nand:
+			result.one = m_pattern_mask;
+			for (size_t i = 0; i < inputs.size(); ++i) {
+				Value v = input_value(i);
+				result.one &= v.one;
+				result.zero |= v.zero;
+			}
+			break;
+		case Gate::Type::Or:
+			//[[fallthrough]];
+		case Gate::Type::Nor:
+			result.zero = m_pattern_mask;
+			for (size_t i = 0; i < inputs.size(); ++i) {
+				Value v = input_value(i);
+				result.one |= v.one;
+				result.zero &= v.zero;
+			}
+			break;
+		case Gate::Type::Xor:
+			//[[fallthrough]];
+		case Gate::Type::Xnor: {
+			Value a = input_value(0);
+			Value b = input_value(1);
+			result.one = (a.one & b.zero) | (a.zero & b.one);
+			result.zero = (a.one & b.one) | (a.zero & b.zero);
+			break;
+		}
+		default:
+			assert(false);
+			break;
+	}
+
+	switch (gate.get_type()) {
+		case Gate::Type::Not:
+			//[[fallthrough]];
+		case Gate::Type::Nand:
+			//[[fallthrough]];
+		case Gate::Type::Nor:
+			//[[fallthrough]];
+		case Gate::Type::Xnor:
+			std::swap(result.one, result.zero);
+			break;
+		default:
+			break;
+	}
+	return result;
+}
+
+void FaultSimulator::schedule(const Gate* gate)
+{
+	if (m_scheduled[gate->get_id()]) {
+		return;
+	}
+	m_scheduled[gate->get_id()] = 1;
+	++m_scheduled_count;
+	m_level_queue[m_gate_level[gate->get_id()]].push_back(gate);
+}
+
+uint64_t FaultSimulator::simulate_fault(const Fault& fault)
+{
+	return simulate(fault, nullptr);
+}
+
+uint64_t FaultSimulator::simulate_fault(const Fault& fault, std::vector<OutputMask>& outputs)
+{
+	outputs.clear();
+	uint64_t detected = simulate(fault, &outputs);
+	std::sort(outputs.begin(), outputs.end(), [](const OutputMask& a, const OutputMask& b) { return a.output_idx < b.output_idx; });
+	return detected;
+}
+
+uint64_t FaultSimulator::observe(const Line* line, const Value& faulty, std::vector<OutputMask>* outputs) const
+{
+	uint64_t difference = make_difference(m_good[line->id], faulty);
+	if (outputs && difference) {
+		outputs->push_back({m_output_index[line->id], difference});
+	}
+	return difference;
+}
+
+uint64_t FaultSimulator::simulate(const Fault& fault, std::vector<OutputMask>* outputs)
+{
+	TRACE_SCOPE("fault simulation");
+	assert(fault.line);
+	Value stuck_value = make_constant(fault.stuck_at, m_pattern_mask);
+
+	if (fault.is_primary_output) {
+		// Fault is only visible on primary output itself
+		return observe(fault.line, stuck_value, outputs);
+	}
+
+	uint64_t detected = 0;
+	size_t first_level = 0;
+	if (fault.is_stem) {
+		const Line* line = fault.line;
+		if (m_good[line->id] == stuck_value) {
+			return 0;
+		}
+		m_faulty[line->id] = stuck_value;
+		m_changed_lines.push_back(line);
+		if (line->is_output) {
+			detected |= observe(line, stuck_value, outputs);
+		}
+		for (const Gate* gate : line->destination_gates) {
+			schedule(gate);
+		}
+		first_level = line->source ? m_gate_level[line->source->get_id()] + 1 : 0;
+	} else {
+		assert(fault.connection.gate);
+		if (m_good[fault.line->id] == stuck_value) {
+			// Not activated by any pattern
+			return 0;
+		}
+		schedule(fault.connection.gate);
+		first_level = m_gate_level[fault.connection.gate->get_id()];
+	}
+
+	// Stops at the last level with events instead of circuit depth
+	for (size_t level = first_level; level < m_level_queue.size() && m_scheduled_count; ++level) {
+		auto& queue = m_level_queue[level];
+		for (size_t i = 0; i < queue.size(); ++i) {
+			const Gate* gate = queue[i];
+			m_scheduled[gate->get_id()] = 0;
+			--m_scheduled_count;
+
+			Value value = evaluate(*gate, m_faulty, &fault);
+			const Line* output = gate->get_output();
+			if (value == m_faulty[output->id]) {
+				continue;
+			}
+
+			m_faulty[output->id] = value;
+			m_changed_lines.push_back(output);
+			if (output->is_output) {
+				detected |= observe(output, value, outputs);
+			}
+			for (const Gate* dest : output->destination_gates) {
+				schedule(dest);
+			}
+		}
+		queue.clear();
+	}
+
+	for (const Line* line : m_changed_lines) {
+		m_faulty[line->id] = m_good[line->id];
+	}
+	m_changed_lines.clear();
+
+	return detected & m_pattern_mask;
+}
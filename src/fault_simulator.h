@@ -0,0 +1,68 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "fault_cnf.h"
+
+#include <string>
+#include <vector>
+
+// Three-valued parallel pattern single fault simulator.
+// Up to 64 patterns are simulated at once, each line value is kept as two bit masks:
+// bit set in `one` means line has value 1 for the pattern, bit set in `zero` - value 0, none - X.
+class FaultSimulator
+{
+public:
+	static constexpr size_t patterns_per_pass = 64;
+
+	struct Value
+	{
+		uint64_t one = 0;
+		uint64_t zero = 0;
+
+		bool operator==(const Value& other) const { return one == other.one && zero == other.zero; }
+		bool operator!=(const Value& other) const { return !operator==(other); }
+	};
+
+	// Patterns detecting a fault at one primary output
+	struct OutputMask
+	{
+		size_t output_idx; // index in CircuitGraph::get_outputs()
+		uint64_t mask;
+	};
+
+	FaultSimulator(const CircuitGraph& circuit);
+
+	// Loads patterns [first, first + patterns_per_pass) and simulates fault free circuit.
+	// Pattern is a string with '0', '1' or 'X' for each circuit input.
+	// Returns number of loaded patterns.
+	size_t load_patterns(const std::vector<std::string>& patterns, size_t first = 0);
+
+	// Bit mask of loaded patterns that detect the fault on at least one primary output
+	uint64_t simulate_fault(const Fault& fault);
+	// Same, also gives masks of all outputs the fault is observed at, ordered by output index
+	uint64_t simulate_fault(const Fault& fault, std::vector<OutputMask>& outputs);
+
+	const Value& get_value(const Line* line) const { return m_good[line->id]; }
+
+private:
+	uint64_t simulate(const Fault& fault, std::vector<OutputMask>* outputs);
+	// Patterns where faulty value of an output line differs from the good one
+	uint64_t observe(const Line* line, const Value& faulty, std::vector<OutputMask>* outputs) const;
+	Value evaluate(const Gate& gate, const std::vector<Value>& values, const Fault* fault) const;
+	void schedule(const Gate* gate);
+
+	const CircuitGraph& m_circuit;
+	std::vector<const Gate*> m_order;
+	std::vector<size_t> m_gate_level;
+
+	uint64_t m_pattern_mask = 0;
+
+	std::vector<Value> m_good;
+	std::vector<Value> m_faulty;
+	std::vector<size_t> m_output_index; // by line id
+
+	std::vector<std::vector<const Gate*>> m_level_queue;
+	std::vector<uint8_t> m_scheduled;
+	size_t m_scheduled_count = 0;
+	std::vector<const Line*> m_changed_lines;
+};
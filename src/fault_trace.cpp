@@ -0,0 +1,199 @@
+#include "fault_trace.h"
+
+#include "fault_manager.h"
+
+#include <algorithm>
+#include <limits>
+
+static void add_json_string(std::string& out, const std::string& str)
+{
+	out += '"';
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if (static_cast<unsigned char>(c) < 0x20) {
+			out += ' ';
+		} else {
+			out += c;
+		}
+	}
+	out += '"';
+}
+
+static void add_json_field(std::string& out, const char* name, const std::string& value)
+{
+	out += '"';
+	out += name;
+	out += "\": ";
+	add_json_string(out, value);
+}
+
+static void add_json_field(std::string& out, const char* name, uint64_t value)
+{
+	out += '"';
+	out += name;
+	out += "\": ";
+	out += std::to_string(value);
+}
+
+static const char* get_fault_type(const Fault& fault)
+{
+	if (fault.is_stem) {
+		return "stem";
+	}
+	return fault.is_primary_output ? "output" : "branch";
+}
+
+static const char* get_result_name(FaultStatus status)
+{
+	switch (status) {
+		case FaultStatus::Detectable:
+			return "detectable";
+		case FaultStatus::Undetectable:
+			return "undetectable";
+		default:
+			return "unknown";
+	}
+}
+
+static const char* get_engine(const WorkerResult& result, bool is_incremental)
+{
+	if (result.is_redundant_by_implications) {
+		return "implications";
+	}
+	if (result.used_portfolio) {
+		return "portfolio";
+	}
+	if (result.used_cubes) {
+		return "cubes";
+	}
+	return is_incremental ? "incremental" : "sat";
+}
+
+bool FaultTraceWriter::open(const std::string& path)
+{
+	return m_writer.open(path, false);
+}
+
+void FaultTraceWriter::write(const Fault& fault, const WorkerResult& result, bool is_incremental)
+{
+	const char* cnf = "none";
+	if (!result.is_redundant_by_implications) {
+		cnf = is_incremental ? "incremental" : (result.is_partial_cnf ? "partial" : "full");
+	}
+	const char* result_name = get_result_name(result.record.status);
+	const char* engine = get_engine(result, is_incremental);
+
+	m_line = "{";
+	add_json_field(m_line, "fault", get_fault_name(fault));
+	m_line += ", ";
+	add_json_field(m_line, "type", get_fault_type(fault));
+	m_line += ", ";
+	add_json_field(m_line, "stuck_at", fault.stuck_at);
+	m_line += ", ";
+	add_json_field(m_line, "cone_lines", result.cone_lines);
+	m_line += ", ";
+	add_json_field(m_line, "cnf", cnf);
+	m_line += ", ";
+	add_json_field(m_line, "clauses", result.clauses);
+	m_line += ", ";
+	add_json_field(m_line, "variables", result.variables);
+	m_line += ", ";
+	add_json_field(m_line, "encode_us", result.cnf_time_us);
+	m_line += ", ";
+	add_json_field(m_line, "solve_us", result.record.solve_time_us);
+	m_line += ", ";
+	add_json_field(m_line, "conflicts", result.conflicts);
+	m_line += ", ";
+	add_json_field(m_line, "result", result_name);
+	m_line += ", ";
+	add_json_field(m_line, "engine", engine);
+	m_line += "}\n";
+	m_writer.write(m_line);
+
+	++m_results[result_name];
+	++m_engines[engine];
+	m_encode_times.values.push_back(result.cnf_time_us);
+	m_solve_times.values.push_back(result.record.solve_time_us);
+	m_conflicts.values.push_back(result.conflicts);
+}
+
+void FaultTraceWriter::Values::add_json(std::string& out, const char* name)
+{
+	std::sort(values.begin(), values.end());
+	uint64_t total = 0;
+	for (uint64_t value : values) {
+		total += value;
+	}
+	auto percentile = [this](size_t percent) -> uint64_t {
+		if (values.empty()) {
+			return 0;
+		}
+		size_t rank = (values.size() * percent + 99) / 100;
+		return values[std::max<size_t>(rank, 1) - 1];
+	};
+
+	out += '"';
+	out += name;
+	out += "\": {";
+	add_json_field(out, "total", total);
+	out += ", ";
+	add_json_field(out, "p50", percentile(50));
+	out += ", ";
+	add_json_field(out, "p90", percentile(90));
+	out += ", ";
+	add_json_field(out, "p99", percentile(99));
+	out += ", ";
+	add_json_field(out, "max", values.empty() ? 0 : values.back());
+
+	// Bucket i counts values up to 2^i - 1, values are sorted so buckets are filled in order
+	out += ", \"histogram\": [";
+	size_t begin = 0;
+	for (size_t bucket = 0; begin < values.size(); ++bucket) {
+		uint64_t limit = bucket < 64 ? (uint64_t(1) << bucket) - 1 : std::numeric_limits<uint64_t>::max();
+		size_t end = std::upper_bound(values.begin() + begin, values.end(), limit) - values.begin();
+		if (bucket) {
+			out += ", ";
+		}
+		out += "{";
+		add_json_field(out, "max", limit);
+		out += ", ";
+		add_json_field(out, "count", end - begin);
+		out += "}";
+		begin = end;
+	}
+	out += "]}";
+}
+
+bool FaultTraceWriter::write_summary()
+{
+	auto add_counts = [this](const char* name, const std::map<std::string, size_t>& counts) {
+		m_line += '"';
+		m_line += name;
+		m_line += "\": {";
+		for (auto it = counts.begin(); it != counts.end(); ++it) {
+			if (it != counts.begin()) {
+				m_line += ", ";
+			}
+			add_json_field(m_line, it->first.c_str(), it->second);
+		}
+		m_line += "}";
+	};
+
+	m_line = "{\"summary\": {";
+	add_json_field(m_line, "faults", m_encode_times.values.size());
+	m_line += ", ";
+	add_counts("results", m_results);
+	m_line += ", ";
+	add_counts("engines", m_engines);
+	m_line += ", ";
+	m_encode_times.add_json(m_line, "encode_us");
+	m_line += ", ";
+	m_solve_times.add_json(m_line, "solve_us");
+	m_line += ", ";
+	m_conflicts.add_json(m_line, "conflicts");
+	m_line += "}}\n";
+	m_writer.write(m_line);
+	return m_writer.close();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "fault_cnf.h"
+#include "worker_pool.h"
+
+#include "util/buffered_writer.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Writes a JSON object per fault, one per line, and a summary object as the last line:
+// 	{"fault": "G5/O S-A-1", "type": "stem", "cone_lines": 12, "cnf": "partial", "clauses": 120, "variables": 40,
+// 	 "encode_us": 15, "solve_us": 30, "conflicts": 2, "result": "detectable", "engine": "sat"}
+// 	{"summary": {"faults": 1, "results": {...}, "engines": {...}, "encode_us": {...}, "solve_us": {...}, "conflicts": {...}}}
+// Summary has count, total, percentiles and a histogram with power of two bucket limits for every measured value.
+class FaultTraceWriter
+{
+public:
+	bool open(const std::string& path);
+
+	// engine is "incremental" for faults solved in the incremental solver, "cubes" for faults
+	// that went to cube-and-conquer, even if no cube was solved
+	void write(const Fault& fault, const WorkerResult& result, bool is_incremental);
+	// Writes the summary and closes the file, returns false if any write failed
+	bool write_summary();
+
+private:
+	struct Values
+	{
+		std::vector<uint64_t> values;
+		void add_json(std::string& out, const char* name);
+	};
+
+	BufferedWriter m_writer;
+	std::string m_line;
+
+	std::map<std::string, size_t> m_results;
+	std::map<std::string, size_t> m_engines;
+	Values m_encode_times;
+	Values m_solve_times;
+	Values m_conflicts;
+};
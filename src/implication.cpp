@@ -0,0 +1,179 @@
+#include "implication.h"
+
+constexpr int8_t ImplicationEngine::unknown;
+
+bool get_controlling_value(Gate::Type type, int8_t& controlling, int8_t& inversion)
+{
+	switch (type) {
+		case Gate::Type::And:
+			controlling = 0;
+			inversion = 0;
+			return true;
+		case Gate::Type::Nand:
+			controlling = 0;
+			inversion = 1;
+			return true;
+		case Gate::Type::Or:
+			controlling = 1;
+			inversion = 0;
+			return true;
+		case Gate::Type::Nor:
+			controlling = 1;
+			inversion = 1;
+			return true;
+		default:
+			return false;
+	}
+}
+
+ImplicationEngine::ImplicationEngine(const CircuitGraph& circuit)
+	: m_values(circuit.line_id_end(), unknown)
+{}
+
+bool ImplicationEngine::assign(const Line* line, int8_t value)
+{
+	if (!set_value(line, value)) {
+		return false;
+	}
+	return propagate();
+}
+
+void ImplicationEngine::backtrack(size_t trail_size)
+{
+	while (m_trail.size() > trail_size) {
+		m_values[m_trail.back().line->id] = unknown;
+		m_trail.pop_back();
+	}
+	m_queue_head = m_trail.size();
+}
+
+bool ImplicationEngine::is_unjustified(const Gate& gate) const
+{
+	int8_t controlling;
+	int8_t inversion;
+	if (!get_controlling_value(gate.get_type(), controlling, inversion)) {
+		return false;
+	}
+	if (get_value(gate.get_output()) != (controlling ^ inversion)) {
+		return false;
+	}
+	for (const Line* input : gate.get_inputs()) {
+		if (get_value(input) == controlling) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ImplicationEngine::set_value(const Line* line, int8_t value)
+{
+	int8_t& current = m_values[line->id];
+	if (current != unknown) {
+		return current == value;
+	}
+	current = value;
+	m_trail.push_back({line, value});
+	++m_assignment_count;
+	return true;
+}
+
+bool ImplicationEngine::propagate()
+{
+	while (m_queue_head < m_trail.size()) {
+		const Line* line = m_trail[m_queue_head++].line;
+		if (line->source && !imply(*line->source)) {
+			m_queue_head = m_trail.size();
+			return false;
+		}
+		for (const Gate* gate : line->destination_gates) {
+			if (!imply(*gate)) {
+				m_queue_head = m_trail.size();
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool ImplicationEngine::imply(const Gate& gate)
+{
+	const Line* output = gate.get_output();
+	const std::vector<Line*>& inputs = gate.get_inputs();
+
+	switch (gate.get_type()) {
+		case Gate::Type::Buff:
+			//[[fallthrough]];
+		case Gate::Type::Not:
+		{
+			int8_t inversion = gate.get_type() == Gate::Type::Not;
+			if (get_value(inputs.front()) != unknown) {
+				return set_value(output, get_value(inputs.front()) ^ inversion);
+			}
+			if (get_value(output) != unknown) {
+				return set_value(inputs.front(), get_value(output) ^ inversion);
+			}
+			return true;
+		}
+		case Gate::Type::Xor:
+			//[[fallthrough]];
+		case Gate::Type::Xnor:
+		{
+			int8_t parity = gate.get_type() == Gate::Type::Xnor;
+			const Line* unknown_input = nullptr;
+			size_t unknown_count = 0;
+			for (const Line* input : inputs) {
+				if (get_value(input) == unknown) {
+					unknown_input = input;
+					++unknown_count;
+				} else {
+					parity ^= get_value(input);
+				}
+			}
+			if (!unknown_count) {
+				return set_value(output, parity);
+			}
+			if (unknown_count == 1 && get_value(output) != unknown) {
+				return set_value(unknown_input, get_value(output) ^ parity);
+			}
+			return true;
+		}
+		default:
+			break;
+	}
+
+	int8_t controlling;
+	int8_t inversion;
+	if (!get_controlling_value(gate.get_type(), controlling, inversion)) {
+		assert(false);
+		return true;
+	}
+
+	const Line* unknown_input = nullptr;
+	size_t unknown_count = 0;
+	for (const Line* input : inputs) {
+		int8_t value = get_value(input);
+		if (value == controlling) {
+			return set_value(output, controlling ^ inversion);
+		}
+		if (value == unknown) {
+			unknown_input = input;
+			++unknown_count;
+		}
+	}
+
+	if (!unknown_count) {
+		return set_value(output, !controlling ^ inversion);
+	}
+
+	int8_t output_value = get_value(output);
+	if (output_value == (!controlling ^ inversion)) {
+		for (const Line* input : inputs) {
+			if (!set_value(input, !controlling)) {
+				return false;
+			}
+		}
+	} else if (output_value != unknown && unknown_count == 1) {
+		return set_value(unknown_input, controlling);
+	}
+	return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "circuit_graph.h"
+
+#include <vector>
+
+// For (N)AND and (N)OR gates: output is `controlling ^ inversion` if any input has controlling value.
+// Returns false for other gate types.
+bool get_controlling_value(Gate::Type type, int8_t& controlling, int8_t& inversion);
+
+// Three-valued direct implications on the circuit (without gate expansion).
+// Assignments are kept on a trail, so they can be undone to any earlier trail size.
+class ImplicationEngine
+{
+public:
+	static constexpr int8_t unknown = -1;
+
+	struct Assignment
+	{
+		const Line* line;
+		int8_t value;
+	};
+
+	ImplicationEngine(const CircuitGraph& circuit);
+
+	// Assigns value and propagates it forward and backward through gates.
+	// Returns false on conflict, assignments made before the conflict stay on the trail.
+	bool assign(const Line* line, int8_t value);
+
+	int8_t get_value(const Line* line) const { return m_values[line->id]; }
+
+	const std::vector<Assignment>& get_trail() const { return m_trail; }
+	size_t get_trail_size() const { return m_trail.size(); }
+	void backtrack(size_t trail_size);
+
+	// Gate output requires a controlling value on one of its inputs, but none of them is assigned yet
+	bool is_unjustified(const Gate& gate) const;
+
+	// Number of line assignments made since construction, used to limit work of callers
+	uint64_t get_assignment_count() const { return m_assignment_count; }
+
+private:
+	bool set_value(const Line* line, int8_t value);
+	bool propagate();
+	bool imply(const Gate& gate);
+
+	std::vector<int8_t> m_values;
+	std::vector<Assignment> m_trail;
+	size_t m_queue_head = 0;
+	uint64_t m_assignment_count = 0;
+};
@@ -0,0 +1,176 @@
+#include "incremental_solver.h"
+
+#include "circuit_to_cnf.h"
+
+#include "util/timer.h"
+
+#include <cassert>
+#include <cstdlib>
+
+std::string make_pattern(SatSolver& solver, const CircuitGraph& graph)
+{
+	std::string pattern;
+	pattern.reserve(graph.get_inputs().size());
+	for (const Line* l : graph.get_inputs()) {
+		int8_t val = solver.get_value(line_to_literal(l->id));
+		pattern += val == 0 ? 'X' : (val < 0 ? '0' : '1');
+	}
+	return pattern;
+}
+
+IncrementalFaultSolver::IncrementalFaultSolver(const CircuitGraph& circuit, std::unique_ptr<SatSolver> solver, GateEncoding gate_encoding)
+	: m_circuit(circuit)
+	, m_solver(std::move(solver))
+	, m_proxy(*m_solver)
+	, m_fault_cnf_maker(circuit, gate_encoding)
+	, m_exporter(*this)
+{
+	assert(m_solver);
+	m_proxy = m_fault_cnf_maker.get_circuit_cnf();
+	m_first_fault_literal = line_to_literal(circuit.line_id_end());
+	m_next_literal = m_first_fault_literal;
+}
+
+IncrementalFaultSolver::~IncrementalFaultSolver()
+{
+	m_solver->set_learned_clause_listener(nullptr);
+}
+
+void IncrementalFaultSolver::add_circuit_clauses(const std::vector<clause_t>& clauses)
+{
+	for (const clause_t& clause : clauses) {
+		m_solver->add_clause(clause);
+	}
+}
+
+SatSolver::SolveStatus IncrementalFaultSolver::solve(const Fault& fault, bool do_solve)
+{
+	ElapsedTimer timer(true);
+	import_clauses();
+
+	literal_t guard = m_next_literal++;
+
+	GuardedCnf guarded_cnf(m_proxy, guard);
+	m_next_literal = m_fault_cnf_maker.make_fault_clauses(fault, guarded_cnf, m_next_literal);
+	m_last_encode_time_us = timer.get_elapsed_us();
+
+	SatSolver::SolveStatus status = SatSolver::Unknown;
+	if (do_solve) {
+		m_solver->assume(guard);
+		status = m_solver->solve_prepared();
+	}
+
+	m_pattern.clear();
+	if (status == SatSolver::Sat) {
+		m_pattern = make_pattern(*m_solver, m_circuit);
+	}
+
+	m_solver->add_clause(-guard);
+	return status;
+}
+
+// Indices in CircuitGraph::get_inputs() of inputs in fanin cones of primary outputs reachable from the fault
+static std::vector<size_t> get_relevant_inputs(const CircuitGraph& circuit, const Fault& fault)
+{
+	std::vector<uint8_t> is_relevant(circuit.line_id_end(), 0);
+	std::vector<const Gate*> output_gates;
+	for (const Line* output : make_fanout_cone(fault).primary_outputs_inside) {
+		is_relevant[output->id] = 1;
+		if (output->source) {
+			output_gates.push_back(output->source);
+		}
+	}
+	walk_gates_breadth_first(output_gates, [&is_relevant](const Gate* gate) {
+		for (const Line* input : gate->get_inputs()) {
+			is_relevant[input->id] = 1;
+		}
+	}, false);
+
+	std::vector<size_t> relevant;
+	for (size_t i = 0; i < circuit.get_inputs().size(); ++i) {
+		if (is_relevant[circuit.get_inputs()[i]->id]) {
+			relevant.push_back(i);
+		}
+	}
+	return relevant;
+}
+
+SatSolver::SolveStatus IncrementalFaultSolver::solve_distinct(const Fault& fault, const std::vector<std::string>& blocked, size_t count,
+	std::vector<std::string>& patterns)
+{
+	import_clauses();
+
+	literal_t guard = m_next_literal++;
+
+	GuardedCnf guarded_cnf(m_proxy, guard);
+	m_next_literal = m_fault_cnf_maker.make_fault_clauses(fault, guarded_cnf, m_next_literal);
+
+	const std::vector<size_t> relevant = get_relevant_inputs(m_circuit, fault);
+	// False if the cube has no relevant input assigned, then it covers every test
+	auto block = [&](const std::string& pattern) {
+		clause_t clause;
+		for (size_t i : relevant) {
+			if (pattern[i] != 'X') {
+				literal_t lit = line_to_literal(m_circuit.get_inputs()[i]->id);
+				clause.push_back(pattern[i] == '1' ? -lit : lit);
+			}
+		}
+		if (clause.empty()) {
+			return false;
+		}
+		guarded_cnf.add_clause(clause);
+		return true;
+	};
+
+	SatSolver::SolveStatus status = SatSolver::Sat;
+	for (const std::string& pattern : blocked) {
+		if (!block(pattern)) {
+			status = SatSolver::Unsat;
+		}
+	}
+	for (size_t found = 0; found < count && status == SatSolver::Sat; ++found) {
+		m_solver->assume(guard);
+		status = m_solver->solve_prepared();
+		if (status == SatSolver::Sat) {
+			patterns.push_back(make_pattern(*m_solver, m_circuit));
+			if (!block(patterns.back()) && found + 1 < count) {
+				status = SatSolver::Unsat;
+			}
+		}
+	}
+
+	m_solver->add_clause(-guard);
+	return status;
+}
+
+void IncrementalFaultSolver::share_clauses(ClausePool& pool, size_t source_id)
+{
+	m_clause_pool = &pool;
+	m_source_id = source_id;
+	m_pool_position = pool.get_added_clauses();
+	m_solver->set_learned_clause_listener(&m_exporter);
+}
+
+void IncrementalFaultSolver::import_clauses()
+{
+	if (!m_clause_pool) {
+		return;
+	}
+	m_imported.clear();
+	m_pool_position = m_clause_pool->collect(m_pool_position, m_source_id, m_imported);
+	for (const clause_t& clause : m_imported) {
+		m_solver->add_clause(clause);
+	}
+	m_imported_clauses += m_imported.size();
+}
+
+void IncrementalFaultSolver::ClauseExporter::on_learned_clause(const clause_t& clause)
+{
+	for (literal_t l : clause) {
+		if (std::abs(l) >= m_solver.m_first_fault_literal) {
+			return;
+		}
+	}
+	m_solver.m_clause_pool->add(clause, m_solver.m_source_id);
+	++m_solver.m_exported_clauses;
+}
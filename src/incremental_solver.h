@@ -0,0 +1,87 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "clause_pool.h"
+#include "fault_cnf.h"
+#include "solver_proxy.h"
+#include "sat/sat_solver.h"
+
+#include <memory>
+#include <string>
+
+// Test pattern from solver model: '0', '1' or 'X' (not constrained) for each circuit input
+std::string make_pattern(SatSolver& solver, const CircuitGraph& graph);
+
+// Keeps whole circuit CNF loaded in one solver and checks faults one after another.
+// Fault clauses are guarded by a fresh literal that is assumed during solving and disabled afterwards,
+// so clauses learned on the good circuit are kept between faults.
+class IncrementalFaultSolver
+{
+public:
+	IncrementalFaultSolver(const CircuitGraph& circuit, std::unique_ptr<SatSolver> solver, GateEncoding gate_encoding = GateEncoding::Expanded);
+	~IncrementalFaultSolver();
+
+	// Clauses implied by the good circuit, e.g. from static learning
+	void add_circuit_clauses(const std::vector<clause_t>& clauses);
+
+	// With do_solve false fault clauses are only encoded and Unknown is returned
+	SatSolver::SolveStatus solve(const Fault& fault, bool do_solve = true);
+
+	// Test pattern found by the last successful solve
+	const std::string& get_pattern() const { return m_pattern; }
+	// Time the last solve() spent importing shared clauses and encoding the fault
+	uint64_t get_last_encode_time_us() const { return m_last_encode_time_us; }
+
+	// Finds up to count tests of the fault in one incremental session. Every test differs from the blocked patterns
+	// and from the tests found before it on at least one relevant input (in fanin cones of outputs the fault reaches),
+	// since other inputs can't change whether the fault is detected. Blocking clauses are guarded like fault clauses.
+	// Returns Sat if all count tests were found, Unsat if there are no more distinct tests.
+	SatSolver::SolveStatus solve_distinct(const Fault& fault, const std::vector<std::string>& blocked, size_t count,
+		std::vector<std::string>& patterns);
+
+	SatSolver& get_solver() { return *m_solver; }
+	FaultCnfMaker& get_fault_cnf_maker() { return m_fault_cnf_maker; }
+
+	// Learned clauses over good circuit variables only don't depend on any fault clause
+	// (those contain a guard literal), so they are exported to the pool and valid for every solver.
+	// Clauses of other solvers are imported before every fault.
+	void share_clauses(ClausePool& pool, size_t source_id);
+
+	size_t get_exported_clauses() const { return m_exported_clauses; }
+	size_t get_imported_clauses() const { return m_imported_clauses; }
+
+private:
+	class ClauseExporter : public LearnedClauseListener
+	{
+	public:
+		ClauseExporter(IncrementalFaultSolver& solver)
+			: m_solver(solver)
+		{}
+
+		size_t get_max_clause_size() const override { return ClausePool::max_clause_size; }
+		void on_learned_clause(const clause_t& clause) override;
+
+	private:
+		IncrementalFaultSolver& m_solver;
+	};
+
+	void import_clauses();
+
+	const CircuitGraph& m_circuit;
+	std::unique_ptr<SatSolver> m_solver;
+	ProxyCnf m_proxy;
+	FaultCnfMaker m_fault_cnf_maker;
+
+	literal_t m_first_fault_literal = 0;
+	literal_t m_next_literal = 0;
+	std::string m_pattern;
+	uint64_t m_last_encode_time_us = 0;
+
+	ClausePool* m_clause_pool = nullptr;
+	size_t m_source_id = 0;
+	uint64_t m_pool_position = 0;
+	ClauseExporter m_exporter;
+	std::vector<clause_t> m_imported;
+	size_t m_exported_clauses = 0;
+	size_t m_imported_clauses = 0;
+};
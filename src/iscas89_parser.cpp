@@ -1,6 +1,7 @@
 #include "iscas89_parser.h"
 
 #include "util/log.h"
+#include "util/trace.h"
 
 #include <algorithm>
 #include <string>
@@ -97,6 +98,7 @@ bool Iscas89Parser::match_gate(CircuitGraph& graph, const std::string& line)
 
 bool Iscas89Parser::parse(std::istream& is, CircuitGraph& graph)
 {
+	TRACE_SCOPE("parse");
 	static const std::regex comment_regex(R"r(\s*#.*\r?)r");
 	static const std::regex empty_regex(R"r(\s+)r");
 	size_t line_ctr = 0;
@@ -0,0 +1,153 @@
+#include "journal.h"
+
+#include "util/log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include <unistd.h>
+
+static const char* const journal_magic = "# sat_atpg journal";
+
+bool read_journal(std::istream& is, JournalHeader& header, std::vector<FaultRecord>& records)
+{
+	std::string line;
+	if (!std::getline(is, line) || line.compare(0, std::string(journal_magic).size(), journal_magic) != 0) {
+		log_error() << "Not a journal file";
+		return false;
+	}
+
+	std::stringstream header_ss(line.substr(std::string(journal_magic).size()));
+	if (!(header_ss >> std::hex >> header.circuit_hash >> std::dec >> header.fault_count)) {
+		log_error() << "Invalid journal header:" << line;
+		return false;
+	}
+
+	while (std::getline(is, line)) {
+		if (is.eof()) {
+			// Line without '\n' was interrupted while writing
+			break;
+		}
+
+		std::stringstream ss(line);
+		FaultRecord record;
+		char status = 0;
+		if (!(ss >> record.fault_id >> status >> record.solve_time_us >> record.pattern)) {
+			log_warning() << "Skipping invalid journal record:" << line;
+			continue;
+		}
+		if (record.fault_id >= header.fault_count) {
+			log_warning() << "Skipping journal record with invalid fault id:" << line;
+			continue;
+		}
+
+		record.status = static_cast<FaultStatus>(status);
+		if (record.status != FaultStatus::Detectable && record.status != FaultStatus::Undetectable) {
+			record.status = FaultStatus::Unknown;
+		}
+		if (record.pattern == "-") {
+			record.pattern.clear();
+		}
+		records.push_back(record);
+	}
+	return true;
+}
+
+// Size of the file without an unterminated last line
+static std::streamoff get_complete_size(std::ifstream& ifs)
+{
+	ifs.seekg(0, std::ios::end);
+	std::streamoff end = ifs.tellg();
+	char chunk[4096];
+	for (std::streamoff chunk_end = end; chunk_end > 0; ) {
+		std::streamoff chunk_begin = std::max<std::streamoff>(0, chunk_end - sizeof(chunk));
+		ifs.seekg(chunk_begin);
+		if (!ifs.read(chunk, chunk_end - chunk_begin)) {
+			return end;
+		}
+		for (std::streamoff i = chunk_end - chunk_begin; i > 0; --i) {
+			if (chunk[i - 1] == '\n') {
+				return chunk_begin + i;
+			}
+		}
+		chunk_end = chunk_begin;
+	}
+	return 0;
+}
+
+bool JournalWriter::open(const std::string& path)
+{
+	m_path = path;
+	m_reported_failure = false;
+
+	std::streamoff size = 0;
+	std::streamoff complete_size = 0;
+	{
+		std::ifstream ifs(path, std::ios::binary);
+		if (ifs.good()) {
+			ifs.seekg(0, std::ios::end);
+			size = ifs.tellg();
+			complete_size = size > 0 ? get_complete_size(ifs) : 0;
+		}
+	}
+
+	if (complete_size != size) {
+		log_warning() << "Removing interrupted last record of journal" << path;
+		if (truncate(path.c_str(), complete_size) != 0) {
+			log_error() << "can't truncate journal" << path + ":" << std::strerror(errno);
+			return false;
+		}
+	}
+
+	if (!m_writer.open(path)) {
+		log_error() << "can't open journal" << path;
+		return false;
+	}
+
+	if (complete_size == 0) {
+		std::stringstream ss;
+		ss << journal_magic << " " << std::hex << m_header.circuit_hash << std::dec << " " << m_header.fault_count << "\n";
+		m_writer.write(ss.str());
+		m_writer.flush();
+	}
+	return check_writer();
+}
+
+bool JournalWriter::write(const FaultRecord& record)
+{
+	m_line.clear();
+	m_line += std::to_string(record.fault_id);
+	m_line += ' ';
+	m_line += static_cast<char>(record.status);
+	m_line += ' ';
+	m_line += std::to_string(record.solve_time_us);
+	m_line += ' ';
+	m_line += record.pattern.empty() ? "-" : record.pattern;
+	m_line += '\n';
+	m_writer.write(m_line);
+	return check_writer();
+}
+
+bool JournalWriter::flush()
+{
+	m_writer.flush();
+	return check_writer();
+}
+
+bool JournalWriter::close()
+{
+	m_writer.close();
+	return check_writer();
+}
+
+bool JournalWriter::check_writer()
+{
+	if (m_writer.has_failed() && !m_reported_failure) {
+		log_error() << "can't write journal" << m_path << ", the run can't be fully resumed from it";
+		m_reported_failure = true;
+	}
+	return !m_writer.has_failed();
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "util/buffered_writer.h"
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+enum class FaultStatus: char
+{
+	Detectable = 'D',
+	Undetectable = 'U',
+	Unknown = 'A',
+};
+
+struct FaultRecord
+{
+	size_t fault_id = 0;
+	FaultStatus status = FaultStatus::Unknown;
+	uint64_t solve_time_us = 0;
+	std::string pattern; // one of '0', '1', 'X' per circuit input, empty if there is no test
+
+	bool is_classified() const { return status != FaultStatus::Unknown; }
+};
+
+struct JournalHeader
+{
+	uint64_t circuit_hash = 0;
+	size_t fault_count = 0;
+};
+
+// Journal is a text file with a header line followed by one line per processed fault:
+// 	# sat_atpg journal <circuit hash> <fault count>
+// 	<fault id> <status> <solve time us> <pattern or ->
+// Records are only appended, truncated last line (e.g. after a crash) is ignored on reading.
+bool read_journal(std::istream& is, JournalHeader& header, std::vector<FaultRecord>& records);
+
+class JournalWriter
+{
+public:
+	JournalWriter(const JournalHeader& header)
+		: m_header(header)
+	{}
+
+	// Opens journal for appending, header is written if the file is empty.
+	// Interrupted last record is cut off, so the next record doesn't continue it.
+	bool open(const std::string& path);
+
+	// Write errors are logged once, returns false if the journal is incomplete
+	bool write(const FaultRecord& record);
+	bool flush();
+	bool close();
+
+private:
+	bool check_writer();
+
+	JournalHeader m_header;
+	BufferedWriter m_writer;
+	std::string m_path;
+	std::string m_line;
+	bool m_reported_failure = false;
+};
@@ -5,9 +5,26 @@
 #include "fault_manager.h"
 #include "sat/sat_solver.h"
 #include "solver_proxy.h"
+#include "journal.h"
+#include "incremental_solver.h"
+#include "atpg_server.h"
+#include "worker_pool.h"
+#include "parallel_solver.h"
+#include "static_learning.h"
+#include "redundancy.h"
+#include "portfolio.h"
+#include "cube_solver.h"
+#include "tuning_config.h"
+#include "fault_trace.h"
+#include "pattern_io.h"
+#include "pattern_validator.h"
+#include "n_detect.h"
 
+#include "util/async_log.h"
 #include "util/log.h"
+#include "util/perf_counters.h"
 #include "util/timer.h"
+#include "util/trace.h"
 
 #include <fstream>
 #include <algorithm>
@@ -21,35 +38,331 @@ struct Config
 	bool write_detectability = 0;
 	bool do_solve = 1;
 	bool write_stats = 1;
+	bool async_log = false; // on by default when faults or solutions are written
 	bool short_stats = 0;
+	bool cost_model = true; // otherwise full CNF is used if the fault reaches threshold_ratio of outputs
 	float threshold_ratio = 0.6f;
+
+	std::string journal_path;
+	std::string trace_path;
+	std::string patterns_path;
+	std::string stil_path;
+	std::string timeline_path;
+	bool perf_counters = false;
+	bool validate = false; // fault simulate patterns of detected faults
+
+	bool daemon = false;
+	std::string socket_path;
+
+	bool use_dominators = false;
+	GateEncoding gate_encoding = GateEncoding::Expanded;
+	GateExpansion gate_expansion = GateExpansion::Chain;
+	bool use_implications = false;
+	bool static_learning = false;
+	bool recursive_learning = false;
+	uint64_t static_learning_max_assignments = 200000000;
+
+	// Faults not solved within hard_fault_budget conflicts go to portfolio or cube-and-conquer
+	int64_t hard_fault_budget = 10000;
+	size_t portfolio_size = 0;
+	size_t cube_threads = 0;
+	size_t cube_depth = 4;
+
+	// Every detectable fault gets n_detect different tests, extra tests use hard_fault_budget conflicts
+	size_t n_detect = 1;
+
+	std::vector<std::pair<std::string, int>> solver_options;
+
+	size_t process_count = 0;
+	size_t thread_count = 0;
+	bool incremental = false; // from --config, solve in one thread with incremental solver unless --threads is given
+	bool clause_sharing = true;
+
+	size_t shard_index = 0;
+	size_t shard_count = 0;
+	FaultManager::ShardMode shard_mode = FaultManager::ShardMode::Cone;
 } g_config;
 
-int main(int argc, char* argv[])
+bool parse_shard(const std::string& str)
 {
-	if (argc < 2) {
+	size_t slash = str.find('/');
+	if (slash == std::string::npos) {
+		return false;
+	}
+	try {
+		g_config.shard_index = std::stoul(str.substr(0, slash));
+		g_config.shard_count = std::stoul(str.substr(slash + 1));
+	} catch (const std::exception&) {
+		return false;
+	}
+	return g_config.shard_index < g_config.shard_count;
+}
+
+bool load_config(const std::string& path)
+{
+	std::ifstream ifs(path);
+	TuningConfig config;
+	if (!ifs.good() || !read_tuning_config(ifs, config)) {
+		log_error() << "can't read configuration" << path;
+		return false;
+	}
+	g_config.cost_model = config.cost_model;
+	g_config.threshold_ratio = config.threshold_ratio;
+	g_config.use_dominators = config.use_dominators;
+	g_config.static_learning = config.static_learning;
+	g_config.gate_encoding = config.nary_gates ? GateEncoding::Nary : GateEncoding::Expanded;
+	g_config.solver_options = config.solver_options;
+	g_config.incremental = config.incremental;
+	return true;
+}
+
+bool parse_args(int argc, char* argv[], std::string& circuit_path)
+{
+	// Configuration file is applied first, so options on the command line override it wherever they are
+	for (int i = 1; i + 1 < argc; ++i) {
+		if (std::string(argv[i]) == "--config" && !load_config(argv[++i])) {
+			return false;
+		}
+	}
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		if (arg == "--journal" && has_value) {
+			g_config.journal_path = argv[++i];
+		} else if (arg == "--config" && has_value) {
+			++i;
+		} else if (arg == "--cnf-threshold" && has_value) {
+			try {
+				g_config.threshold_ratio = std::stof(argv[++i]);
+				g_config.cost_model = false;
+			} catch (const std::exception&) {
+				log_error() << "invalid threshold ratio" << argv[i];
+				return false;
+			}
+		} else if (arg == "--patterns" && has_value) {
+			g_config.patterns_path = argv[++i];
+		} else if (arg == "--stil" && has_value) {
+			g_config.stil_path = argv[++i];
+		} else if (arg == "--trace-json" && has_value) {
+			g_config.trace_path = argv[++i];
+		} else if (arg == "--trace-timeline" && has_value) {
+#if ENABLE_TRACING
+			g_config.timeline_path = argv[++i];
+#else
+			log_error() << "--trace-timeline needs a build with -DENABLE_TRACING=ON";
+			return false;
+#endif
+		} else if (arg == "--write-faults") {
+			g_config.write_faults = true;
+		} else if (arg == "--write-solutions") {
+			g_config.write_solutions = true;
+		} else if (arg == "--async-log") {
+			g_config.async_log = true;
+		} else if (arg == "--perf-counters") {
+			g_config.perf_counters = true;
+		} else if (arg == "--validate") {
+			g_config.validate = true;
+		} else if (arg == "--daemon") {
+			g_config.daemon = true;
+		} else if (arg == "--socket" && has_value) {
+			g_config.daemon = true;
+			g_config.socket_path = argv[++i];
+		} else if (arg == "--fire") {
+			g_config.use_implications = true;
+		} else if (arg == "--dominators") {
+			g_config.use_dominators = true;
+		} else if (arg == "--nary-gates") {
+			g_config.gate_encoding = GateEncoding::Nary;
+		} else if (arg == "--gate-expansion" && has_value) {
+			std::string mode = argv[++i];
+			if (mode == "chain") {
+				g_config.gate_expansion = GateExpansion::Chain;
+			} else if (mode == "balanced") {
+				g_config.gate_expansion = GateExpansion::Balanced;
+			} else if (mode == "level") {
+				g_config.gate_expansion = GateExpansion::Level;
+			} else {
+				log_error() << "unknown gate expansion" << mode;
+				return false;
+			}
+		} else if (arg == "--static-learning") {
+			g_config.static_learning = true;
+		} else if (arg == "--recursive-learning") {
+			g_config.static_learning = true;
+			g_config.recursive_learning = true;
+		} else if ((arg == "--portfolio" || arg == "--hard-fault-budget" || arg == "--cubes" || arg == "--cube-depth" || arg == "--n-detect") && has_value) {
+			try {
+				size_t value = std::stoul(argv[++i]);
+				if (arg == "--portfolio") {
+					g_config.portfolio_size = value;
+				} else if (arg == "--hard-fault-budget") {
+					g_config.hard_fault_budget = value;
+				} else if (arg == "--cubes") {
+					g_config.cube_threads = value;
+				} else if (arg == "--n-detect") {
+					g_config.n_detect = std::max<size_t>(value, 1);
+				} else if (value <= CubeSolver::max_depth) {
+					g_config.cube_depth = value;
+				} else {
+					log_error() << "--cube-depth can't be more than" << CubeSolver::max_depth;
+					return false;
+				}
+			} catch (const std::exception&) {
+				log_error() << "invalid value for" << arg << argv[i];
+				return false;
+			}
+		} else if (arg == "--processes" && has_value) {
+			try {
+				g_config.process_count = std::stoul(argv[++i]);
+			} catch (const std::exception&) {
+				log_error() << "invalid process count" << argv[i];
+				return false;
+			}
+		} else if (arg == "--threads" && has_value) {
+			try {
+				g_config.thread_count = std::stoul(argv[++i]);
+			} catch (const std::exception&) {
+				log_error() << "invalid thread count" << argv[i];
+				return false;
+			}
+		} else if (arg == "--no-clause-sharing") {
+			g_config.clause_sharing = false;
+		} else if (arg == "--shard" && has_value) {
+			if (!parse_shard(argv[++i])) {
+				log_error() << "invalid shard" << argv[i] << "expected i/N with i < N";
+				return false;
+			}
+		} else if (arg == "--shard-mode" && has_value) {
+			std::string mode = argv[++i];
+			if (mode == "cone") {
+				g_config.shard_mode = FaultManager::ShardMode::Cone;
+			} else if (mode == "interleaved") {
+				g_config.shard_mode = FaultManager::ShardMode::Interleaved;
+			} else {
+				log_error() << "unknown shard mode" << mode;
+				return false;
+			}
+		} else if (arg.compare(0, 2, "--") == 0) {
+			log_error() << "unknown option" << arg;
+			return false;
+		} else if (circuit_path.empty()) {
+			circuit_path = arg;
+		} else {
+			log_error() << "unexpected argument" << arg;
+			return false;
+		}
+	}
+
+	if (circuit_path.empty()) {
 		log_error() << "no input file specified";
+		return false;
+	}
+	if (g_config.portfolio_size && g_config.cube_threads) {
+		log_error() << "--portfolio and --cubes can't be used together";
+		return false;
+	}
+	if (g_config.thread_count && g_config.process_count) {
+		log_error() << "--threads and --processes can't be used together";
+		return false;
+	}
+	if (g_config.incremental && !g_config.thread_count) {
+		if (g_config.process_count) {
+			log_error() << "incremental=1 in --config can't be used with --processes";
+			return false;
+		}
+		g_config.thread_count = 1;
+	}
+	if (g_config.portfolio_size && g_config.thread_count) {
+		log_warning() << "--portfolio is ignored with --threads, thread workers solve every fault without a conflict budget";
+	}
+	if (g_config.cube_threads && g_config.thread_count) {
+		log_warning() << "--cubes is ignored with --threads, thread workers solve every fault without a conflict budget";
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string circuit_path;
+	if (!parse_args(argc, argv, circuit_path)) {
 		return 1;
 	}
-	std::ifstream ifs(argv[1]);
+	TRACE_THREAD_NAME("main");
+
+	// Daemon responses must not wait in a buffer
+	AsyncLogGuard async_log_guard;
+	if ((g_config.async_log || g_config.write_faults || g_config.write_solutions) && !g_config.daemon) {
+		AsyncLogWriter::instance().start(Logger::get_streambuf());
+	}
+
+	// Counters of the main thread, so only the sequential run is measured completely
+	std::unique_ptr<PerfCounters> perf_counters;
+	struct
+	{
+		PerfCounters::Values parse;
+		PerfCounters::Values encode;
+		PerfCounters::Values solve;
+		PerfCounters::Values simulate;
+	} perf;
+	if (g_config.perf_counters) {
+		if (g_config.thread_count || g_config.process_count) {
+			log_warning() << "hardware counters are only collected without --threads and --processes";
+		} else {
+			perf_counters.reset(new PerfCounters());
+			if (!perf_counters->is_available()) {
+				log_warning() << "hardware counters are not available:" << perf_counters->get_error();
+			} else if (!perf_counters->is_complete()) {
+				log_warning() << "some hardware counters are not available and read as zero:" << perf_counters->get_error();
+			}
+		}
+	}
+
+	std::ifstream ifs(circuit_path);
 	if (!ifs.good()) {
-		log_error() << "can't open file" << argv[1];
+		log_error() << "can't open file" << circuit_path;
 		return 1;
 	}
 
 	CircuitGraph graph;
 	Iscas89Parser parser;
-	if (!parser.parse(ifs, graph)) {
-		log_error() << "can't parse file" << argv[1];
+	bool parsed = false;
+	{
+		PerfScope scope(perf_counters.get(), perf.parse);
+		parsed = parser.parse(ifs, graph);
+	}
+	if (!parsed) {
+		log_error() << "can't parse file" << circuit_path;
 		return 1;
 	}
+	if (g_config.gate_expansion != GateExpansion::Chain) {
+		graph.set_gate_expansion(g_config.gate_expansion);
+	}
+
+	if (g_config.daemon) {
+		if (!SolverFactory::make_solver()) {
+			log_error() << "No SAT solver, can't run";
+			return 1;
+		}
+		AtpgServer server(graph, g_config.gate_encoding);
+		if (!server.set_solver_options(g_config.solver_options, g_config.hard_fault_budget)) {
+			return 1;
+		}
+		if (g_config.socket_path.empty()) {
+			server.serve(std::cin, std::cout);
+			return 0;
+		}
+		return server.serve_socket(g_config.socket_path) ? 0 : 1;
+	}
 
 	struct
 	{
 		uint64_t fault_generation = 0;
+		uint64_t static_learning = 0;
 		uint64_t cnf_generation = 0;
 		uint64_t cnf_solving = 0;
 		uint64_t worst_solving = 0;
+		uint64_t validation = 0;
 	} timing;
 
 	std::unique_ptr<SatSolver> solver = SolverFactory::make_solver();
@@ -59,7 +372,13 @@ int main(int argc, char* argv[])
 		return 1;
 	}
 
-	FaultCnfMaker fault_cnf_maker(graph);
+	for (const auto& option : g_config.solver_options) {
+		if (!solver->set_option(option.first, option.second)) {
+			return 1;
+		}
+	}
+
+	FaultCnfMaker fault_cnf_maker(graph, g_config.gate_encoding);
 
 	size_t sat = 0;
 	size_t unsat = 0;
@@ -70,74 +389,445 @@ int main(int argc, char* argv[])
 
 	ElapsedTimer t(true);
 	FaultManager fault_manager(graph);
+	if (g_config.shard_count) {
+		fault_manager.select_shard(g_config.shard_index, g_config.shard_count, g_config.shard_mode);
+	}
 	timing.fault_generation = t.get_elapsed_us();
 
 	fault_cnf_maker.set_threshold_ratio(g_config.threshold_ratio);
+	fault_cnf_maker.set_use_cost_model(g_config.cost_model);
+	fault_cnf_maker.set_use_dominators(g_config.use_dominators);
+
+	std::vector<clause_t> learned_clauses;
+	if (g_config.static_learning) {
+		t.start();
+		StaticLearner learner(graph);
+		learner.set_recursive_learning(g_config.recursive_learning);
+		learner.set_max_assignments(g_config.static_learning_max_assignments);
+		learned_clauses = learner.learn();
+		fault_cnf_maker.set_learned_clauses(learned_clauses);
+		timing.static_learning = t.get_elapsed_us();
+		log_info() << "Static learning:" << learned_clauses.size() << "clauses," << learner.get_constant_lines() << "constant lines";
+	}
+
+	std::vector<size_t> detected_ids; // with patterns, for n-detect
+	std::vector<std::string> detected_patterns;
+
+	std::unique_ptr<JournalWriter> journal;
+	if (!g_config.journal_path.empty()) {
+		JournalHeader header;
+		header.circuit_hash = graph.get_hash();
+		header.fault_count = fault_manager.get_fault_count();
+
+		std::ifstream journal_ifs(g_config.journal_path);
+		if (journal_ifs.good() && journal_ifs.peek() != std::ifstream::traits_type::eof()) {
+			JournalHeader prev_header;
+			std::vector<FaultRecord> records;
+			if (!read_journal(journal_ifs, prev_header, records)) {
+				return 1;
+			}
+			if (prev_header.circuit_hash != header.circuit_hash || prev_header.fault_count != header.fault_count) {
+				log_error() << "journal" << g_config.journal_path << "was written for a different circuit";
+				return 1;
+			}
+
+			size_t resumed = 0;
+			for (const FaultRecord& record : records) {
+				if (!record.is_classified() || fault_manager.is_skipped(record.fault_id)) {
+					continue;
+				}
+				fault_manager.skip_fault(record.fault_id);
+				++resumed;
+				++total_faults;
+				if (record.status == FaultStatus::Detectable) {
+					++sat;
+					// Resumed faults still need their extra tests
+					if (g_config.n_detect > 1 && record.pattern.size() == graph.get_inputs().size()) {
+						detected_ids.push_back(record.fault_id);
+						detected_patterns.push_back(record.pattern);
+					}
+				} else {
+					++unsat;
+				}
+			}
+			log_info() << "Resuming from journal," << resumed << "faults already classified";
+		}
+
+		journal.reset(new JournalWriter(header));
+		if (!journal->open(g_config.journal_path)) {
+			return 1;
+		}
+	}
+
+	std::unique_ptr<FaultTraceWriter> trace;
+	if (!g_config.trace_path.empty()) {
+		trace.reset(new FaultTraceWriter());
+		if (!trace->open(g_config.trace_path)) {
+			log_error() << "can't open trace file" << g_config.trace_path;
+			return 1;
+		}
+		solver->set_count_conflicts(true);
+	}
+
+	std::unique_ptr<PatternWriter> pattern_writer;
+	if (!g_config.patterns_path.empty()) {
+		pattern_writer.reset(new PatternWriter());
+		if (!pattern_writer->open(g_config.patterns_path, graph)) {
+			return 1;
+		}
+	}
+
+	std::ofstream stil_ofs;
+	std::unique_ptr<StilWriter> stil_writer;
+	if (!g_config.stil_path.empty()) {
+		stil_ofs.open(g_config.stil_path);
+		if (!stil_ofs.good()) {
+			log_error() << "can't open file" << g_config.stil_path;
+			return 1;
+		}
+		stil_writer.reset(new StilWriter(stil_ofs, graph));
+		stil_writer->write_header();
+	}
+
+	std::unique_ptr<PatternValidator> validator;
+	std::vector<size_t> undetectable_ids;
+	if (g_config.validate) {
+		validator.reset(new PatternValidator(graph, fault_manager));
+	}
 
 	ProxyCnf proxy(*solver);
 
-	while (fault_manager.has_faults_left()) {
-		Fault f = fault_manager.next_fault();
-		++total_faults;
+	std::unique_ptr<RedundancyAnalyzer> redundancy_analyzer;
+	if (g_config.use_implications) {
+		redundancy_analyzer.reset(new RedundancyAnalyzer(graph));
+		redundancy_analyzer->add_constants(learned_clauses);
+	}
+	size_t redundant_by_implications = 0;
+
+	std::unique_ptr<PortfolioSolver> portfolio;
+	std::vector<size_t> portfolio_wins;
+	size_t portfolio_faults = 0;
+	if (g_config.portfolio_size) {
+		portfolio.reset(new PortfolioSolver(make_portfolio_configs(g_config.portfolio_size)));
+		portfolio_wins.resize(portfolio->get_configs().size(), 0);
+	}
+
+	std::unique_ptr<CubeSolver> cube_solver;
+	size_t cube_faults = 0;
+	size_t solved_cubes = 0;
+	if (g_config.cube_threads) {
+		cube_solver.reset(new CubeSolver(graph, g_config.cube_threads, g_config.cube_depth));
+		cube_solver->set_conflict_limit(g_config.hard_fault_budget);
+	}
+
+	if (portfolio || cube_solver) {
+		solver->set_conflict_limit(g_config.hard_fault_budget);
+	}
+
+	auto solve_fault = [&](const Fault& f, WorkerResult& result) {
 		if (g_config.total_time_limit_s && total_timer.get_elapsed_ms() > g_config.total_time_limit_s * 1000) {
-			++unknown;
-			continue;
+			return;
+		}
+
+		ElapsedTimer fault_timer(true);
+		if (redundancy_analyzer && redundancy_analyzer->is_redundant(f)) {
+			result.record.status = FaultStatus::Undetectable;
+			result.is_redundant_by_implications = true;
+			result.cnf_time_us = fault_timer.get_elapsed_us();
+			return;
+		}
+
+		{
+			PerfScope scope(perf_counters.get(), perf.encode);
+			fault_cnf_maker.make_fault(f, proxy);
+		}
+		result.cnf_time_us = fault_timer.get_elapsed_us();
+		result.cone_lines = fault_cnf_maker.get_last_info().cone_lines;
+		result.is_partial_cnf = fault_cnf_maker.get_last_info().is_partial;
+		result.clauses = solver->get_clause_count();
+		result.variables = solver->get_max_var();
+
+		if (!g_config.do_solve) {
+			return;
+		}
+
+		fault_timer.start();
+		SatSolver::SolveStatus status;
+		{
+			PerfScope scope(perf_counters.get(), perf.solve);
+			status = solver->solve_prepared();
+		}
+		fault_cnf_maker.add_solve_time(fault_timer.get_elapsed_us());
+		result.conflicts = solver->get_conflicts();
+		SatSolver* model_solver = solver.get();
+
+		if (status == SatSolver::Unknown && portfolio) {
+			// Hard fault, fresh CNF is solved by all configurations at once
+			Cnf cnf;
+			fault_cnf_maker.make_fault(f, cnf);
+			status = portfolio->solve(cnf);
+			model_solver = &portfolio->get_winner();
+			result.used_portfolio = true;
+			if (status != SatSolver::Unknown) {
+				result.portfolio_winner = portfolio->get_winner_index();
+			}
+		} else if (status == SatSolver::Unknown && cube_solver) {
+			Cnf cnf;
+			fault_cnf_maker.make_fault(f, cnf);
+			size_t solved_before = cube_solver->get_solved_cubes();
+			status = cube_solver->solve(cnf, f);
+			result.used_cubes = true;
+			result.solved_cubes = cube_solver->get_solved_cubes() - solved_before;
+		}
+		result.record.solve_time_us = fault_timer.get_elapsed_us();
+
+		if (status == SatSolver::Sat) {
+			result.record.status = FaultStatus::Detectable;
+			result.record.pattern = result.solved_cubes ? cube_solver->get_pattern() : make_pattern(*model_solver, graph);
+		} else if (status == SatSolver::Unsat) {
+			result.record.status = FaultStatus::Undetectable;
+		}
+	};
+
+	bool has_broken_fault = false;
+	auto report_result = [&](const Fault& f, const WorkerResult& result) {
+		++total_faults;
+		timing.cnf_generation += result.cnf_time_us;
+		timing.cnf_solving += result.record.solve_time_us;
+		if (result.record.solve_time_us > timing.worst_solving) {
+			timing.worst_solving = result.record.solve_time_us;
 		}
 
 		if (g_config.write_faults) {
-			if (f.is_stem || f.is_primary_output) {
-				log_info() << log_nospace << f.line->name << log_noendl;
-				log_info() << "/O" << log_noendl;
-			} else {
+			if (!f.is_stem && !f.is_primary_output) {
 				const Gate* gate = f.connection.gate;
 				auto it = std::find(gate->get_inputs().cbegin(), gate->get_inputs().cend(), f.line);
 				if (it == gate->get_inputs().cend()) {
 					log_error() << "Broken fault";
 					assert(false);
-					return 1;
+					has_broken_fault = true;
+					return;
 				}
-				size_t idx = f.connection.input_idx;
-				log_info() << log_nospace << gate->get_output()->name << log_noendl;
-				log_info() << log_nospace << "/I" << idx+1 << " " << log_noendl;
 			}
 			auto logger = log_info();
-			logger << log_nospace << "S-A-" << (int)f.stuck_at;
+			logger << log_nospace << get_fault_name(f);
 			if (g_config.write_detectability)
 				logger << log_noendl;
 		}
 
-		t.start();
-		fault_cnf_maker.make_fault(f, proxy);
-		timing.cnf_generation += t.get_elapsed_us();
+		if (!g_config.do_solve) {
+			return;
+		}
+
+		if (g_config.write_solutions) {
+			// One record for the whole pattern, unconstrained inputs stay X in every mode
+			std::string solution;
+			for (size_t i = 0; i < graph.get_inputs().size() && i < result.record.pattern.size(); ++i) {
+				solution += "\t " + graph.get_inputs()[i]->name + " " + result.record.pattern[i] + " \n";
+			}
+			log_info() << log_nospace << log_noendl << solution;
+		}
+
+		if (journal) {
+			journal->write(result.record);
+		}
 
-		if (g_config.do_solve) {
-			t.start();
-			SatSolver::SolveStatus status = solver->solve_prepared();
-			timing.cnf_solving += t.get_elapsed_us();
+		if (trace) {
+			trace->write(f, result, g_config.thread_count);
+		}
 
-			if (t.get_elapsed_us() > timing.worst_solving) {
-				timing.worst_solving = t.get_elapsed_us();
+		if (result.record.status == FaultStatus::Detectable && result.record.pattern.size() == graph.get_inputs().size()) {
+			if (pattern_writer) {
+				pattern_writer->write(result.record.pattern);
+			}
+			if (stil_writer) {
+				stil_writer->write(result.record.pattern);
+			}
+			if (validator) {
+				ElapsedTimer validation_timer(true);
+				PerfScope scope(perf_counters.get(), perf.simulate);
+				validator->add_pattern(result.record.pattern, result.record.fault_id);
+				timing.validation += validation_timer.get_elapsed_us();
+			}
+			if (g_config.n_detect > 1) {
+				detected_ids.push_back(result.record.fault_id);
+				detected_patterns.push_back(result.record.pattern);
 			}
+		} else if (validator && result.record.status == FaultStatus::Undetectable) {
+			undetectable_ids.push_back(result.record.fault_id);
+		}
 
-			if (g_config.write_solutions) {
-				for (Line* l : graph.get_inputs()) {
-					int8_t val = solver->get_value(line_to_literal(l->id));
-					log_info() << "\t" << l->name << (val == -1 ? 0 : 1);
-				}
+		if (result.used_cubes) {
+			++cube_faults;
+			solved_cubes += result.solved_cubes;
+		}
+
+		if (result.used_portfolio) {
+			++portfolio_faults;
+			if (result.portfolio_winner >= 0) {
+				++portfolio_wins[result.portfolio_winner];
 			}
+		}
 
-			if (g_config.write_detectability) {
-				log_info() << (status == SatSolver::Sat ? "===DETECTABLE===" : "===REDUNDANT====");
+		if (g_config.write_detectability) {
+			log_info() << (result.record.status == FaultStatus::Detectable ? "===DETECTABLE===" : "===REDUNDANT====");
+		}
+
+		if (result.record.status == FaultStatus::Detectable) {
+			sat += 1;
+		} else if (result.record.status == FaultStatus::Undetectable) {
+			unsat += 1;
+			redundant_by_implications += result.is_redundant_by_implications;
+		} else {
+			unknown += 1;
+		}
+	};
+
+	std::vector<size_t> fault_ids;
+	if (g_config.process_count || g_config.thread_count) {
+		while (fault_manager.has_faults_left()) {
+			fault_manager.next_fault();
+			fault_ids.push_back(fault_manager.get_current_fault_id());
+		}
+	}
+
+	size_t exported_clauses = 0;
+	size_t imported_clauses = 0;
+
+	if (g_config.thread_count) {
+		ParallelFaultSolver parallel_solver(graph, fault_manager, g_config.thread_count);
+		parallel_solver.set_clause_sharing(g_config.clause_sharing);
+		parallel_solver.set_learned_clauses(learned_clauses);
+		parallel_solver.set_use_dominators(g_config.use_dominators);
+		parallel_solver.set_gate_encoding(g_config.gate_encoding);
+		parallel_solver.set_use_implications(g_config.use_implications);
+		parallel_solver.set_solver_options(g_config.solver_options);
+		parallel_solver.set_count_conflicts(trace != nullptr);
+		parallel_solver.set_do_solve(g_config.do_solve);
+		parallel_solver.set_time_limit(total_timer, g_config.total_time_limit_s * 1000);
+		bool solver_ok = parallel_solver.run(fault_ids, [&](const WorkerResult& result) {
+			report_result(fault_manager.get_fault(result.record.fault_id), result);
+		});
+		if (!solver_ok) {
+			return 1;
+		}
+		exported_clauses = parallel_solver.get_exported_clauses();
+		imported_clauses = parallel_solver.get_imported_clauses();
+	} else if (g_config.process_count) {
+		// Built once here and shared with workers
+		fault_cnf_maker.get_circuit_cnf();
+
+		WorkerPool pool(g_config.process_count);
+		bool pool_ok = pool.run(fault_ids,
+			[&](size_t fault_id, WorkerResult& result) {
+				solve_fault(fault_manager.get_fault(fault_id), result);
+			},
+			[&](const WorkerResult& result) {
+				report_result(fault_manager.get_fault(result.record.fault_id), result);
+			});
+		if (!pool_ok) {
+			return 1;
+		}
+		if (pool.get_crashed_workers()) {
+			log_error() << pool.get_crashed_workers() << "workers crashed, their faults are reported as UNKNOWN";
+		}
+	} else {
+		while (fault_manager.has_faults_left()) {
+			Fault f = fault_manager.next_fault();
+			WorkerResult result;
+			result.record.fault_id = fault_manager.get_current_fault_id();
+			solve_fault(f, result);
+			report_result(f, result);
+			if (has_broken_fault) {
+				return 1;
 			}
+		}
+	}
+	if (has_broken_fault) {
+		return 1;
+	}
 
-			if (status == SatSolver::Sat) {
-				sat += 1;
-			} else if (status == SatSolver::Unsat) {
-				unsat += 1;
-			} else {
-				unknown += 1;
+	if (trace && !trace->write_summary()) {
+		log_error() << "can't write trace file" << g_config.trace_path;
+		return 1;
+	}
+
+	std::unique_ptr<IncrementalFaultSolver> n_detect_solver;
+	std::unique_ptr<NDetectGenerator> n_detect;
+	uint64_t n_detect_time_us = 0;
+	if (g_config.n_detect > 1 && !detected_ids.empty()) {
+		ElapsedTimer n_detect_timer(true);
+		std::unique_ptr<SatSolver> sat_solver = SolverFactory::make_solver();
+		if (!sat_solver) {
+			log_error() << "No SAT solver, can't run n-detect";
+			return 1;
+		}
+		for (const auto& option : g_config.solver_options) {
+			if (!sat_solver->set_option(option.first, option.second)) {
+				return 1;
 			}
 		}
+		sat_solver->set_conflict_limit(g_config.hard_fault_budget);
+		n_detect_solver.reset(new IncrementalFaultSolver(graph, std::move(sat_solver), g_config.gate_encoding));
+		n_detect_solver->add_circuit_clauses(learned_clauses);
+		n_detect_solver->get_fault_cnf_maker().set_use_dominators(g_config.use_dominators);
+
+		n_detect.reset(new NDetectGenerator(graph, fault_manager, *n_detect_solver, g_config.n_detect));
+		for (const std::string& pattern : detected_patterns) {
+			n_detect->add_pattern(pattern);
+		}
+		// Results of parallel runs arrive out of order, faults are targeted in generation order
+		std::sort(detected_ids.begin(), detected_ids.end());
+		n_detect->run(detected_ids, [&](size_t fault_id, const std::string& pattern) {
+			if (pattern_writer) {
+				pattern_writer->write(pattern);
+			}
+			if (stil_writer) {
+				stil_writer->write(pattern);
+			}
+			if (validator) {
+				PerfScope scope(perf_counters.get(), perf.simulate);
+				validator->add_pattern(pattern, fault_id);
+			}
+		});
+		n_detect_time_us = n_detect_timer.get_elapsed_us();
+	}
+
+	if (pattern_writer && !pattern_writer->close()) {
+		log_error() << "can't write file" << g_config.patterns_path;
+		return 1;
+	}
+	if (stil_writer && !stil_writer->finish()) {
+		log_error() << "can't write file" << g_config.stil_path;
+		return 1;
+	}
+	if (journal && !journal->close()) {
+		return 1;
+	}
+
+	size_t failed_validations = 0;
+	if (validator) {
+		ElapsedTimer validation_timer(true);
+		{
+			PerfScope scope(perf_counters.get(), perf.simulate);
+			validator->flush();
+		}
+		timing.validation += validation_timer.get_elapsed_us();
+
+		for (const PatternValidator::FailedClaim& claim : validator->get_failed_claims()) {
+			log_error() << "pattern of fault" << get_fault_name(fault_manager.get_fault(claim.fault_id)) << "doesn't detect it in simulation";
+			++failed_validations;
+		}
+		for (size_t id : undetectable_ids) {
+			if (validator->is_detected(id)) {
+				log_error() << "fault" << get_fault_name(fault_manager.get_fault(id)) << "is classified undetectable but detected in simulation";
+				++failed_validations;
+			}
+		}
+	}
+
+	if (!g_config.timeline_path.empty() && !write_trace_timeline(g_config.timeline_path)) {
+		return 1;
 	}
 
 	if (g_config.write_stats) {
@@ -146,18 +836,80 @@ int main(int argc, char* argv[])
 		} else {
 			log_info() << "Timing:";
 			log_info() << "  " << "Fault generation:" << timing.fault_generation/1000 << "ms";
+			if (g_config.static_learning) {
+				log_info() << "  " << "Static learning:" << timing.static_learning/1000 << "ms";
+			}
 			log_info() << "  " << "CNF generation:" << timing.cnf_generation/1000 << "ms";
 			log_info() << "  " << "CNF solving:" << timing.cnf_solving/1000 << "ms";
 			log_info() << "  " << "Slowest solve time:" << timing.worst_solving/1000 << "ms";
+			if (validator) {
+				log_info() << "  " << "Pattern validation:" << timing.validation/1000 << "ms";
+			}
+			if (n_detect) {
+				log_info() << "  " << "N-detect:" << n_detect_time_us/1000 << "ms";
+			}
 			log_info() << "  " << "Total:" << total_timer.get_elapsed_ms() << "ms";
 			log_info() << "";
 
+			if (perf_counters && perf_counters->is_available()) {
+				log_info() << "Hardware counters (main thread):";
+				auto log_phase = [](const char* name, const PerfCounters::Values& values) {
+					double ipc = values[PerfCounters::Cycles] ? double(values[PerfCounters::Instructions]) / values[PerfCounters::Cycles] : 0;
+					log_info() << "  " << name << values[PerfCounters::Cycles] << "cycles," << values[PerfCounters::Instructions] << "instructions, IPC"
+						<< ipc << "," << values[PerfCounters::CacheMisses] << "cache misses," << values[PerfCounters::BranchMisses] << "branch misses";
+				};
+				log_phase("Parse:", perf.parse);
+				log_phase("Encode:", perf.encode);
+				log_phase("Solve:", perf.solve);
+				if (validator) {
+					log_phase("Simulate:", perf.simulate);
+				}
+				log_info() << "";
+			}
+
+			const CnfCostModel* cost_model = fault_cnf_maker.get_cost_model();
+			if (cost_model && !g_config.thread_count && !g_config.process_count) {
+				log_info() << "CNF (partial/full):" << cost_model->get_partial_count() << cost_model->get_full_count()
+					<< "overlap factor:" << cost_model->get_overlap_factor();
+				log_info() << "";
+			}
+
+			if (portfolio) {
+				log_info() << "Portfolio:" << portfolio_faults << "faults over budget, wins:";
+				for (size_t i = 0; i < portfolio_wins.size(); ++i) {
+					log_info() << "  " << portfolio->get_configs()[i].name << ":" << portfolio_wins[i];
+				}
+				log_info() << "";
+			}
+
+			if (cube_solver) {
+				log_info() << "Cube and conquer:" << cube_faults << "faults over budget," << solved_cubes << "cubes solved";
+				log_info() << "";
+			}
+
+			if (g_config.thread_count && g_config.clause_sharing) {
+				log_info() << "Shared clauses (exported/imported):" << exported_clauses << imported_clauses;
+				log_info() << "";
+			}
+
 			log_info() << "Total:" << total_faults;
 			log_info() << "Detectable:" << sat;
 			log_info() << "Undetectable:" << unsat;
+			if (g_config.use_implications) {
+				log_info() << "  " << "by implications:" << redundant_by_implications;
+			}
 			log_info() << "UNKNOWN:" << unknown;
+			if (n_detect) {
+				log_info() << "N-detect" << g_config.n_detect << "(faults/SAT/exhausted/aborted):" << n_detect->get_n_detected_faults()
+					<< n_detect->get_sat_faults() << n_detect->get_exhausted_faults() << n_detect->get_aborted_faults();
+				log_info() << "  " << "patterns added:" << n_detect->get_generated_patterns();
+			}
+			if (validator) {
+				log_info() << "Validated patterns (total/failed):" << validator->get_pattern_count() << failed_validations;
+				log_info() << "Detected in simulation:" << validator->get_detected_count();
+			}
 		}
 	}
 
-	return 0;
+	return failed_validations ? 1 : 0;
 }
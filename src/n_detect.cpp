@@ -0,0 +1,105 @@
+#include "n_detect.h"
+
+#include "util/trace.h"
+
+#include <algorithm>
+
+NDetectGenerator::NDetectGenerator(const CircuitGraph& circuit, const FaultManager& fault_manager, IncrementalFaultSolver& solver, size_t n)
+	: m_fault_manager(fault_manager)
+	, m_solver(solver)
+	, m_simulator(circuit)
+	, m_n(n)
+	, m_is_waiting(fault_manager.get_fault_count(), 0)
+	, m_detecting(fault_manager.get_fault_count())
+{}
+
+void NDetectGenerator::add_pattern(const std::string& pattern)
+{
+	// The same pattern found for several faults is one detection
+	if (m_known_patterns.insert(pattern).second) {
+		m_patterns.push_back(pattern);
+	}
+}
+
+void NDetectGenerator::run(const std::vector<size_t>& fault_ids, const PatternFunction& on_pattern)
+{
+	TRACE_SCOPE("n-detect");
+	m_waiting = fault_ids;
+	for (size_t fault_id : fault_ids) {
+		m_is_waiting[fault_id] = m_detecting[fault_id].size() < m_n;
+	}
+	simulate_pending(true);
+
+	std::vector<std::string> blocked;
+	std::vector<std::string> found;
+	for (size_t fault_id : fault_ids) {
+		if (!m_is_waiting[fault_id]) {
+			continue;
+		}
+		m_is_waiting[fault_id] = 0;
+		const Fault& fault = m_fault_manager.get_fault(fault_id);
+
+		// Patterns of the last, incomplete batch were not simulated against this fault yet
+		if (m_simulated < m_patterns.size()) {
+			m_simulator.load_patterns(m_patterns, m_simulated);
+			add_detections(fault_id, m_simulator.simulate_fault(fault), m_simulated);
+		}
+		std::vector<size_t>& detecting = m_detecting[fault_id];
+		if (detecting.size() >= m_n) {
+			++m_n_detected_faults;
+			continue;
+		}
+
+		++m_sat_faults;
+		blocked.clear();
+		for (size_t pattern_idx : detecting) {
+			blocked.push_back(m_patterns[pattern_idx]);
+		}
+		found.clear();
+		SatSolver::SolveStatus status = m_solver.solve_distinct(fault, blocked, m_n - detecting.size(), found);
+		for (const std::string& pattern : found) {
+			detecting.push_back(m_patterns.size());
+			m_patterns.push_back(pattern);
+			m_known_patterns.insert(pattern);
+			++m_generated_patterns;
+			on_pattern(fault_id, pattern);
+		}
+
+		if (detecting.size() >= m_n) {
+			++m_n_detected_faults;
+		} else if (status == SatSolver::Unknown) {
+			++m_aborted_faults;
+		} else {
+			++m_exhausted_faults;
+		}
+		simulate_pending(false);
+	}
+}
+
+void NDetectGenerator::simulate_pending(bool partial_batch)
+{
+	while (m_patterns.size() - m_simulated >= FaultSimulator::patterns_per_pass || (partial_batch && m_simulated < m_patterns.size())) {
+		auto is_done = [this](size_t fault_id) { return !m_is_waiting[fault_id]; };
+		m_waiting.erase(std::remove_if(m_waiting.begin(), m_waiting.end(), is_done), m_waiting.end());
+
+		size_t count = m_simulator.load_patterns(m_patterns, m_simulated);
+		for (size_t fault_id : m_waiting) {
+			add_detections(fault_id, m_simulator.simulate_fault(m_fault_manager.get_fault(fault_id)), m_simulated);
+		}
+		m_simulated += count;
+	}
+}
+
+void NDetectGenerator::add_detections(size_t fault_id, uint64_t mask, size_t first)
+{
+	std::vector<size_t>& detecting = m_detecting[fault_id];
+	for (size_t p = 0; mask && p < FaultSimulator::patterns_per_pass && detecting.size() < m_n; ++p) {
+		if ((mask >> p) & 1) {
+			detecting.push_back(first + p);
+		}
+	}
+	if (detecting.size() >= m_n && m_is_waiting[fault_id]) {
+		m_is_waiting[fault_id] = 0;
+		++m_n_detected_faults;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "fault_manager.h"
+#include "fault_simulator.h"
+#include "incremental_solver.h"
+
+#include <functional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Extends a pattern set so that every target fault is detected by n different patterns.
+// Detections are counted by fault simulation, 64 patterns at a time, and a fault stays a target until
+// n patterns detect it. Only targets with fewer detections go to incremental SAT, which blocks the patterns
+// already detecting the fault on its relevant inputs, so every new test is really different for the fault.
+class NDetectGenerator
+{
+public:
+	// Called for every new pattern with the fault it was generated for
+	using PatternFunction = std::function<void(size_t fault_id, const std::string& pattern)>;
+
+	NDetectGenerator(const CircuitGraph& circuit, const FaultManager& fault_manager, IncrementalFaultSolver& solver, size_t n);
+
+	// Pattern found before, e.g. by 1-detect ATPG
+	void add_pattern(const std::string& pattern);
+
+	// Targets faults in the given order, they should be detectable
+	void run(const std::vector<size_t>& fault_ids, const PatternFunction& on_pattern);
+
+	size_t get_detections(size_t fault_id) const { return m_detecting.at(fault_id).size(); }
+	size_t get_n_detected_faults() const { return m_n_detected_faults; }
+	size_t get_generated_patterns() const { return m_generated_patterns; }
+	size_t get_sat_faults() const { return m_sat_faults; } // targets that needed SAT
+	size_t get_exhausted_faults() const { return m_exhausted_faults; } // fewer than n distinct tests exist
+	size_t get_aborted_faults() const { return m_aborted_faults; } // solver gave up
+
+private:
+	// Simulates full batches of patterns not simulated yet against faults that are still waiting
+	void simulate_pending(bool partial_batch);
+	void add_detections(size_t fault_id, uint64_t mask, size_t first);
+
+	const FaultManager& m_fault_manager;
+	IncrementalFaultSolver& m_solver;
+	FaultSimulator m_simulator;
+	size_t m_n;
+
+	std::vector<std::string> m_patterns;
+	std::unordered_set<std::string> m_known_patterns;
+	size_t m_simulated = 0; // patterns before this one were simulated against all waiting faults
+	std::vector<size_t> m_waiting; // targets not processed yet and detected fewer than n times
+	std::vector<uint8_t> m_is_waiting; // by fault id
+	std::vector<std::vector<size_t>> m_detecting; // up to n patterns detecting every fault
+
+	size_t m_n_detected_faults = 0;
+	size_t m_generated_patterns = 0;
+	size_t m_sat_faults = 0;
+	size_t m_exhausted_faults = 0;
+	size_t m_aborted_faults = 0;
+};
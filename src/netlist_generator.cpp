@@ -0,0 +1,213 @@
+#include "netlist_generator.h"
+
+#include <algorithm>
+#include <cmath>
+
+NetlistGenerator::NetlistGenerator(const NetlistGeneratorConfig& config)
+	: m_config(config)
+	, m_random(config.seed)
+{
+	m_config.inputs = std::max<size_t>(m_config.inputs, 2);
+	m_config.gates = std::max<size_t>(m_config.gates, 1);
+	m_config.depth = std::max<size_t>(1, std::min(m_config.depth, m_config.gates));
+	m_config.max_fanin = std::max<size_t>(m_config.max_fanin, 2);
+	m_config.level_span = std::max<size_t>(m_config.level_span, 1);
+	generate();
+}
+
+double NetlistGenerator::random_unit()
+{
+	// 53 random bits, same on every platform unlike std::uniform_real_distribution
+	return (m_random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+uint32_t NetlistGenerator::add_gate(Gate::Type type, uint32_t level, std::vector<uint32_t>&& inputs)
+{
+	Node node;
+	node.type = type;
+	node.level = level;
+	node.inputs = std::move(inputs);
+	m_nodes.push_back(std::move(node));
+	uint32_t id = m_nodes.size() - 1;
+	m_levels[level].push_back(id);
+	return id;
+}
+
+uint32_t NetlistGenerator::pick_from_level(size_t level)
+{
+	const std::vector<uint32_t>& nodes = m_levels[level];
+	// Skewed index, lines at the beginning of a level get most of the fanout
+	size_t index = static_cast<size_t>(std::pow(random_unit(), 1.0 + m_config.fanout_skew) * nodes.size());
+	return nodes[std::min(index, nodes.size() - 1)];
+}
+
+uint32_t NetlistGenerator::pick_reconvergent(uint32_t node)
+{
+	// Line 1-3 levels up in the fanin cone of node, so the new gate is reached by two paths
+	size_t steps = 1 + random_index(3);
+	for (size_t step = 0; step < steps && !m_nodes[node].inputs.empty(); ++step) {
+		const std::vector<uint32_t>& inputs = m_nodes[node].inputs;
+		node = inputs[random_index(inputs.size())];
+	}
+	return node;
+}
+
+void NetlistGenerator::generate()
+{
+	m_nodes.reserve(m_config.inputs + m_config.gates);
+	m_levels.resize(m_config.depth + 1);
+	for (size_t i = 0; i < m_config.inputs; ++i) {
+		m_nodes.push_back(Node());
+		m_levels[0].push_back(i);
+	}
+
+	static const Gate::Type basic_types[] = {Gate::Type::And, Gate::Type::Nand, Gate::Type::Or, Gate::Type::Nor};
+
+	size_t made_gates = 0;
+	for (size_t level = 1; level <= m_config.depth; ++level) {
+		size_t level_end = m_config.gates * level / m_config.depth;
+		// Level always gets at least one gate, so the next level has something to connect to
+		do {
+			uint32_t first = pick_from_level(level - 1);
+			// Lines from previous levels, gates of the current level come after them
+			size_t available = m_levels[level].empty() ? m_nodes.size() : m_levels[level].front();
+
+			auto pick_other = [this, level, first, available](const std::vector<uint32_t>& taken) {
+				for (size_t attempt = 0; ; ++attempt) {
+					uint32_t node;
+					if (attempt < 8 && random_unit() < m_config.reconvergence) {
+						node = pick_reconvergent(first);
+					} else if (attempt < 8) {
+						node = pick_from_level(level - 1 - random_index(std::min(m_config.level_span, level)));
+					} else {
+						// Any line from previous levels, there are always at least two primary inputs
+						node = random_index(available);
+					}
+					if (std::find(taken.begin(), taken.end(), node) == taken.end()) {
+						return node;
+					}
+				}
+			};
+
+			double type_choice = random_unit();
+			std::vector<uint32_t> inputs = {first};
+			if (type_choice < m_config.redundancy && made_gates + 2 <= level_end) {
+				inputs.push_back(pick_other(inputs));
+				uint32_t helper = add_gate(Gate::Type::Or, level, std::vector<uint32_t>(inputs));
+				add_gate(Gate::Type::And, level, {first, helper});
+				made_gates += 2;
+				continue;
+			}
+
+			type_choice -= m_config.redundancy;
+			Gate::Type type;
+			if (type_choice < m_config.xor_density) {
+				type = random_index(2) ? Gate::Type::Xnor : Gate::Type::Xor;
+				inputs.push_back(pick_other(inputs));
+			} else if (type_choice < m_config.xor_density + m_config.inverter_density) {
+				type = random_index(2) ? Gate::Type::Buff : Gate::Type::Not;
+			} else {
+				type = basic_types[random_index(4)];
+				// Inputs are distinct, so small circuits can't give every gate max_fanin inputs
+				size_t fanin = std::min(2 + random_index(m_config.max_fanin - 1), available);
+				while (inputs.size() < fanin) {
+					inputs.push_back(pick_other(inputs));
+				}
+			}
+			add_gate(type, level, std::move(inputs));
+			++made_gates;
+		} while (made_gates < level_end);
+	}
+
+	std::vector<uint32_t> fanout(m_nodes.size(), 0);
+	for (const Node& node : m_nodes) {
+		for (uint32_t input : node.inputs) {
+			++fanout[input];
+		}
+	}
+
+	// Unused primary inputs are added to random multi-input gates
+	std::vector<uint32_t> extendable;
+	for (uint32_t id = m_config.inputs; id < m_nodes.size(); ++id) {
+		Gate::Type type = m_nodes[id].type;
+		if (type == Gate::Type::And || type == Gate::Type::Nand || type == Gate::Type::Or || type == Gate::Type::Nor) {
+			extendable.push_back(id);
+		}
+	}
+	for (uint32_t input = 0; input < m_config.inputs && !extendable.empty(); ++input) {
+		if (!fanout[input]) {
+			m_nodes[extendable[random_index(extendable.size())]].inputs.push_back(input);
+			++fanout[input];
+		}
+	}
+
+	std::vector<bool> is_output(m_nodes.size(), false);
+	for (uint32_t id = m_config.inputs; id < m_nodes.size(); ++id) {
+		if (!fanout[id]) {
+			is_output[id] = true;
+			m_outputs.push_back(id);
+		}
+	}
+	// More outputs from the deepest levels
+	for (size_t level = m_config.depth; level > 0 && m_outputs.size() < m_config.outputs; --level) {
+		for (uint32_t id : m_levels[level]) {
+			if (m_outputs.size() >= m_config.outputs) {
+				break;
+			}
+			if (!is_output[id]) {
+				is_output[id] = true;
+				m_outputs.push_back(id);
+			}
+		}
+	}
+}
+
+std::string NetlistGenerator::get_name(uint32_t node) const
+{
+	return (node < m_config.inputs ? "I" : "N") + std::to_string(node);
+}
+
+void NetlistGenerator::write_bench(std::ostream& os) const
+{
+	os << "# generated netlist, seed " << m_config.seed << "\n";
+	os << "# " << m_config.inputs << " inputs\n";
+	os << "# " << m_outputs.size() << " outputs\n";
+	os << "# " << get_gate_count() << " gates\n\n";
+
+	for (uint32_t id = 0; id < m_config.inputs; ++id) {
+		os << "INPUT(" << get_name(id) << ")\n";
+	}
+	os << "\n";
+	for (uint32_t id : m_outputs) {
+		os << "OUTPUT(" << get_name(id) << ")\n";
+	}
+	os << "\n";
+	for (uint32_t id = m_config.inputs; id < m_nodes.size(); ++id) {
+		const Node& node = m_nodes[id];
+		os << get_name(id) << " = " << make_gate_name(node.type) << "(";
+		for (size_t i = 0; i < node.inputs.size(); ++i) {
+			os << (i ? ", " : "") << get_name(node.inputs[i]);
+		}
+		os << ")\n";
+	}
+}
+
+void NetlistGenerator::build(CircuitGraph& graph) const
+{
+	// Same order as the parser sees in write_bench output, so both give the same graph
+	for (uint32_t id = 0; id < m_config.inputs; ++id) {
+		graph.add_input(get_name(id));
+	}
+	for (uint32_t id : m_outputs) {
+		graph.add_output(get_name(id));
+	}
+	std::vector<std::string> input_names;
+	for (uint32_t id = m_config.inputs; id < m_nodes.size(); ++id) {
+		const Node& node = m_nodes[id];
+		input_names.clear();
+		for (uint32_t input : node.inputs) {
+			input_names.push_back(get_name(input));
+		}
+		graph.add_gate(node.type, input_names, get_name(id));
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "circuit_graph.h"
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <vector>
+
+struct NetlistGeneratorConfig
+{
+	uint64_t seed = 1;
+	size_t inputs = 64;
+	size_t gates = 1000;
+	size_t outputs = 32; // at least this many, lines without fanout always become outputs
+	size_t depth = 20; // levels of logic, first input of every gate comes from the previous level
+	size_t max_fanin = 4; // AND/NAND/OR/NOR gates get 2..max_fanin inputs
+	size_t level_span = 4; // further inputs come from at most this many levels back
+	double fanout_skew = 0.5; // 0 spreads fanout evenly, larger values concentrate it on few lines
+	double reconvergence = 0.2; // probability that a further input comes from the fanin cone of the first one
+	double xor_density = 0.1; // probability of XOR/XNOR gates
+	double inverter_density = 0.05; // probability of NOT/BUFF gates
+	double redundancy = 0.02; // probability of redundant AND(a, OR(a, b)) pairs, their faults are undetectable
+};
+
+// Generates random combinational netlists for stress and scaling tests.
+// Gates are placed on `depth` levels, the first input of a gate is taken from the level right before it,
+// so the netlist is as deep as requested. The same config (including seed) always gives the same netlist,
+// random numbers don't depend on the standard library's distributions.
+class NetlistGenerator
+{
+public:
+	NetlistGenerator(const NetlistGeneratorConfig& config);
+
+	void write_bench(std::ostream& os) const;
+	void build(CircuitGraph& graph) const;
+
+	size_t get_gate_count() const { return m_nodes.size() - m_config.inputs; }
+	size_t get_output_count() const { return m_outputs.size(); }
+
+private:
+	struct Node
+	{
+		Gate::Type type = Gate::Type::Undefined; // Undefined for primary inputs
+		uint32_t level = 0;
+		std::vector<uint32_t> inputs;
+	};
+
+	void generate();
+	uint32_t add_gate(Gate::Type type, uint32_t level, std::vector<uint32_t>&& inputs);
+	uint32_t pick_from_level(size_t level);
+	uint32_t pick_reconvergent(uint32_t node);
+	std::string get_name(uint32_t node) const;
+
+	double random_unit();
+	size_t random_index(size_t size) { return std::min(size - 1, static_cast<size_t>(random_unit() * size)); }
+
+	NetlistGeneratorConfig m_config;
+	std::mt19937_64 m_random;
+
+	std::vector<Node> m_nodes; // inputs first, then gates in topological order
+	std::vector<std::vector<uint32_t>> m_levels; // nodes by level, level 0 are primary inputs
+	std::vector<uint32_t> m_outputs;
+};
@@ -0,0 +1,108 @@
+#include "parallel_solver.h"
+
+#include "incremental_solver.h"
+#include "redundancy.h"
+
+#include "util/log.h"
+#include "util/timer.h"
+#include "util/trace.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+bool ParallelFaultSolver::run(const std::vector<size_t>& fault_ids, const WorkerPool::ResultFunction& on_result)
+{
+	ClausePool pool;
+	// Only read by the threads
+	ElapsedTimer time_limit_timer = m_time_limit_timer;
+	std::atomic<size_t> next(0);
+	std::mutex mutex;
+	bool ok = true;
+
+	auto thread_main = [&](size_t thread_id) {
+		TRACE_THREAD_NAME("solver " + std::to_string(thread_id));
+		std::unique_ptr<SatSolver> sat_solver = SolverFactory::make_solver();
+		if (!sat_solver) {
+			std::lock_guard<std::mutex> lock(mutex);
+			ok = false;
+			return;
+		}
+		for (const auto& option : m_solver_options) {
+			sat_solver->set_option(option.first, option.second);
+		}
+		sat_solver->set_count_conflicts(m_count_conflicts);
+
+		IncrementalFaultSolver solver(m_circuit, std::move(sat_solver), m_gate_encoding);
+		if (m_learned_clauses) {
+			solver.add_circuit_clauses(*m_learned_clauses);
+		}
+		solver.get_fault_cnf_maker().set_use_dominators(m_use_dominators);
+
+		std::unique_ptr<RedundancyAnalyzer> analyzer;
+		if (m_use_implications) {
+			analyzer.reset(new RedundancyAnalyzer(m_circuit));
+			if (m_learned_clauses) {
+				analyzer->add_constants(*m_learned_clauses);
+			}
+		}
+		if (m_clause_sharing) {
+			solver.share_clauses(pool, thread_id);
+		}
+
+		WorkerResult result;
+		ElapsedTimer timer;
+		for (size_t i = next++; i < fault_ids.size(); i = next++) {
+			result = WorkerResult();
+			result.record.fault_id = fault_ids[i];
+
+			const Fault& fault = m_fault_manager.get_fault(fault_ids[i]);
+			if (m_time_limit_ms && time_limit_timer.get_elapsed_ms() > m_time_limit_ms) {
+				std::lock_guard<std::mutex> lock(mutex);
+				on_result(result);
+				continue;
+			}
+
+			timer.start();
+			if (analyzer && analyzer->is_redundant(fault)) {
+				result.record.status = FaultStatus::Undetectable;
+				result.is_redundant_by_implications = true;
+				result.cnf_time_us = timer.get_elapsed_us();
+			} else {
+				SatSolver::SolveStatus status = solver.solve(fault, m_do_solve);
+				result.cnf_time_us = solver.get_last_encode_time_us();
+				result.cone_lines = solver.get_fault_cnf_maker().get_last_info().cone_lines;
+				result.clauses = solver.get_solver().get_clause_count();
+				result.variables = solver.get_solver().get_max_var();
+				result.conflicts = solver.get_solver().get_conflicts();
+				if (status == SatSolver::Sat) {
+					result.record.status = FaultStatus::Detectable;
+					result.record.pattern = solver.get_pattern();
+				} else if (status == SatSolver::Unsat) {
+					result.record.status = FaultStatus::Undetectable;
+				}
+			}
+			result.record.solve_time_us = timer.get_elapsed_us() - result.cnf_time_us;
+
+			std::lock_guard<std::mutex> lock(mutex);
+			on_result(result);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		m_exported_clauses += solver.get_exported_clauses();
+		m_imported_clauses += solver.get_imported_clauses();
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < m_thread_count; ++i) {
+		threads.emplace_back(thread_main, i);
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	if (!ok) {
+		log_error() << "No SAT solver, can't run";
+	}
+	return ok;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "clause_pool.h"
+#include "fault_manager.h"
+#include "worker_pool.h"
+
+#include "util/timer.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Solves faults in several threads, each thread has its own incremental solver with the whole circuit loaded.
+// Optionally threads share short clauses learned on the good circuit.
+class ParallelFaultSolver
+{
+public:
+	ParallelFaultSolver(const CircuitGraph& circuit, const FaultManager& fault_manager, size_t thread_count)
+		: m_circuit(circuit)
+		, m_fault_manager(fault_manager)
+		, m_thread_count(thread_count)
+	{}
+
+	void set_clause_sharing(bool enabled) { m_clause_sharing = enabled; }
+	void set_learned_clauses(const std::vector<clause_t>& clauses) { m_learned_clauses = &clauses; }
+	void set_use_dominators(bool use_dominators) { m_use_dominators = use_dominators; }
+	void set_gate_encoding(GateEncoding gate_encoding) { m_gate_encoding = gate_encoding; }
+	void set_count_conflicts(bool enabled) { m_count_conflicts = enabled; }
+	void set_solver_options(const std::vector<std::pair<std::string, int>>& options) { m_solver_options = options; }
+	// Faults are checked with RedundancyAnalyzer before SAT solving
+	void set_use_implications(bool use_implications) { m_use_implications = use_implications; }
+	// Faults are only encoded, results are Unknown
+	void set_do_solve(bool do_solve) { m_do_solve = do_solve; }
+	// Faults started more than limit_ms after the timer's start are reported as Unknown without solving, 0 means no limit
+	void set_time_limit(const ElapsedTimer& timer, uint64_t limit_ms)
+	{
+		m_time_limit_timer = timer;
+		m_time_limit_ms = limit_ms;
+	}
+
+	// on_result is called from solver threads but never concurrently
+	bool run(const std::vector<size_t>& fault_ids, const WorkerPool::ResultFunction& on_result);
+
+	size_t get_exported_clauses() const { return m_exported_clauses; }
+	size_t get_imported_clauses() const { return m_imported_clauses; }
+
+private:
+	const CircuitGraph& m_circuit;
+	const FaultManager& m_fault_manager;
+	size_t m_thread_count;
+	bool m_clause_sharing = true;
+	const std::vector<clause_t>* m_learned_clauses = nullptr;
+	bool m_use_dominators = false;
+	GateEncoding m_gate_encoding = GateEncoding::Expanded;
+	bool m_use_implications = false;
+	bool m_do_solve = true;
+	ElapsedTimer m_time_limit_timer;
+	uint64_t m_time_limit_ms = 0;
+	std::vector<std::pair<std::string, int>> m_solver_options;
+	bool m_count_conflicts = false;
+
+	size_t m_exported_clauses = 0;
+	size_t m_imported_clauses = 0;
+};
@@ -0,0 +1,242 @@
+#include "pattern_io.h"
+
+#include "util/log.h"
+
+#include <cstring>
+#include <limits>
+
+static const char pattern_magic[8] = {'S', 'A', 'T', 'P', 'A', 'T', 1, '\n'};
+
+template<typename T>
+static void append_uint(std::string& data, T value)
+{
+	for (size_t i = 0; i < sizeof(T); ++i) {
+		data.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+}
+
+template<typename T>
+static bool read_uint(std::istream& is, T& value)
+{
+	unsigned char bytes[sizeof(T)];
+	if (!is.read(reinterpret_cast<char*>(bytes), sizeof(T))) {
+		return false;
+	}
+	value = 0;
+	for (size_t i = 0; i < sizeof(T); ++i) {
+		value |= static_cast<T>(bytes[i]) << (8 * i);
+	}
+	return true;
+}
+
+// Bytes from the current position to the end, streams that can't seek (e.g. pipes) aren't limited
+static uint64_t get_remaining_size(std::istream& is)
+{
+	std::streampos position = is.tellg();
+	if (position == std::streampos(-1)) {
+		return std::numeric_limits<uint64_t>::max();
+	}
+	is.seekg(0, std::ios::end);
+	std::streampos end = is.tellg();
+	is.seekg(position);
+	return end > position ? static_cast<uint64_t>(end - position) : 0;
+}
+
+static size_t get_packed_size(size_t input_count)
+{
+	return (input_count + 3) / 4;
+}
+
+bool PatternWriter::open(const std::string& path, const CircuitGraph& circuit)
+{
+	if (!m_writer.open(path, false)) {
+		log_error() << "can't open pattern file" << path;
+		return false;
+	}
+	m_input_count = circuit.get_inputs().size();
+	m_pattern_count = 0;
+
+	std::string header(pattern_magic, sizeof(pattern_magic));
+	append_uint<uint64_t>(header, circuit.get_hash());
+	append_uint<uint32_t>(header, m_input_count);
+	for (const Line* input : circuit.get_inputs()) {
+		append_uint<uint32_t>(header, input->name.size());
+		header += input->name;
+	}
+	m_writer.write(header);
+	return true;
+}
+
+void PatternWriter::write(const std::string& pattern)
+{
+	assert(pattern.size() == m_input_count);
+	m_packed.assign(get_packed_size(m_input_count), 0);
+	for (size_t i = 0; i < m_input_count; ++i) {
+		uint8_t code = pattern[i] == '1' ? 1 : (pattern[i] == '0' ? 0 : 2);
+		m_packed[i / 4] |= static_cast<char>(code << (2 * (i % 4)));
+	}
+	m_writer.write(m_packed);
+	++m_pattern_count;
+}
+
+bool PatternReader::open()
+{
+	char magic[sizeof(pattern_magic)];
+	uint32_t input_count = 0;
+	if (!m_is.read(magic, sizeof(magic)) || std::memcmp(magic, pattern_magic, sizeof(magic)) != 0
+		|| !read_uint(m_is, m_circuit_hash) || !read_uint(m_is, input_count)) {
+		log_error() << "Not a pattern file";
+		return false;
+	}
+
+	m_input_names.clear();
+	for (uint32_t i = 0; i < input_count; ++i) {
+		uint32_t length = 0;
+		std::string name;
+		// Length of a corrupt header can be anything, so it must fit in the rest of the file
+		if (read_uint(m_is, length) && length <= get_remaining_size(m_is)) {
+			name.resize(length);
+			m_is.read(&name[0], length);
+		} else {
+			m_is.setstate(std::ios::failbit);
+		}
+		if (!m_is) {
+			log_error() << "Invalid pattern file header";
+			return false;
+		}
+		m_input_names.push_back(name);
+	}
+	return true;
+}
+
+bool PatternReader::read(std::string& pattern)
+{
+	static const char values[] = {'0', '1', 'X', 'X'};
+
+	m_packed.resize(get_packed_size(m_input_names.size()));
+	if (m_packed.empty() || !m_is.read(&m_packed[0], m_packed.size())) {
+		return false;
+	}
+	pattern.resize(m_input_names.size());
+	for (size_t i = 0; i < pattern.size(); ++i) {
+		pattern[i] = values[(static_cast<uint8_t>(m_packed[i / 4]) >> (2 * (i % 4))) & 3];
+	}
+	return true;
+}
+
+bool check_pattern_inputs(const PatternReader& reader, const CircuitGraph& circuit)
+{
+	if (reader.get_circuit_hash() != circuit.get_hash()) {
+		log_warning() << "patterns were written for a different netlist";
+	}
+	const std::vector<std::string>& names = reader.get_input_names();
+	if (names.size() != circuit.get_inputs().size()) {
+		log_error() << "patterns have" << names.size() << "inputs, circuit has" << circuit.get_inputs().size();
+		return false;
+	}
+	for (size_t i = 0; i < names.size(); ++i) {
+		if (names[i] != circuit.get_inputs()[i]->name) {
+			log_error() << "input" << i << "is" << names[i] << "in patterns and" << circuit.get_inputs()[i]->name << "in circuit";
+			return false;
+		}
+	}
+	return true;
+}
+
+StilWriter::StilWriter(std::ostream& os, const CircuitGraph& circuit)
+	: m_os(os)
+	, m_circuit(circuit)
+	, m_simulator(circuit)
+{}
+
+static void write_signal_group(std::ostream& os, const char* name, const std::vector<Line*>& lines)
+{
+	os << "\t\"" << name << "\" = '";
+	for (size_t i = 0; i < lines.size(); ++i) {
+		os << (i ? " + \"" : "\"") << lines[i]->name << "\"";
+	}
+	os << "';\n";
+}
+
+void StilWriter::write_header()
+{
+	m_os << "STIL 1.0;\n\n";
+	m_os << "Header {\n\tTitle \"sat_atpg patterns\";\n}\n\n";
+
+	m_os << "Signals {\n";
+	for (const Line* input : m_circuit.get_inputs()) {
+		m_os << "\t\"" << input->name << "\" " << (input->is_output ? "InOut" : "In") << ";\n";
+	}
+	for (const Line* output : m_circuit.get_outputs()) {
+		// Outputs without a driving gate are primary inputs, already declared as InOut
+		if (output->source) {
+			m_os << "\t\"" << output->name << "\" Out;\n";
+		}
+	}
+	m_os << "}\n\n";
+
+	m_os << "SignalGroups {\n";
+	write_signal_group(m_os, "all_inputs", m_circuit.get_inputs());
+	write_signal_group(m_os, "all_outputs", m_circuit.get_outputs());
+	m_os << "}\n\n";
+
+	m_os << "Timing {\n";
+	m_os << "\tWaveformTable \"wft\" {\n";
+	m_os << "\t\tPeriod '100ns';\n";
+	m_os << "\t\tWaveforms {\n";
+	m_os << "\t\t\t\"all_inputs\" { 01N { '0ns' D/U/N; } }\n";
+	m_os << "\t\t\t\"all_outputs\" { LHX { '0ns' Z; '50ns' L/H/X; } }\n";
+	m_os << "\t\t}\n";
+	m_os << "\t}\n";
+	m_os << "}\n\n";
+
+	m_os << "PatternBurst \"burst\" {\n\tPatList { \"patterns\"; }\n}\n\n";
+	m_os << "PatternExec {\n\tPatternBurst \"burst\";\n}\n\n";
+	m_os << "Pattern \"patterns\" {\n";
+	m_os << "\tW \"wft\";\n";
+}
+
+void StilWriter::write(const std::string& pattern)
+{
+	m_buffered.push_back(pattern);
+	if (m_buffered.size() == FaultSimulator::patterns_per_pass) {
+		write_buffered();
+	}
+}
+
+bool StilWriter::finish()
+{
+	write_buffered();
+	m_os << "}\n";
+	m_os.flush();
+	return m_os.good();
+}
+
+void StilWriter::write_buffered()
+{
+	if (m_buffered.empty()) {
+		return;
+	}
+	m_simulator.load_patterns(m_buffered);
+
+	std::string inputs;
+	std::string outputs;
+	for (size_t p = 0; p < m_buffered.size(); ++p) {
+		inputs = m_buffered[p];
+		for (char& value : inputs) {
+			if (value != '0' && value != '1') {
+				value = 'N';
+			}
+		}
+
+		uint64_t bit = 1ull << p;
+		outputs.clear();
+		for (const Line* output : m_circuit.get_outputs()) {
+			const FaultSimulator::Value& value = m_simulator.get_value(output);
+			outputs.push_back((value.one & bit) ? 'H' : ((value.zero & bit) ? 'L' : 'X'));
+		}
+
+		m_os << "\t\"pattern " << m_pattern_count++ << "\": V { \"all_inputs\" = " << inputs << "; \"all_outputs\" = " << outputs << "; }\n";
+	}
+	m_buffered.clear();
+}
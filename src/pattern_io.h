@@ -0,0 +1,85 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "fault_simulator.h"
+
+#include "util/buffered_writer.h"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Binary pattern file, all numbers little endian:
+// 	"SATPAT\x01\n" magic
+// 	u64 circuit hash, u32 input count, then u32 length and bytes of every input name in CircuitGraph::get_inputs() order
+// 	patterns until end of file, (input count + 3) / 4 bytes each, input i is in bits 2 * (i % 4) of byte i / 4:
+// 	00 means 0, 01 means 1, 10 means X
+// Patterns are only appended, truncated last pattern (e.g. after a crash) is ignored on reading.
+class PatternWriter
+{
+public:
+	bool open(const std::string& path, const CircuitGraph& circuit);
+	// Returns false if any pattern couldn't be written
+	bool close() { return m_writer.close(); }
+
+	// Pattern has '0', '1' or 'X' for every circuit input
+	void write(const std::string& pattern);
+
+	size_t get_pattern_count() const { return m_pattern_count; }
+
+private:
+	BufferedWriter m_writer;
+	size_t m_input_count = 0;
+	size_t m_pattern_count = 0;
+	std::string m_packed;
+};
+
+class PatternReader
+{
+public:
+	PatternReader(std::istream& is)
+		: m_is(is)
+	{}
+
+	// Reads header, returns false if it is not a pattern file
+	bool open();
+
+	uint64_t get_circuit_hash() const { return m_circuit_hash; }
+	const std::vector<std::string>& get_input_names() const { return m_input_names; }
+
+	// Returns false at the end of file
+	bool read(std::string& pattern);
+
+private:
+	std::istream& m_is;
+	uint64_t m_circuit_hash = 0;
+	std::vector<std::string> m_input_names;
+	std::string m_packed;
+};
+
+// Logs an error and returns false if pattern file inputs are not the circuit inputs
+bool check_pattern_inputs(const PatternReader& reader, const CircuitGraph& circuit);
+
+// STIL-like ASCII export for tester flows. Every pattern becomes a vector with input values (0, 1 or N)
+// and expected fault free output values (L, H or X), outputs are computed by simulating 64 patterns at a time.
+class StilWriter
+{
+public:
+	StilWriter(std::ostream& os, const CircuitGraph& circuit);
+
+	void write_header();
+	void write(const std::string& pattern);
+	// Writes buffered patterns and closes the pattern block, returns false if writing to the stream failed
+	bool finish();
+
+private:
+	void write_buffered();
+
+	std::ostream& m_os;
+	const CircuitGraph& m_circuit;
+	FaultSimulator m_simulator;
+	std::vector<std::string> m_buffered;
+	size_t m_pattern_count = 0;
+};
@@ -0,0 +1,107 @@
+#include "pattern_validator.h"
+
+#include "util/trace.h"
+
+#include <algorithm>
+
+constexpr size_t PatternValidator::no_fault;
+
+PatternValidator::PatternValidator(const CircuitGraph& circuit, const FaultManager& fault_manager)
+	: m_fault_manager(fault_manager)
+	, m_simulator(circuit)
+	, m_claimed_mask(fault_manager.get_fault_count(), 0)
+	, m_detected(fault_manager.get_fault_count(), 0)
+{
+	m_undetected_ids.reserve(fault_manager.get_fault_count());
+	for (size_t id = 0; id < fault_manager.get_fault_count(); ++id) {
+		m_undetected_ids.push_back(id);
+	}
+	m_batch.reserve(FaultSimulator::patterns_per_pass);
+}
+
+void PatternValidator::add_pattern(const std::string& pattern, size_t claimed_fault_id)
+{
+	if (claimed_fault_id != no_fault) {
+		uint64_t& claimed = m_claimed_mask.at(claimed_fault_id);
+		if (!claimed) {
+			m_batch_claims.push_back(claimed_fault_id);
+		}
+		claimed |= 1ull << m_batch.size();
+		++m_claim_count;
+	}
+
+	m_batch.push_back(pattern);
+	++m_pattern_count;
+	if (m_batch.size() == FaultSimulator::patterns_per_pass) {
+		flush();
+	}
+}
+
+void PatternValidator::flush()
+{
+	if (m_batch.empty()) {
+		return;
+	}
+	TRACE_SCOPE("pattern validation");
+	m_simulator.load_patterns(m_batch);
+
+	if (m_detection_function) {
+		m_pattern_detections.resize(m_batch.size());
+		for (auto& fault_ids : m_pattern_detections) {
+			fault_ids.clear();
+		}
+		for (size_t id = 0; id < m_fault_manager.get_fault_count(); ++id) {
+			detect(id, m_simulator.simulate_fault(m_fault_manager.get_fault(id)));
+		}
+	} else {
+		for (size_t id : m_undetected_ids) {
+			detect(id, m_simulator.simulate_fault(m_fault_manager.get_fault(id)));
+		}
+		auto is_detected = [this](size_t id) { return m_detected[id] != 0; };
+		m_undetected_ids.erase(std::remove_if(m_undetected_ids.begin(), m_undetected_ids.end(), is_detected), m_undetected_ids.end());
+	}
+
+	// Claims of faults dropped in earlier batches
+	for (size_t id : m_batch_claims) {
+		if (m_claimed_mask[id]) {
+			detect(id, m_simulator.simulate_fault(m_fault_manager.get_fault(id)));
+		}
+	}
+
+	if (m_detection_function) {
+		size_t first = m_pattern_count - m_batch.size();
+		for (size_t p = 0; p < m_batch.size(); ++p) {
+			m_detection_function(first + p, m_pattern_detections[p]);
+		}
+	}
+
+	m_batch.clear();
+	m_batch_claims.clear();
+}
+
+void PatternValidator::detect(size_t fault_id, uint64_t mask)
+{
+	size_t first = m_pattern_count - m_batch.size();
+	uint64_t failed = m_claimed_mask[fault_id] & ~mask;
+	m_claimed_mask[fault_id] = 0;
+	for (size_t p = 0; failed && p < m_batch.size(); ++p) {
+		if ((failed >> p) & 1) {
+			m_failed_claims.push_back({fault_id, first + p});
+		}
+	}
+
+	if (!mask) {
+		return;
+	}
+	if (!m_detected[fault_id]) {
+		m_detected[fault_id] = 1;
+		++m_detected_count;
+	}
+	if (m_detection_function) {
+		for (size_t p = 0; p < m_batch.size(); ++p) {
+			if ((mask >> p) & 1) {
+				m_pattern_detections[p].push_back(fault_id);
+			}
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "fault_manager.h"
+#include "fault_simulator.h"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Checks patterns by fault simulation of the real circuit instead of trusting SAT models.
+// Patterns are buffered and simulated 64 at a time against all faults, detected faults are dropped
+// unless detections of every pattern are requested. A pattern can be the claimed test of a fault,
+// the claim fails if simulation doesn't detect the fault with that pattern.
+class PatternValidator
+{
+public:
+	static constexpr size_t no_fault = SIZE_MAX;
+
+	struct FailedClaim
+	{
+		size_t fault_id;
+		size_t pattern_index;
+	};
+
+	// Called for every pattern in order with ids of all faults it detects
+	using DetectionFunction = std::function<void(size_t pattern_index, const std::vector<size_t>& fault_ids)>;
+
+	PatternValidator(const CircuitGraph& circuit, const FaultManager& fault_manager);
+
+	// Disables fault dropping, so every fault is simulated with every pattern
+	void set_detection_function(const DetectionFunction& function) { m_detection_function = function; }
+
+	// Pattern has '0', '1' or 'X' for every circuit input
+	void add_pattern(const std::string& pattern, size_t claimed_fault_id = no_fault);
+	// Simulates buffered patterns, must be called before reading results
+	void flush();
+
+	size_t get_pattern_count() const { return m_pattern_count; }
+	size_t get_claim_count() const { return m_claim_count; }
+
+	size_t get_detected_count() const { return m_detected_count; }
+	bool is_detected(size_t fault_id) const { return m_detected.at(fault_id); }
+
+	const std::vector<FailedClaim>& get_failed_claims() const { return m_failed_claims; }
+
+private:
+	void detect(size_t fault_id, uint64_t mask);
+
+	const FaultManager& m_fault_manager;
+	FaultSimulator m_simulator;
+	DetectionFunction m_detection_function;
+
+	std::vector<std::string> m_batch;
+	std::vector<size_t> m_batch_claims; // faults with claimed patterns in the batch
+	std::vector<uint64_t> m_claimed_mask; // per fault, patterns of the batch claimed to detect it
+
+	std::vector<uint8_t> m_detected;
+	std::vector<size_t> m_undetected_ids;
+	std::vector<std::vector<size_t>> m_pattern_detections;
+	std::vector<FailedClaim> m_failed_claims;
+
+	size_t m_pattern_count = 0;
+	size_t m_claim_count = 0;
+	size_t m_detected_count = 0;
+};
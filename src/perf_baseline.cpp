@@ -0,0 +1,173 @@
+#include "perf_baseline.h"
+
+#include "util/log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+
+static const char* get_kind_name(PerfMetric::Kind kind)
+{
+	switch (kind) {
+		case PerfMetric::Kind::Time:
+			return "time";
+		case PerfMetric::Kind::Count:
+			return "count";
+		case PerfMetric::Kind::Exact:
+			return "exact";
+	}
+	return "?";
+}
+
+PerfMetric make_perf_metric(PerfMetric::Kind kind, const std::string& name, const std::vector<double>& values)
+{
+	PerfMetric metric;
+	metric.kind = kind;
+	metric.name = name;
+	metric.samples = values.size();
+	for (double value : values) {
+		metric.mean += value;
+	}
+	if (!values.empty()) {
+		metric.mean /= values.size();
+	}
+	if (values.size() > 1) {
+		for (double value : values) {
+			metric.stddev += (value - metric.mean) * (value - metric.mean);
+		}
+		metric.stddev = std::sqrt(metric.stddev / (values.size() - 1));
+	}
+	return metric;
+}
+
+bool read_perf_metrics(std::istream& is, std::vector<PerfMetric>& metrics)
+{
+	size_t line_number = 0;
+	for (std::string line; std::getline(is, line);) {
+		++line_number;
+		line = line.substr(0, line.find('#'));
+		if (line.find_first_not_of(" \t\r") == std::string::npos) {
+			continue;
+		}
+
+		std::istringstream ls(line);
+		std::string kind;
+		PerfMetric metric;
+		if (!(ls >> kind >> metric.name >> metric.mean >> metric.stddev >> metric.samples)) {
+			log_error() << "invalid metric on line" << line_number;
+			return false;
+		}
+		if (kind == "time") {
+			metric.kind = PerfMetric::Kind::Time;
+		} else if (kind == "count") {
+			metric.kind = PerfMetric::Kind::Count;
+		} else if (kind == "exact") {
+			metric.kind = PerfMetric::Kind::Exact;
+		} else {
+			log_error() << "unknown metric kind" << kind << "on line" << line_number;
+			return false;
+		}
+		metrics.push_back(metric);
+	}
+	return true;
+}
+
+void write_perf_metrics(std::ostream& os, const std::vector<PerfMetric>& metrics)
+{
+	os << std::setprecision(std::numeric_limits<double>::max_digits10);
+	for (const PerfMetric& metric : metrics) {
+		os << get_kind_name(metric.kind) << " " << metric.name << " " << metric.mean << " " << metric.stddev << " " << metric.samples << "\n";
+	}
+}
+
+// One-sided critical value of Student's t distribution at the 1% level
+static double get_t_critical_value(double degrees_of_freedom)
+{
+	static const std::pair<double, double> table[] = {
+		{1, 31.821}, {2, 6.965}, {3, 4.541}, {4, 3.747}, {5, 3.365}, {6, 3.143}, {7, 2.998}, {8, 2.896},
+		{9, 2.821}, {10, 2.764}, {15, 2.602}, {20, 2.528}, {30, 2.457}, {60, 2.390}, {120, 2.358},
+	};
+	// Value of the next smaller tabulated degrees of freedom, which is conservative
+	double critical = table[0].second;
+	for (const auto& entry : table) {
+		if (entry.first <= degrees_of_freedom) {
+			critical = entry.second;
+		}
+	}
+	return critical;
+}
+
+// Welch's t-test that current mean is greater than baseline mean
+static bool is_significantly_greater(const PerfMetric& baseline, const PerfMetric& current)
+{
+	// Without repeated runs only the relative threshold applies
+	if (baseline.samples < 2 || current.samples < 2) {
+		return true;
+	}
+	double baseline_var = baseline.stddev * baseline.stddev / baseline.samples;
+	double current_var = current.stddev * current.stddev / current.samples;
+	double variance = baseline_var + current_var;
+	if (variance <= 0) {
+		return current.mean > baseline.mean;
+	}
+	double t = (current.mean - baseline.mean) / std::sqrt(variance);
+	double degrees_of_freedom = variance * variance
+		/ (baseline_var * baseline_var / (baseline.samples - 1) + current_var * current_var / (current.samples - 1));
+	return t > get_t_critical_value(degrees_of_freedom);
+}
+
+static PerfComparison::Result compare_metric(const PerfMetric& baseline, const PerfMetric& current, double min_relative_change,
+	double min_absolute_change)
+{
+	if (baseline.kind == PerfMetric::Kind::Exact) {
+		return baseline.mean == current.mean ? PerfComparison::Result::Same : PerfComparison::Result::Regression;
+	}
+
+	double threshold = baseline.mean * min_relative_change;
+	if (baseline.kind == PerfMetric::Kind::Time) {
+		threshold = std::max(threshold, min_absolute_change);
+	}
+	if (current.mean > baseline.mean + threshold) {
+		if (baseline.kind == PerfMetric::Kind::Count || is_significantly_greater(baseline, current)) {
+			return PerfComparison::Result::Regression;
+		}
+	} else if (current.mean < baseline.mean - threshold) {
+		if (baseline.kind == PerfMetric::Kind::Count || is_significantly_greater(current, baseline)) {
+			return PerfComparison::Result::Improvement;
+		}
+	}
+	return PerfComparison::Result::Same;
+}
+
+std::vector<PerfComparison> compare_perf_metrics(const std::vector<PerfMetric>& baseline, const std::vector<PerfMetric>& current,
+	double min_relative_change, double min_absolute_change)
+{
+	std::vector<PerfComparison> comparisons;
+	for (const PerfMetric& base : baseline) {
+		PerfComparison comparison;
+		comparison.name = base.name;
+		comparison.baseline = base.mean;
+		auto it = std::find_if(current.begin(), current.end(), [&base](const PerfMetric& metric) { return metric.name == base.name; });
+		if (it == current.end()) {
+			comparison.result = PerfComparison::Result::Missing;
+		} else {
+			comparison.current = it->mean;
+			comparison.relative_change = base.mean ? (it->mean - base.mean) / base.mean : 0;
+			comparison.result = compare_metric(base, *it, min_relative_change, min_absolute_change);
+		}
+		comparisons.push_back(comparison);
+	}
+	for (const PerfMetric& metric : current) {
+		auto it = std::find_if(baseline.begin(), baseline.end(), [&metric](const PerfMetric& base) { return base.name == metric.name; });
+		if (it == baseline.end()) {
+			PerfComparison comparison;
+			comparison.name = metric.name;
+			comparison.result = PerfComparison::Result::New;
+			comparison.current = metric.mean;
+			comparisons.push_back(comparison);
+		}
+	}
+	return comparisons;
+}
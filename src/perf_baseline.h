@@ -0,0 +1,57 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Measurements stored by atpgPerfGate and compared against later runs.
+// Stored as text with one metric per line, '#' starts a comment:
+// 	<kind> <name> <mean> <stddev> <samples>
+// e.g. "time c432.bench/solve_us 81234.5 1520.2 5" or "exact c432.bench/detected 520 0 1"
+struct PerfMetric
+{
+	enum class Kind
+	{
+		Time, // noisy, lower is better, compared with a significance test over samples
+		Count, // deterministic, lower is better (aborts, patterns)
+		Exact, // deterministic, any change is a regression (fault classification, netlist hash)
+	};
+
+	Kind kind = Kind::Time;
+	std::string name;
+	double mean = 0;
+	double stddev = 0;
+	size_t samples = 0;
+};
+
+// Mean and sample standard deviation of values
+PerfMetric make_perf_metric(PerfMetric::Kind kind, const std::string& name, const std::vector<double>& values);
+
+bool read_perf_metrics(std::istream& is, std::vector<PerfMetric>& metrics);
+void write_perf_metrics(std::ostream& os, const std::vector<PerfMetric>& metrics);
+
+struct PerfComparison
+{
+	enum class Result
+	{
+		Same,
+		Regression,
+		Improvement,
+		Missing, // in baseline only, fails atpgPerfGate like a regression
+		New, // in current run only
+	};
+
+	std::string name;
+	Result result = Result::Same;
+	double baseline = 0; // means
+	double current = 0;
+	double relative_change = 0; // (current - baseline) / baseline
+};
+
+// Times regress when the mean grew by more than min_relative_change and min_absolute_change and one-sided
+// Welch's t-test gives significance at the 1% level, so both a real slowdown and enough samples to show it are needed.
+// The absolute limit keeps very short phases, whose times shift between processes, from failing the gate.
+// Counts regress when they grew by more than min_relative_change (or at all from 0), exact values when they differ.
+std::vector<PerfComparison> compare_perf_metrics(const std::vector<PerfMetric>& baseline, const std::vector<PerfMetric>& current,
+	double min_relative_change, double min_absolute_change = 0);
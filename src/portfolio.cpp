@@ -0,0 +1,73 @@
+#include "portfolio.h"
+
+#include "util/trace.h"
+
+#include <mutex>
+#include <thread>
+
+std::vector<SolverConfig> make_portfolio_configs(size_t count)
+{
+	std::vector<SolverConfig> configs = {
+		{"shuffle", {{"shuffle", 1}, {"shufflerandom", 1}, {"seed", 4}}},
+		{"sat", {{"stabilizeonly", 1}, {"elimreleff", 10}, {"subsumereleff", 60}}},
+		{"unsat", {{"stabilize", 0}, {"walk", 0}}},
+		{"rephase", {{"rephase", 1}, {"restartint", 2}}},
+		{"phase0", {{"phase", 0}, {"seed", 1}}},
+		{"noinprocessing", {{"elim", 0}, {"subsume", 0}, {"probe", 0}, {"vivify", 0}}},
+		{"luby", {{"reluctant", 256}, {"restartint", 100}, {"seed", 2}}},
+		{"chrono", {{"chrono", 2}, {"seed", 3}}},
+	};
+	if (count < configs.size()) {
+		configs.resize(count);
+	}
+	return configs;
+}
+
+PortfolioSolver::PortfolioSolver(const std::vector<SolverConfig>& configs)
+	: m_configs(configs)
+	, m_wins(configs.size(), 0)
+	, m_stop(false)
+{
+	for (const SolverConfig& config : m_configs) {
+		m_solvers.push_back(SolverFactory::make_solver());
+		// Unsupported options are logged by the solver, the configuration runs without them
+		for (const auto& option : config.options) {
+			m_solvers.back()->set_option(option.first, option.second);
+		}
+		m_solvers.back()->set_terminate_flag(&m_stop);
+	}
+}
+
+SatSolver::SolveStatus PortfolioSolver::solve(const Cnf& cnf)
+{
+	m_stop = false;
+
+	std::mutex mutex;
+	SatSolver::SolveStatus status = SatSolver::Unknown;
+	auto solve_with = [&](size_t index) {
+		TRACE_THREAD_NAME("portfolio " + m_configs[index].name);
+		SatSolver::SolveStatus solver_status = m_solvers[index]->solve(cnf);
+		if (solver_status == SatSolver::Unknown) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		if (status == SatSolver::Unknown) {
+			status = solver_status;
+			m_winner = index;
+			m_stop = true;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < m_solvers.size(); ++i) {
+		threads.emplace_back(solve_with, i);
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	if (status != SatSolver::Unknown) {
+		++m_wins[m_winner];
+	}
+	return status;
+}
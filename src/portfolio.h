@@ -0,0 +1,45 @@
+#pragma once
+
+#include "cnf.h"
+#include "sat/sat_solver.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct SolverConfig
+{
+	std::string name;
+	std::vector<std::pair<std::string, int>> options; // applied on top of solver defaults
+};
+
+// Differently configured solvers. None of them keeps plain solver defaults,
+// the budgeted solve before the portfolio already ran that search.
+std::vector<SolverConfig> make_portfolio_configs(size_t count);
+
+// Solves the same CNF with several solver configurations in parallel threads,
+// the first definite answer wins and other solvers are stopped
+class PortfolioSolver
+{
+public:
+	PortfolioSolver(const std::vector<SolverConfig>& configs);
+
+	SatSolver::SolveStatus solve(const Cnf& cnf);
+
+	// Solver that gave the last Sat or Unsat answer
+	SatSolver& get_winner() { return *m_solvers[m_winner]; }
+	size_t get_winner_index() const { return m_winner; }
+
+	const std::vector<SolverConfig>& get_configs() const { return m_configs; }
+	// Number of won solves for every config
+	const std::vector<size_t>& get_wins() const { return m_wins; }
+
+private:
+	std::vector<SolverConfig> m_configs;
+	std::vector<std::unique_ptr<SatSolver>> m_solvers;
+	std::vector<size_t> m_wins;
+	std::atomic<bool> m_stop;
+	size_t m_winner = 0;
+};
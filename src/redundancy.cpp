@@ -0,0 +1,52 @@
+#include "redundancy.h"
+
+#include "circuit_to_cnf.h"
+
+#include "util/trace.h"
+
+RedundancyAnalyzer::RedundancyAnalyzer(const CircuitGraph& circuit)
+	: m_engine(circuit)
+	, m_post_dominators(make_immediate_post_dominators(circuit))
+	, m_lines(circuit.line_id_end(), nullptr)
+{
+	for (const Line& line : circuit.get_lines()) {
+		m_lines[line.id] = &line;
+	}
+}
+
+void RedundancyAnalyzer::add_constants(const std::vector<clause_t>& learned_clauses)
+{
+	for (const clause_t& clause : learned_clauses) {
+		if (clause.size() != 1) {
+			continue;
+		}
+		const Line* line = m_lines[literal_to_line(clause.front())];
+		size_t trail_size = m_engine.get_trail_size();
+		if (line && !m_engine.assign(line, clause.front() > 0)) {
+			m_engine.backtrack(trail_size);
+		}
+	}
+}
+
+bool RedundancyAnalyzer::is_redundant(const Fault& fault)
+{
+	TRACE_SCOPE("implications");
+	FanoutConeInfo fanout_cone = make_fanout_cone(fault);
+	if (fanout_cone.primary_outputs_inside.empty()) {
+		return true;
+	}
+
+	size_t trail_size = m_engine.get_trail_size();
+	bool conflict = !m_engine.assign(fault.line, !fault.stuck_at);
+	if (!conflict) {
+		UniqueSensitization sensitization = make_unique_sensitization(fault, fanout_cone, m_post_dominators);
+		for (const auto& side_input : sensitization.side_inputs) {
+			if (!m_engine.assign(side_input.first, side_input.second)) {
+				conflict = true;
+				break;
+			}
+		}
+	}
+	m_engine.backtrack(trail_size);
+	return conflict;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "fault_cnf.h"
+#include "implication.h"
+
+#include <vector>
+
+// FIRE-style identification of redundant faults without SAT solving.
+// Every test of a fault activates it (fault line has value opposite to stuck-at value)
+// and sets side inputs of lines dominating the fault site to non-controlling values.
+// If direct implications of these mandatory assignments conflict, no test exists.
+class RedundancyAnalyzer
+{
+public:
+	RedundancyAnalyzer(const CircuitGraph& circuit);
+
+	// Constant lines, e.g. found by static learning, make more conflicts visible
+	void add_constants(const std::vector<clause_t>& learned_clauses);
+
+	// true means fault is undetectable, false means nothing is known
+	bool is_redundant(const Fault& fault);
+
+private:
+	ImplicationEngine m_engine;
+	std::vector<const Line*> m_post_dominators;
+	std::vector<const Line*> m_lines;
+};
@@ -2,13 +2,66 @@
 
 #include "../util/timer.h"
 #include "../util/log.h"
+#include "../util/trace.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpedantic"
 #include <cadical.hpp>
 #pragma GCC diagnostic pop
 
+#include <algorithm>
 #include <cassert>
+#include <cstdlib>
+#include <limits>
+
+// Every conflict gives one learned clause, so the learner also counts conflicts
+class CadicalLearner : public CaDiCaL::Learner
+{
+public:
+	CadicalLearner(LearnedClauseListener* listener, uint64_t* conflicts)
+		: m_listener(listener)
+		, m_conflicts(conflicts)
+	{}
+
+	bool learning(int size) override
+	{
+		if (m_conflicts) {
+			++*m_conflicts;
+		}
+		return m_listener && static_cast<size_t>(size) <= m_listener->get_max_clause_size();
+	}
+
+	void learn(int lit) override
+	{
+		if (lit) {
+			m_clause.push_back(lit);
+			return;
+		}
+		m_listener->on_learned_clause(m_clause);
+		m_clause.clear();
+	}
+
+private:
+	LearnedClauseListener* m_listener;
+	uint64_t* m_conflicts;
+	clause_t m_clause;
+};
+
+class CadicalTerminator : public CaDiCaL::Terminator
+{
+public:
+	CadicalTerminator(const std::atomic<bool>& flag)
+		: m_flag(flag)
+	{}
+
+	bool terminate() override
+	{
+		return m_flag.load(std::memory_order_relaxed);
+	}
+
+private:
+	const std::atomic<bool>& m_flag;
+};
 
 CadicalSolver::CadicalSolver()
 {
@@ -19,25 +72,16 @@ CadicalSolver::SolveStatus CadicalSolver::solve(const Cnf& cnf)
 {
 	reset_solver();
 	for (const auto& clause : cnf.get_clauses()) {
-		for (literal_t l : clause) {
-			m_solver->add(l);
-		}
-		m_solver->add(0);
+		add_clause(clause);
 	}
 
-	int cadical_status = m_solver->solve();
-
-	SolveStatus status = SolveStatus::Unknown;
-	if (cadical_status == 10)
-		status = SolveStatus::Sat;
-	else if (cadical_status == 20)
-		status = SolveStatus::Unsat;
-	return status;
+	return run_solver();
 }
 
 void CadicalSolver::set_max_lit(literal_t lit)
 {
-	m_solver->init(lit);
+	m_solver->reserve(lit);
+	m_max_var = std::max(m_max_var, lit);
 }
 
 void CadicalSolver::reset()
@@ -47,8 +91,10 @@ void CadicalSolver::reset()
 
 void CadicalSolver::add_clause(const clause_t& clause)
 {
+	++m_clause_count;
 	for (literal_t l : clause) {
 		m_solver->add(l);
+		m_max_var = std::max(m_max_var, std::abs(l));
 	}
 	m_solver->add(0);
 }
@@ -56,13 +102,16 @@ void CadicalSolver::add_clause(const clause_t& clause)
 void CadicalSolver::add_clause(literal_t l1, literal_t l2, literal_t l3, literal_t l4, literal_t l5)
 {
 	assert(l1);
+	++m_clause_count;
 	m_solver->add(l1);
+	m_max_var = std::max(m_max_var, std::abs(l1));
 
 	for (literal_t l : {l2, l3, l4, l5}) {
 		if (!l)
 			break;
 
 		m_solver->add(l);
+		m_max_var = std::max(m_max_var, std::abs(l));
 	}
 
 	m_solver->add(0);
@@ -70,6 +119,16 @@ void CadicalSolver::add_clause(literal_t l1, literal_t l2, literal_t l3, literal
 
 CadicalSolver::SolveStatus CadicalSolver::solve_prepared()
 {
+	return run_solver();
+}
+
+CadicalSolver::SolveStatus CadicalSolver::run_solver()
+{
+	TRACE_SCOPE("solve");
+	if (m_conflict_limit >= 0) {
+		m_solver->limit("conflicts", static_cast<int>(std::min<int64_t>(m_conflict_limit, std::numeric_limits<int>::max())));
+	}
+	m_conflicts = 0;
 	int cadical_status = m_solver->solve();
 
 	SolveStatus status = SolveStatus::Unknown;
@@ -80,18 +139,90 @@ CadicalSolver::SolveStatus CadicalSolver::solve_prepared()
 	return status;
 }
 
+void CadicalSolver::assume(literal_t l)
+{
+	m_solver->assume(l);
+	m_max_var = std::max(m_max_var, std::abs(l));
+}
+
+void CadicalSolver::set_learned_clause_listener(LearnedClauseListener* listener)
+{
+	m_listener = listener;
+	update_learner();
+}
+
+void CadicalSolver::set_count_conflicts(bool enabled)
+{
+	m_count_conflicts = enabled;
+	m_conflicts = 0;
+	update_learner();
+}
+
+void CadicalSolver::update_learner()
+{
+	if (m_learner) {
+		m_solver->disconnect_learner();
+		m_learner.reset();
+	}
+	if (m_listener || m_count_conflicts) {
+		m_learner = std::make_shared<CadicalLearner>(m_listener, m_count_conflicts ? &m_conflicts : nullptr);
+		m_solver->connect_learner(m_learner.get());
+	}
+}
+
+bool CadicalSolver::set_option(const std::string& name, int value)
+{
+	if (!m_solver->set(name.c_str(), value)) {
+		log_error() << "unknown CaDiCaL option" << name;
+		return false;
+	}
+	m_options.emplace_back(name, value);
+	return true;
+}
+
+void CadicalSolver::set_conflict_limit(int64_t conflicts)
+{
+	m_conflict_limit = conflicts;
+}
+
+void CadicalSolver::set_terminate_flag(const std::atomic<bool>* flag)
+{
+	if (m_terminator) {
+		m_solver->disconnect_terminator();
+		m_terminator.reset();
+	}
+	if (flag) {
+		m_terminator = std::make_shared<CadicalTerminator>(*flag);
+		m_solver->connect_terminator(m_terminator.get());
+	}
+}
 
 int8_t CadicalSolver::get_value(literal_t l)
 {
-	return m_solver->val(l);
+	if (std::abs(l) > m_max_var) {
+		// Variable is not used in the formula, any value will do
+		return 0;
+	}
+	return m_solver->val(l) > 0 ? 1 : -1;
 }
 
 void CadicalSolver::reset_solver()
 {
 	m_solver.reset(new CaDiCaL::Solver());
+	if (m_learner) {
+		m_solver->connect_learner(m_learner.get());
+	}
+	m_max_var = 0;
+	m_clause_count = 0;
 	assert(m_solver);
 	m_solver->set("quiet", true);
 	m_solver->set("rephase", false);
 	m_solver->set("profile", 0);
 	m_solver->set("restartint", 400);
+	for (const auto& option : m_options) {
+		m_solver->set(option.first.c_str(), option.second);
+	}
+	if (m_terminator) {
+		m_solver->connect_terminator(m_terminator.get());
+	}
 }
@@ -3,12 +3,18 @@
 #include "sat_solver.h"
 
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace CaDiCaL
 {
 	class Solver;
 }
 
+class CadicalLearner;
+class CadicalTerminator;
+
 class CadicalSolver : public SatSolver
 {
 public:
@@ -21,11 +27,31 @@ public:
 	void add_clause(const clause_t& clause) override;
 	void add_clause(literal_t l1, literal_t l2 = 0, literal_t l3 = 0, literal_t l4 = 0, literal_t l5 = 0) override;
 	SolveStatus solve_prepared() override;
+	void assume(literal_t l) override;
+	void set_learned_clause_listener(LearnedClauseListener* listener) override;
+	bool set_option(const std::string& name, int value) override;
+	void set_conflict_limit(int64_t conflicts) override;
+	void set_terminate_flag(const std::atomic<bool>* flag) override;
+	void set_count_conflicts(bool enabled) override;
+	uint64_t get_conflicts() const override { return m_conflicts; }
+	size_t get_clause_count() const override { return m_clause_count; }
+	literal_t get_max_var() const override { return m_max_var; }
 
 	int8_t get_value(literal_t l) override;
 
 private:
 	void reset_solver();
+	SolveStatus run_solver();
+	void update_learner();
 
 	std::shared_ptr<CaDiCaL::Solver> m_solver;
+	std::shared_ptr<CadicalLearner> m_learner;
+	std::shared_ptr<CadicalTerminator> m_terminator;
+	std::vector<std::pair<std::string, int>> m_options;
+	int64_t m_conflict_limit = -1;
+	LearnedClauseListener* m_listener = nullptr;
+	bool m_count_conflicts = false;
+	uint64_t m_conflicts = 0;
+	size_t m_clause_count = 0;
+	literal_t m_max_var = 0;
 };
@@ -2,11 +2,26 @@
 
 #include "../cnf.h"
 
+#include <atomic>
 #include <memory>
+#include <string>
+
+// Receives clauses learned by the solver during solving
+class LearnedClauseListener
+{
+public:
+	virtual ~LearnedClauseListener() = default;
+
+	// Longer clauses are not reported
+	virtual size_t get_max_clause_size() const = 0;
+	virtual void on_learned_clause(const clause_t& clause) = 0;
+};
 
 class SatSolver
 {
 public:
+	virtual ~SatSolver() = default;
+
 	enum SolveStatus
 	{
 		Sat,
@@ -21,6 +36,31 @@ public:
 	virtual void add_clause(literal_t l1, literal_t l2 = 0, literal_t l3 = 0, literal_t l4 = 0, literal_t l5 = 0) = 0;
 	virtual SolveStatus solve_prepared() = 0;
 
+	// Literal is assumed true only for the next solve_prepared() call
+	virtual void assume(literal_t l) = 0;
+
+	// Solver specific option (e.g. CaDiCaL "restartint"), kept after reset(). Returns false and logs an error for unknown option.
+	virtual bool set_option(const std::string& name, int value) = 0;
+
+	// Every solve returns Unknown after this many conflicts, negative means no limit
+	virtual void set_conflict_limit(int64_t conflicts) = 0;
+
+	// Solving stops with Unknown when flag becomes true, flag can be set from another thread
+	virtual void set_terminate_flag(const std::atomic<bool>* flag) = 0;
+
+	// Listener must outlive the solver or be reset with nullptr, it is kept after reset()
+	virtual void set_learned_clause_listener(LearnedClauseListener* listener) = 0;
+
+	// Conflicts are counted by learned clauses, which costs a callback per conflict, so it is off by default
+	virtual void set_count_conflicts(bool enabled) = 0;
+	// Conflicts of the last solve, 0 if counting is off
+	virtual uint64_t get_conflicts() const = 0;
+
+	// Clauses added and highest variable since the last reset
+	virtual size_t get_clause_count() const = 0;
+	virtual literal_t get_max_var() const = 0;
+
+	// 1 or -1 for true and false, 0 if the variable is not constrained by the formula
 	virtual int8_t get_value(literal_t l) = 0;
 };
 
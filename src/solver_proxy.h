@@ -3,6 +3,10 @@
 #include "cnf.h"
 #include "sat/sat_solver.h"
 
+#include "util/trace.h"
+
+#include <cassert>
+
 class ProxyCnf : public ICnf
 {
 public:
@@ -12,6 +16,7 @@ public:
 
 	ICnf& operator=(const Cnf& other) override final
 	{
+		TRACE_SCOPE("solver add");
 		m_solver.reset();
 		for (const auto& clause : other.get_clauses()) {
 			m_solver.add_clause(clause);
@@ -50,3 +55,60 @@ private:
 	SatSolver& m_solver;
 };
 
+// Adds guard literal to every clause: clauses are active only while -guard is false,
+// e.g. when guard is assumed for solving, and are disabled forever by adding unit clause -guard
+class GuardedCnf : public ICnf
+{
+public:
+	GuardedCnf(ICnf& cnf, literal_t guard)
+		: m_cnf(cnf)
+		, m_guard(guard)
+	{}
+
+	ICnf& operator=(const Cnf& other) override final
+	{
+		for (const auto& clause : other.get_clauses()) {
+			add_clause(clause);
+		}
+		return *this;
+	}
+
+	void reserve(size_t size) override final
+	{
+		m_cnf.reserve(size);
+	}
+
+	void clear() override final
+	{
+		// Guarded clauses can't be removed, only disabled
+		assert(false);
+	}
+
+	void add_clause(clause_t clause) override final
+	{
+		clause.push_back(-m_guard);
+		m_cnf.add_clause(std::move(clause));
+	}
+
+	void add_clause(literal_t l1, literal_t l2 = 0, literal_t l3 = 0, literal_t l4 = 0, literal_t l5 = 0) override final
+	{
+		if (!l5) {
+			literal_t* first_empty = !l2 ? &l2 : !l3 ? &l3 : !l4 ? &l4 : &l5;
+			*first_empty = -m_guard;
+			m_cnf.add_clause(l1, l2, l3, l4, l5);
+			return;
+		}
+		add_clause(clause_t{l1, l2, l3, l4, l5});
+	}
+
+	void add_clauses(std::vector<clause_t>& from) override final
+	{
+		for (auto& clause : from) {
+			add_clause(std::move(clause));
+		}
+	}
+
+private:
+	ICnf& m_cnf;
+	literal_t m_guard = 0;
+};
@@ -0,0 +1,155 @@
+#include "static_learning.h"
+
+#include "circuit_to_cnf.h"
+
+#include "util/log.h"
+#include "util/trace.h"
+
+#include <algorithm>
+
+using Assignment = ImplicationEngine::Assignment;
+
+static literal_t assignment_to_literal(const Assignment& assignment)
+{
+	literal_t lit = line_to_literal(assignment.line->id);
+	return assignment.value ? lit : -lit;
+}
+
+StaticLearner::StaticLearner(const CircuitGraph& circuit)
+	: m_circuit(circuit)
+	, m_engine(circuit)
+{}
+
+std::vector<clause_t> StaticLearner::learn()
+{
+	TRACE_SCOPE("static learning");
+	m_clauses.clear();
+	m_known_clauses.clear();
+	m_constant_lines = 0;
+
+	std::vector<Assignment> direct;
+	std::vector<Assignment> indirect;
+	for (const Line& line : m_circuit.get_lines()) {
+		for (int8_t value : {0, 1}) {
+			if (out_of_budget()) {
+				log_info() << "Static learning stopped after" << m_engine.get_assignment_count() << "assignments";
+				return m_clauses;
+			}
+			if (m_engine.get_value(&line) != ImplicationEngine::unknown) {
+				continue;
+			}
+
+			if (!collect_implications(&line, value, direct, indirect)) {
+				// Constant lines stay assigned for the rest of learning
+				Assignment constant = {&line, static_cast<int8_t>(!value)};
+				m_clauses.push_back({assignment_to_literal(constant)});
+				++m_constant_lines;
+				size_t trail_size = m_engine.get_trail_size();
+				if (!m_engine.assign(&line, !value)) {
+					m_engine.backtrack(trail_size);
+				}
+				break;
+			}
+
+			Assignment from = {&line, value};
+			for (const Assignment& to : direct) {
+				add_implication(from, to, true);
+			}
+			for (const Assignment& to : indirect) {
+				add_implication(from, to, false);
+			}
+		}
+	}
+	return m_clauses;
+}
+
+bool StaticLearner::collect_implications(const Line* line, int8_t value, std::vector<Assignment>& direct, std::vector<Assignment>& indirect)
+{
+	direct.clear();
+	indirect.clear();
+	size_t trail_begin = m_engine.get_trail_size();
+	bool possible = m_engine.assign(line, value);
+	if (possible) {
+		direct.assign(m_engine.get_trail().begin() + trail_begin + 1, m_engine.get_trail().end());
+		if (m_recursive) {
+			possible = add_recursive_implications(trail_begin, indirect);
+		}
+	}
+	m_engine.backtrack(trail_begin);
+	return possible;
+}
+
+bool StaticLearner::add_recursive_implications(size_t trail_begin, std::vector<Assignment>& indirect)
+{
+	// Copy, because trail changes while justifications are tried
+	std::vector<Assignment> assigned(m_engine.get_trail().begin() + trail_begin, m_engine.get_trail().end());
+	std::vector<Assignment> common;
+	for (const Assignment& assignment : assigned) {
+		const Gate* gate = assignment.line->source;
+		if (!gate || !m_engine.is_unjustified(*gate)) {
+			continue;
+		}
+
+		int8_t controlling;
+		int8_t inversion;
+		get_controlling_value(gate->get_type(), controlling, inversion);
+
+		bool any_justification = false;
+		for (const Line* input : gate->get_inputs()) {
+			if (m_engine.get_value(input) != ImplicationEngine::unknown) {
+				continue;
+			}
+			size_t trail_size = m_engine.get_trail_size();
+			if (m_engine.assign(input, controlling)) {
+				if (!any_justification) {
+					common.assign(m_engine.get_trail().begin() + trail_size, m_engine.get_trail().end());
+				} else {
+					auto is_not_implied = [this](const Assignment& a) { return m_engine.get_value(a.line) != a.value; };
+					common.erase(std::remove_if(common.begin(), common.end(), is_not_implied), common.end());
+				}
+				any_justification = true;
+			}
+			m_engine.backtrack(trail_size);
+		}
+
+		if (!any_justification) {
+			return false;
+		}
+		indirect.insert(indirect.end(), common.begin(), common.end());
+	}
+	return true;
+}
+
+bool StaticLearner::is_directly_implied(const Assignment& from, const Assignment& to)
+{
+	size_t trail_size = m_engine.get_trail_size();
+	bool implied = !m_engine.assign(from.line, from.value) || m_engine.get_value(to.line) == to.value;
+	m_engine.backtrack(trail_size);
+	return implied;
+}
+
+void StaticLearner::add_implication(const Assignment& from, const Assignment& to, bool is_direct)
+{
+	if (to.line == from.line) {
+		return;
+	}
+
+	// Clause -from | to is the same for the implication and its contrapositive
+	literal_t a = -assignment_to_literal(from);
+	literal_t b = assignment_to_literal(to);
+	uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(std::min(a, b))) << 32) | static_cast<uint32_t>(std::max(a, b));
+	if (!m_known_clauses.insert(key).second) {
+		return;
+	}
+
+	Assignment contrapositive_from = {to.line, static_cast<int8_t>(!to.value)};
+	Assignment contrapositive_to = {from.line, static_cast<int8_t>(!from.value)};
+	if (!is_direct || !is_directly_implied(contrapositive_from, contrapositive_to)) {
+		m_clauses.push_back({a, b});
+	}
+}
+
+bool StaticLearner::out_of_budget() const
+{
+	return m_max_assignments && m_engine.get_assignment_count() > m_max_assignments;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "circuit_graph.h"
+#include "cnf.h"
+#include "implication.h"
+
+#include <unordered_set>
+#include <vector>
+
+// SOCRATES-style static learning: indirect implications of the good circuit as binary clauses.
+// For every line assignment a=v each implied b=w gives the contrapositive b=!w -> a=!v,
+// it is learned if direct implication of b=!w doesn't find it. Assignments that lead to a conflict
+// give constant lines (unit clauses). With recursive learning, implications common to all
+// justifications of unjustified gates are learned as well (one level).
+// Learned clauses are implied by the circuit, so they can be added to any CNF containing their lines.
+class StaticLearner
+{
+public:
+	StaticLearner(const CircuitGraph& circuit);
+
+	void set_recursive_learning(bool enabled) { m_recursive = enabled; }
+
+	// Learning stops when this many line assignments were made, 0 means no limit
+	void set_max_assignments(uint64_t max_assignments) { m_max_assignments = max_assignments; }
+
+	std::vector<clause_t> learn();
+
+	size_t get_constant_lines() const { return m_constant_lines; }
+
+private:
+	// Direct and recursively learned implications of line=value, false if the assignment is impossible
+	bool collect_implications(const Line* line, int8_t value, std::vector<ImplicationEngine::Assignment>& direct,
+		std::vector<ImplicationEngine::Assignment>& indirect);
+	bool add_recursive_implications(size_t trail_begin, std::vector<ImplicationEngine::Assignment>& indirect);
+	bool is_directly_implied(const ImplicationEngine::Assignment& from, const ImplicationEngine::Assignment& to);
+	void add_implication(const ImplicationEngine::Assignment& from, const ImplicationEngine::Assignment& to, bool is_direct);
+	bool out_of_budget() const;
+
+	const CircuitGraph& m_circuit;
+	ImplicationEngine m_engine;
+	bool m_recursive = false;
+	uint64_t m_max_assignments = 0;
+
+	std::vector<clause_t> m_clauses;
+	std::unordered_set<uint64_t> m_known_clauses;
+	size_t m_constant_lines = 0;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+// Netlists of small benchmark circuits shared by tests and benchmarks
+
+inline const char* get_c17_bench()
+{
+	return R"r(
+		# c17
+		# 5 inputs
+		# 2 outputs
+		# 0 inverter
+		# 6 gates ( 6 NANDs )
+		INPUT(1)
+		INPUT(2)
+		INPUT(3)
+		INPUT(6)
+		INPUT(7)
+
+		OUTPUT(22)
+		OUTPUT(23)
+
+		10 = NAND(1, 3)
+		11 = NAND(3, 6)
+		16 = NAND(2, 11)
+		19 = NAND(11, 7)
+		22 = NAND(10, 16)
+		23 = NAND(16, 19)
+)r";
+}
+
+inline const char* get_s27_bench()
+{
+	return R"r(
+		# s27
+		# 7 inputs
+		# 4 outputs
+		# 2 inverters
+		# 8 gates ( 1 AND + 1 NAND + 2 ORs + 4 NORs + 1 BUFF )
+
+		INPUT(G0)
+		INPUT(G1)
+		INPUT(G2)
+		INPUT(G3)
+		INPUT(G5)
+		INPUT(G6)
+		INPUT(G7)
+
+		OUTPUT(G17)
+		OUTPUT(G10)
+		OUTPUT(G11_EXTRA)
+		OUTPUT(G13)
+
+		G14 = NOT(G0)
+		G17 = NOT(G11)
+		G8 = AND(G14, G6)
+		G15 = OR(G12, G8)
+		G16 = OR(G3, G8)
+		G9 = NAND(G16, G15)
+		G10 = NOR(G14, G11)
+		G11 = NOR(G5, G9)
+		G12 = NOR(G1, G7)
+		G13 = NOR(G2, G12)
+		G11_EXTRA = BUFF(G11)
+)r";
+}
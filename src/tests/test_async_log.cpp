@@ -0,0 +1,57 @@
+#include <catch.hpp>
+
+#include "../util/async_log.h"
+#include "../util/log.h"
+
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+TEST_CASE("async logger writes all records in thread order") {
+	const size_t thread_count = 4;
+	const size_t record_count = 5000;
+
+	std::stringbuf output;
+	std::streambuf* old_output = Logger::get_streambuf();
+	Logger::set_ostream(&output);
+	// Small batches, so records go through the writer thread many times
+	AsyncLogWriter::instance().start(&output, 256);
+
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < thread_count; ++t) {
+		threads.emplace_back([t, record_count]() {
+			for (size_t i = 0; i < record_count; ++i) {
+				log_info() << log_nospace << "thread" << t << " record " << i;
+			}
+		});
+	}
+	log_info() << "from main";
+	AsyncLogWriter::instance().flush();
+	REQUIRE(output.str().find("from main") != std::string::npos);
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+	AsyncLogWriter::instance().stop();
+	REQUIRE_FALSE(AsyncLogWriter::instance().is_running());
+
+	log_info() << "after stop";
+	Logger::set_ostream(old_output);
+
+	std::vector<size_t> next_record(thread_count, 0);
+	std::istringstream lines(output.str());
+	size_t record_lines = 0;
+	for (std::string line; std::getline(lines, line);) {
+		size_t t;
+		size_t i;
+		if (std::sscanf(line.c_str(), "thread%zu record %zu", &t, &i) != 2) {
+			continue;
+		}
+		REQUIRE(t < thread_count);
+		REQUIRE(i == next_record[t]);
+		++next_record[t];
+		++record_lines;
+	}
+	REQUIRE(record_lines == thread_count * record_count);
+	REQUIRE(output.str().find("after stop") != std::string::npos);
+}
@@ -0,0 +1,70 @@
+#include <catch.hpp>
+
+#include "circuits.h"
+#include "../atpg_server.h"
+
+TEST_CASE("server requests") {
+	if (!SolverFactory::make_solver()) {
+		FAIL("This test needs SAT solver to run");
+		return;
+	}
+
+	TestCircuitWithExpandableGates tc;
+	AtpgServer server(tc.graph);
+
+	SECTION("test") {
+		std::string response = server.handle_request("test g16/O S-A-1, y/O S-A-0");
+		CAPTURE(response);
+		REQUIRE(response.find("g16/O S-A-1: UNDETECTABLE\n") != std::string::npos);
+		REQUIRE(response.find("y/O S-A-0: DETECTABLE ") != std::string::npos);
+		REQUIRE(response.substr(response.size() - 3) == "OK\n");
+	}
+
+	SECTION("testable") {
+		REQUIRE(server.handle_request("testable g16/O S-A-1") == "g16/O S-A-1: 0\nOK\n");
+		REQUIRE(server.handle_request("testable no_such_line/O S-A-1") == "no_such_line/O S-A-1: ERROR no such fault\nOK\n");
+	}
+
+	SECTION("solver is rebuilt") {
+		server.set_solver_limits(2, 0);
+		for (size_t i = 0; i < 3; ++i) {
+			REQUIRE(server.handle_request("testable g16/O S-A-1, y/O S-A-0") == "g16/O S-A-1: 0\ny/O S-A-0: 1\nOK\n");
+		}
+		REQUIRE(server.get_solver_rebuilds() == 2);
+		REQUIRE(server.handle_request("stats").find("solver_rebuilds 2\n") != std::string::npos);
+	}
+
+	SECTION("solver options") {
+		REQUIRE(server.set_solver_options({{"phase", 0}}, 100000));
+		REQUIRE(server.handle_request("testable g16/O S-A-1, y/O S-A-0") == "g16/O S-A-1: 0\ny/O S-A-0: 1\nOK\n");
+	}
+
+	SECTION("primary output fault with fanout") {
+		CircuitGraph graph;
+		graph.add_input("a");
+		graph.add_input("b");
+		graph.add_output("x");
+		graph.add_output("y");
+		graph.add_gate(Gate::Type::And, {"a", "b"}, "x");
+		graph.add_gate(Gate::Type::Or, {"x", "b"}, "y");
+		AtpgServer output_server(graph);
+		REQUIRE(output_server.handle_request("faults").find("x/PO S-A-0\n") != std::string::npos);
+		// Stem fault is only observed through y = OR(x, b), which needs b = 0 and so x = 0
+		REQUIRE(output_server.handle_request("testable x/PO S-A-0, x/O S-A-0") == "x/PO S-A-0: 1\nx/O S-A-0: 0\nOK\n");
+	}
+
+	SECTION("n-ary gate encoding") {
+		AtpgServer nary_server(tc.graph, GateEncoding::Nary);
+		REQUIRE(nary_server.handle_request("testable g16/O S-A-1, y/O S-A-0") == "g16/O S-A-1: 0\ny/O S-A-0: 1\nOK\n");
+	}
+
+	SECTION("unknown command") {
+		REQUIRE(server.handle_request("solve everything").compare(0, 5, "ERROR") == 0);
+	}
+
+	SECTION("quit") {
+		REQUIRE(server.handle_request("quit") == "OK\n");
+		REQUIRE(server.is_connection_closed());
+		REQUIRE_FALSE(server.is_shut_down());
+	}
+}
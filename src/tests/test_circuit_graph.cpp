@@ -5,6 +5,8 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
+#include <map>
 #include <sstream>
 
 TEST_CASE("empty circuit")
@@ -192,3 +194,104 @@ TEST_CASE("gate expansion") {
 		}
 	}
 }
+
+// Number of expanded gates between every input of the gate and its output
+static std::vector<size_t> get_leaf_depths(const Gate& gate)
+{
+	const std::vector<Gate*>& expanded = gate.get_expanded();
+	std::vector<size_t> depths(gate.get_inputs().size(), 0);
+	std::map<const Line*, size_t> line_depths = {{gate.get_output(), 0}};
+	for (size_t k = expanded.size(); k-- > 0; ) {
+		size_t depth = line_depths.at(expanded[k]->get_output()) + 1;
+		for (size_t input = 0; input < 2; ++input) {
+			const Line* line = expanded[k]->get_inputs()[input];
+			size_t input_idx = gate.get_expanded_input_idx(k, input);
+			if (input_idx == std::numeric_limits<size_t>::max()) {
+				REQUIRE(line->is_generated);
+				line_depths[line] = depth;
+			} else {
+				REQUIRE(gate.get_inputs()[input_idx] == line);
+				REQUIRE(depths[input_idx] == 0);
+				depths[input_idx] = depth;
+			}
+		}
+	}
+	return depths;
+}
+
+TEST_CASE("balanced and level gate expansion") {
+	CircuitGraph graph;
+	Iscas89Parser parser;
+	std::stringstream ss(R"(
+		INPUT(x0)
+		INPUT(x1)
+		INPUT(x2)
+		INPUT(x3)
+		INPUT(x4)
+		INPUT(x5)
+		INPUT(x6)
+		OUTPUT(z)
+		late1 = NOT(x6)
+		late2 = NOT(late1)
+		z = NAND(x0, x1, x2, x3, x4, x5, late2, x6)
+	)");
+	REQUIRE(parser.parse(ss, graph));
+	const Gate& gate = *graph.get_line("z")->source;
+	REQUIRE(gate.get_expanded().size() == 7);
+	REQUIRE(get_leaf_depths(gate) == std::vector<size_t>{1, 2, 3, 4, 5, 6, 7, 7});
+
+	graph.set_gate_expansion(GateExpansion::Balanced);
+	REQUIRE(get_leaf_depths(gate) == std::vector<size_t>(8, 3));
+	REQUIRE(gate.get_expanded().back()->get_output() == gate.get_output());
+	REQUIRE(gate.get_expanded().back()->get_type() == Gate::Type::Nand);
+	REQUIRE(gate.get_expanded().front()->get_type() == Gate::Type::And);
+
+	// late2 arrives two levels after the other inputs, so it goes close to the output
+	graph.set_gate_expansion(GateExpansion::Level);
+	std::vector<size_t> depths = get_leaf_depths(gate);
+	REQUIRE(depths[6] == 2);
+	REQUIRE(*std::max_element(depths.begin(), depths.end()) == 4);
+
+	graph.set_gate_expansion(GateExpansion::Chain);
+	REQUIRE(get_leaf_depths(gate) == std::vector<size_t>{1, 2, 3, 4, 5, 6, 7, 7});
+}
+
+TEST_CASE("post dominators") {
+	C17Circuit c17;
+	std::vector<const Line*> dominators = make_immediate_post_dominators(c17.graph);
+
+	REQUIRE(dominators[c17.l1->id] == c17.l10);
+	REQUIRE(dominators[c17.l10->id] == c17.l22);
+	REQUIRE(dominators[c17.l22->id] == nullptr);
+	REQUIRE(dominators[c17.l6->id] == c17.l11);
+	REQUIRE(dominators[c17.l7->id] == c17.l19);
+	REQUIRE(dominators[c17.l19->id] == c17.l23);
+
+	// Paths end at different outputs
+	REQUIRE(dominators[c17.l3->id] == nullptr);
+	REQUIRE(dominators[c17.l11->id] == nullptr);
+	REQUIRE(dominators[c17.l16->id] == nullptr);
+}
+
+TEST_CASE("post dominators with reconvergence") {
+	CircuitGraph graph;
+	Iscas89Parser parser;
+	std::stringstream ss(R"(
+		INPUT(a)
+		INPUT(b)
+		OUTPUT(z)
+		OUTPUT(u)
+		c = NOT(a)
+		d = AND(a, b)
+		e = OR(c, d)
+		z = BUFF(e)
+		f = NOT(b)
+		u = BUFF(f)
+	)");
+	REQUIRE(parser.parse(ss, graph));
+
+	std::vector<const Line*> dominators = make_immediate_post_dominators(graph);
+	REQUIRE(dominators[graph.get_line("a")->id] == graph.get_line("e"));
+	REQUIRE(dominators[graph.get_line("e")->id] == graph.get_line("z"));
+	REQUIRE(dominators[graph.get_line("b")->id] == nullptr);
+}
@@ -0,0 +1,37 @@
+#include <catch.hpp>
+
+#include "../clause_pool.h"
+
+TEST_CASE("clause pool") {
+	ClausePool pool(4);
+	std::vector<clause_t> clauses;
+
+	pool.add({1, -2}, 0);
+	pool.add({3}, 1);
+	pool.add({1, 2, 3, 4, 5, 6, 7, 8, 9}, 1); // too long
+
+	SECTION("clauses of the same source are skipped") {
+		uint64_t position = pool.collect(0, 0, clauses);
+		REQUIRE(position == 2);
+		REQUIRE(clauses == std::vector<clause_t>{{3}});
+
+		clauses.clear();
+		position = pool.collect(0, 1, clauses);
+		REQUIRE(clauses == std::vector<clause_t>{{1, -2}});
+
+		SECTION("collecting continues from position") {
+			clauses.clear();
+			pool.add({-4, 5}, 0);
+			REQUIRE(pool.collect(position, 1, clauses) == 3);
+			REQUIRE(clauses == std::vector<clause_t>{{-4, 5}});
+		}
+	}
+
+	SECTION("overwritten clauses are skipped") {
+		for (literal_t l = 10; l < 15; ++l) {
+			pool.add({l}, 0);
+		}
+		REQUIRE(pool.collect(0, 1, clauses) == 7);
+		REQUIRE(clauses == std::vector<clause_t>{{11}, {12}, {13}, {14}});
+	}
+}
@@ -3,10 +3,24 @@
 #include "circuits.h"
 #include "../fault_cnf.h"
 #include "../fault_manager.h"
+#include "../fault_simulator.h"
+#include "../incremental_solver.h"
+#include "../n_detect.h"
+#include "../netlist_generator.h"
+#include "../parallel_solver.h"
+#include "../static_learning.h"
+#include "../redundancy.h"
+#include "../portfolio.h"
+#include "../cube_solver.h"
+#include "../cnf_cost_model.h"
 #include "../util/log.h"
 
 #include "../sat/sat_solver.h"
 
+#include <algorithm>
+#include <bitset>
+#include <numeric>
+#include <set>
 #include <type_traits>
 
 namespace Catch {
@@ -294,3 +308,601 @@ TEST_CASE("duplicate input to gate") {
 		REQUIRE(!is_detectable(fault, graph));
 	}
 }
+
+void require_incremental_matches(const CircuitGraph& graph)
+{
+	FaultManager mgr(graph);
+	FaultCnfMaker maker(graph);
+	auto solver = SolverFactory::make_solver();
+	IncrementalFaultSolver incremental(graph, SolverFactory::make_solver());
+	FaultSimulator simulator(graph);
+
+	while (mgr.has_faults_left()) {
+		Fault f = mgr.next_fault();
+		bool detectable = is_detectable(f, maker, *solver);
+		SatSolver::SolveStatus status = incremental.solve(f);
+		CAPTURE(get_fault_name(f));
+		REQUIRE(status == (detectable ? SatSolver::Sat : SatSolver::Unsat));
+
+		if (detectable) {
+			simulator.load_patterns({incremental.get_pattern()});
+			REQUIRE(simulator.simulate_fault(f) == 1);
+		}
+	}
+}
+
+TEST_CASE("incremental solving gives same results") {
+	if (no_solver()) return;
+
+	SECTION("c17") {
+		C17Circuit c17;
+		require_incremental_matches(c17.graph);
+	}
+
+	SECTION("s27") {
+		S27Circuit s27;
+		require_incremental_matches(s27.graph);
+	}
+
+	SECTION("circuit with expandable gates") {
+		TestCircuitWithExpandableGates tc;
+		require_incremental_matches(tc.graph);
+	}
+}
+
+TEST_CASE("distinct tests of a fault") {
+	if (no_solver()) return;
+
+	C17Circuit c17;
+	FaultManager mgr(c17.graph);
+	IncrementalFaultSolver incremental(c17.graph, SolverFactory::make_solver());
+	FaultSimulator simulator(c17.graph);
+
+	while (mgr.has_faults_left()) {
+		Fault f = mgr.next_fault();
+		CAPTURE(get_fault_name(f));
+
+		std::vector<std::string> patterns;
+		REQUIRE(incremental.solve_distinct(f, {}, 100, patterns) == SatSolver::Unsat);
+		REQUIRE(!patterns.empty());
+		REQUIRE(patterns.size() <= 32);
+		REQUIRE(std::set<std::string>(patterns.begin(), patterns.end()).size() == patterns.size());
+		for (const std::string& pattern : patterns) {
+			simulator.load_patterns({pattern});
+			REQUIRE(simulator.simulate_fault(f) == 1);
+		}
+
+		// All distinct tests were found, blocking them leaves none
+		std::vector<std::string> more;
+		REQUIRE(incremental.solve_distinct(f, patterns, 100, more) == SatSolver::Unsat);
+		REQUIRE(more.empty());
+
+		std::vector<std::string> limited;
+		REQUIRE(incremental.solve_distinct(f, {}, 1, limited) == SatSolver::Sat);
+		REQUIRE(limited.size() == 1);
+	}
+}
+
+TEST_CASE("n-detect patterns") {
+	if (no_solver()) return;
+
+	C17Circuit c17;
+	FaultManager mgr(c17.graph);
+	IncrementalFaultSolver incremental(c17.graph, SolverFactory::make_solver());
+	const size_t n = 3;
+	NDetectGenerator generator(c17.graph, mgr, incremental, n);
+
+	std::vector<size_t> fault_ids;
+	std::vector<std::string> patterns;
+	for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+		REQUIRE(incremental.solve(mgr.get_fault(id)) == SatSolver::Sat);
+		fault_ids.push_back(id);
+		patterns.push_back(incremental.get_pattern());
+		generator.add_pattern(incremental.get_pattern());
+	}
+
+	generator.run(fault_ids, [&](size_t fault_id, const std::string& pattern) {
+		REQUIRE(fault_id < mgr.get_fault_count());
+		patterns.push_back(pattern);
+	});
+	REQUIRE(generator.get_generated_patterns() == patterns.size() - fault_ids.size());
+	REQUIRE(generator.get_n_detected_faults() + generator.get_exhausted_faults() == fault_ids.size());
+	REQUIRE(generator.get_aborted_faults() == 0);
+
+	// Every fault is detected by at least n different patterns or has fewer distinct tests
+	std::sort(patterns.begin(), patterns.end());
+	patterns.erase(std::unique(patterns.begin(), patterns.end()), patterns.end());
+	FaultSimulator simulator(c17.graph);
+	std::vector<size_t> detections(mgr.get_fault_count(), 0);
+	for (size_t first = 0; first < patterns.size(); first += FaultSimulator::patterns_per_pass) {
+		simulator.load_patterns(patterns, first);
+		for (size_t id : fault_ids) {
+			detections[id] += std::bitset<64>(simulator.simulate_fault(mgr.get_fault(id))).count();
+		}
+	}
+	size_t exhausted = 0;
+	for (size_t id : fault_ids) {
+		CAPTURE(get_fault_name(mgr.get_fault(id)));
+		if (generator.get_detections(id) == n) {
+			REQUIRE(detections[id] >= n);
+		} else {
+			std::vector<std::string> all_tests;
+			incremental.solve_distinct(mgr.get_fault(id), {}, 100, all_tests);
+			REQUIRE(all_tests.size() < n);
+			++exhausted;
+		}
+	}
+	REQUIRE(exhausted == generator.get_exhausted_faults());
+}
+
+void require_parallel_matches(const CircuitGraph& graph)
+{
+	FaultManager mgr(graph);
+	FaultCnfMaker maker(graph);
+	auto solver = SolverFactory::make_solver();
+	FaultSimulator simulator(graph);
+
+	std::vector<size_t> fault_ids;
+	while (mgr.has_faults_left()) {
+		mgr.next_fault();
+		fault_ids.push_back(mgr.get_current_fault_id());
+	}
+
+	std::vector<FaultRecord> records;
+	ParallelFaultSolver parallel_solver(graph, mgr, 3);
+	REQUIRE(parallel_solver.run(fault_ids, [&](const WorkerResult& result) {
+		records.push_back(result.record);
+	}));
+	REQUIRE(records.size() == fault_ids.size());
+
+	for (const FaultRecord& record : records) {
+		const Fault& f = mgr.get_fault(record.fault_id);
+		CAPTURE(get_fault_name(f));
+		bool detectable = is_detectable(f, maker, *solver);
+		REQUIRE(record.status == (detectable ? FaultStatus::Detectable : FaultStatus::Undetectable));
+
+		if (detectable) {
+			simulator.load_patterns({record.pattern});
+			REQUIRE(simulator.simulate_fault(f) == 1);
+		}
+	}
+}
+
+TEST_CASE("parallel solving with clause sharing gives same results") {
+	if (no_solver()) return;
+
+	SECTION("s27") {
+		S27Circuit s27;
+		require_parallel_matches(s27.graph);
+	}
+
+	SECTION("circuit with expandable gates") {
+		TestCircuitWithExpandableGates tc;
+		require_parallel_matches(tc.graph);
+	}
+}
+
+TEST_CASE("static learning doesn't change fault detectability") {
+	if (no_solver()) return;
+
+	S27Circuit s27;
+	FaultManager mgr(s27.graph);
+	FaultCnfMaker maker(s27.graph);
+	FaultCnfMaker learned_maker(s27.graph);
+	auto solver = SolverFactory::make_solver();
+
+	StaticLearner learner(s27.graph);
+	learner.set_recursive_learning(true);
+	std::vector<clause_t> learned_clauses = learner.learn();
+	REQUIRE(!learned_clauses.empty());
+	learned_maker.set_learned_clauses(learned_clauses);
+
+	for (float threshold_ratio : {0.0f, 2.0f}) {
+		maker.set_threshold_ratio(threshold_ratio);
+		learned_maker.set_threshold_ratio(threshold_ratio);
+		for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+			const Fault& f = mgr.get_fault(id);
+			CAPTURE(get_fault_name(f));
+			REQUIRE(is_detectable(f, maker, *solver) == is_detectable(f, learned_maker, *solver));
+		}
+	}
+}
+
+void require_dominators_keep_detectability(const CircuitGraph& graph)
+{
+	FaultManager mgr(graph);
+	FaultCnfMaker maker(graph);
+	FaultCnfMaker dominator_maker(graph);
+	dominator_maker.set_use_dominators(true);
+	auto solver = SolverFactory::make_solver();
+
+	for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+		const Fault& f = mgr.get_fault(id);
+		CAPTURE(get_fault_name(f));
+		REQUIRE(is_detectable(f, maker, *solver) == is_detectable(f, dominator_maker, *solver));
+	}
+}
+
+TEST_CASE("unique sensitization doesn't change fault detectability") {
+	if (no_solver()) return;
+
+	SECTION("c17") {
+		C17Circuit c17;
+		require_dominators_keep_detectability(c17.graph);
+	}
+
+	SECTION("s27") {
+		S27Circuit s27;
+		require_dominators_keep_detectability(s27.graph);
+	}
+
+	SECTION("test circuit") {
+		TestCircuit tc;
+		require_dominators_keep_detectability(tc.graph);
+	}
+
+	SECTION("circuit with expandable gates") {
+		TestCircuitWithExpandableGates tc;
+		require_dominators_keep_detectability(tc.graph);
+	}
+}
+
+TEST_CASE("n-ary gate encoding is smaller for wide gates") {
+	CircuitGraph graph;
+	std::vector<std::string> inputs;
+	for (size_t i = 0; i < 16; ++i) {
+		inputs.push_back("x" + std::to_string(i));
+		graph.add_input(inputs.back());
+	}
+	graph.add_output("y");
+	graph.add_gate(Gate::Type::Nand, std::vector<std::string>(inputs), "y");
+
+	FaultManager mgr(graph);
+	size_t fault_id = 0;
+	REQUIRE(mgr.find_fault("y/I3 S-A-1", fault_id));
+
+	FaultCnfMaker maker(graph);
+	FaultCnfMaker nary_maker(graph, GateEncoding::Nary);
+	Cnf expanded;
+	Cnf nary;
+	maker.make_fault(mgr.get_fault(fault_id), expanded);
+	nary_maker.make_fault(mgr.get_fault(fault_id), nary);
+	REQUIRE(nary.get_clauses().size() < expanded.get_clauses().size());
+
+	auto count_variables = [](const Cnf& cnf) {
+		std::set<literal_t> variables;
+		for (const clause_t& clause : cnf.get_clauses()) {
+			for (literal_t l : clause) {
+				variables.insert(std::abs(l));
+			}
+		}
+		return variables.size();
+	};
+	REQUIRE(count_variables(nary) < count_variables(expanded));
+}
+
+// Every gate encoding with every gate expansion gives the same results as the chain expanded CNF
+void require_gate_encodings_keep_detectability(CircuitGraph& graph)
+{
+	FaultManager mgr(graph);
+	auto solver = SolverFactory::make_solver();
+	std::vector<bool> detectable;
+	{
+		FaultCnfMaker maker(graph);
+		for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+			detectable.push_back(is_detectable(mgr.get_fault(id), maker, *solver));
+		}
+	}
+
+	FaultSimulator simulator(graph);
+	for (GateEncoding encoding : {GateEncoding::Expanded, GateEncoding::Nary}) {
+		for (GateExpansion expansion : {GateExpansion::Chain, GateExpansion::Balanced, GateExpansion::Level}) {
+			CAPTURE(int(encoding));
+			CAPTURE(int(expansion));
+			graph.set_gate_expansion(expansion);
+			FaultCnfMaker maker(graph, encoding);
+			IncrementalFaultSolver incremental(graph, SolverFactory::make_solver(), encoding);
+
+			// Full and partial circuit CNF
+			for (float threshold_ratio : {0.0f, 2.0f}) {
+				maker.set_threshold_ratio(threshold_ratio);
+				for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+					const Fault& f = mgr.get_fault(id);
+					CAPTURE(get_fault_name(f));
+					REQUIRE(is_detectable(f, maker, *solver) == detectable[id]);
+				}
+			}
+
+			for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+				const Fault& f = mgr.get_fault(id);
+				CAPTURE(get_fault_name(f));
+				REQUIRE(incremental.solve(f) == (detectable[id] ? SatSolver::Sat : SatSolver::Unsat));
+				if (detectable[id]) {
+					simulator.load_patterns({incremental.get_pattern()});
+					REQUIRE(simulator.simulate_fault(f) == 1);
+				}
+			}
+		}
+	}
+	graph.set_gate_expansion(GateExpansion::Chain);
+}
+
+TEST_CASE("gate encodings and expansions don't change fault detectability") {
+	if (no_solver()) return;
+
+	SECTION("circuit with expandable gates") {
+		TestCircuitWithExpandableGates tc;
+		require_gate_encodings_keep_detectability(tc.graph);
+	}
+
+	SECTION("duplicate inputs of wide gates") {
+		CircuitGraph graph;
+		graph.add_input("a");
+		graph.add_input("b");
+		graph.add_input("c");
+		graph.add_output("x");
+		graph.add_output("y");
+		graph.add_output("z");
+		graph.add_gate(Gate::Type::Or, {"a", "b", "a", "c"}, "x");
+		graph.add_gate(Gate::Type::And, {"a", "b", "c", "a", "b"}, "y");
+		graph.add_gate(Gate::Type::Nor, {"b", "c", "c"}, "z");
+		require_gate_encodings_keep_detectability(graph);
+	}
+
+	SECTION("generated circuit with wide gates") {
+		NetlistGeneratorConfig config;
+		config.inputs = 12;
+		config.gates = 150;
+		config.outputs = 6;
+		config.depth = 8;
+		config.max_fanin = 8;
+		CircuitGraph graph;
+		NetlistGenerator(config).build(graph);
+		require_gate_encodings_keep_detectability(graph);
+	}
+}
+
+void require_redundant_faults_undetectable(const CircuitGraph& graph, size_t& redundant)
+{
+	FaultManager mgr(graph);
+	FaultCnfMaker maker(graph);
+	RedundancyAnalyzer analyzer(graph);
+	auto solver = SolverFactory::make_solver();
+
+	for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+		const Fault& f = mgr.get_fault(id);
+		CAPTURE(get_fault_name(f));
+		if (analyzer.is_redundant(f)) {
+			REQUIRE(!is_detectable(f, maker, *solver));
+			++redundant;
+		}
+	}
+}
+
+TEST_CASE("faults redundant by implications are undetectable") {
+	if (no_solver()) return;
+
+	size_t redundant = 0;
+
+	SECTION("s27") {
+		S27Circuit s27;
+		require_redundant_faults_undetectable(s27.graph, redundant);
+	}
+
+	SECTION("test circuit") {
+		TestCircuit tc;
+		require_redundant_faults_undetectable(tc.graph, redundant);
+	}
+
+	SECTION("circuit with expandable gates") {
+		TestCircuitWithExpandableGates tc;
+		require_redundant_faults_undetectable(tc.graph, redundant);
+	}
+
+	SECTION("reconvergent circuit") {
+		// z = a & !a is constant 0, c = a | b masks b when a = 1
+		CircuitGraph graph;
+		Iscas89Parser parser;
+		std::stringstream ss(R"(
+			INPUT(a)
+			INPUT(b)
+			OUTPUT(z)
+			OUTPUT(y)
+			n = NOT(a)
+			z = AND(a, n)
+			c = OR(a, b)
+			y = AND(a, c)
+		)");
+		REQUIRE(parser.parse(ss, graph));
+		require_redundant_faults_undetectable(graph, redundant);
+
+		FaultManager mgr(graph);
+		RedundancyAnalyzer analyzer(graph);
+		size_t id;
+		REQUIRE(mgr.find_fault("z/O S-A-0", id));
+		REQUIRE(analyzer.is_redundant(mgr.get_fault(id)));
+		REQUIRE(mgr.find_fault("c/O S-A-1", id));
+		REQUIRE(analyzer.is_redundant(mgr.get_fault(id)));
+		REQUIRE(redundant > 0);
+	}
+}
+
+TEST_CASE("portfolio gives same results") {
+	if (no_solver()) return;
+
+	S27Circuit s27;
+	FaultManager mgr(s27.graph);
+	FaultCnfMaker maker(s27.graph);
+	auto solver = SolverFactory::make_solver();
+	FaultSimulator simulator(s27.graph);
+
+	PortfolioSolver portfolio(make_portfolio_configs(3));
+	REQUIRE(portfolio.get_configs().size() == 3);
+	for (const SolverConfig& config : portfolio.get_configs()) {
+		REQUIRE_FALSE(config.options.empty());
+	}
+
+	for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+		const Fault& f = mgr.get_fault(id);
+		CAPTURE(get_fault_name(f));
+
+		Cnf cnf;
+		maker.make_fault(f, cnf);
+		SatSolver::SolveStatus status = portfolio.solve(cnf);
+		REQUIRE(status == solver->solve(cnf));
+
+		if (status == SatSolver::Sat) {
+			simulator.load_patterns({make_pattern(portfolio.get_winner(), s27.graph)});
+			REQUIRE(simulator.simulate_fault(f) == 1);
+		}
+	}
+
+	const std::vector<size_t>& wins = portfolio.get_wins();
+	REQUIRE(std::accumulate(wins.begin(), wins.end(), size_t(0)) == mgr.get_fault_count());
+}
+
+TEST_CASE("cube and conquer gives same results") {
+	if (no_solver()) return;
+
+	S27Circuit s27;
+	FaultManager mgr(s27.graph);
+	FaultCnfMaker maker(s27.graph);
+	auto solver = SolverFactory::make_solver();
+	FaultSimulator simulator(s27.graph);
+	CubeSolver cube_solver(s27.graph, 2, 3);
+
+	for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+		const Fault& f = mgr.get_fault(id);
+		CAPTURE(get_fault_name(f));
+
+		std::vector<const Line*> split_lines = cube_solver.select_split_lines(f);
+		REQUIRE(split_lines.size() <= 3);
+		REQUIRE(std::find(split_lines.begin(), split_lines.end(), f.line) == split_lines.end());
+
+		Cnf cnf;
+		maker.make_fault(f, cnf);
+		SatSolver::SolveStatus status = cube_solver.solve(cnf, f);
+		REQUIRE(status == solver->solve(cnf));
+
+		if (status == SatSolver::Sat) {
+			simulator.load_patterns({cube_solver.get_pattern()});
+			REQUIRE(simulator.simulate_fault(f) == 1);
+		}
+	}
+	REQUIRE(cube_solver.get_solved_cubes() > 0);
+}
+
+TEST_CASE("cube depth is limited") {
+	NetlistGeneratorConfig config;
+	config.inputs = 40;
+	config.gates = 400;
+	config.outputs = 4;
+	config.depth = 12;
+	CircuitGraph graph;
+	NetlistGenerator(config).build(graph);
+	FaultManager mgr(graph);
+	CubeSolver cube_solver(graph, 1, 64);
+
+	size_t max_split_lines = 0;
+	for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+		max_split_lines = std::max(max_split_lines, cube_solver.select_split_lines(mgr.get_fault(id)).size());
+	}
+	REQUIRE(max_split_lines == CubeSolver::max_depth);
+}
+
+TEST_CASE("cnf cost model doesn't change fault detectability") {
+	if (no_solver()) return;
+
+	S27Circuit s27;
+	FaultManager mgr(s27.graph);
+	FaultCnfMaker maker(s27.graph);
+	FaultCnfMaker cost_maker(s27.graph);
+	cost_maker.set_use_cost_model(true);
+	REQUIRE(cost_maker.get_cost_model());
+	auto solver = SolverFactory::make_solver();
+
+	for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+		const Fault& f = mgr.get_fault(id);
+		CAPTURE(get_fault_name(f));
+
+		Cnf cnf;
+		maker.make_fault(f, cnf);
+		Cnf cost_cnf;
+		cost_maker.make_fault(f, cost_cnf);
+		REQUIRE(solver->solve(cost_cnf) == solver->solve(cnf));
+		cost_maker.add_solve_time(10);
+	}
+
+	const CnfCostModel* model = cost_maker.get_cost_model();
+	REQUIRE(model->get_partial_count() + model->get_full_count() == mgr.get_fault_count());
+	REQUIRE(model->get_partial_count() > 0);
+	REQUIRE(model->get_overlap_factor() >= 0);
+	REQUIRE(model->get_overlap_factor() <= 1);
+}
+
+// Partial and full CNF are made once with the same cost per clause
+static void sample_both_cnfs(CnfCostModel& model, const std::set<const Line*>& outputs)
+{
+	REQUIRE(model.choose_partial(outputs));
+	model.add_cnf(true, 100, 100);
+	REQUIRE_FALSE(model.choose_partial(outputs));
+	model.add_cnf(false, 100, 100);
+}
+
+TEST_CASE("cnf cost model prefers partial cnf of a small cone") {
+	S27Circuit s27;
+	CnfCostModel model(s27.graph);
+
+	std::set<const Line*> all_outputs(s27.graph.get_outputs().begin(), s27.graph.get_outputs().end());
+	sample_both_cnfs(model, all_outputs);
+	REQUIRE_FALSE(model.choose_partial(all_outputs));
+
+	// The kind the model doesn't prefer is still made every exploration_interval-th time
+	size_t partial_choices = 0;
+	for (size_t i = 0; i < 2 * CnfCostModel::exploration_interval; ++i) {
+		partial_choices += model.choose_partial(all_outputs);
+	}
+	REQUIRE(partial_choices == 2);
+
+	// Output x is driven by a single primary input
+	CircuitGraph graph;
+	graph.add_input("a");
+	graph.add_input("b");
+	graph.add_input("c");
+	graph.add_output("x");
+	graph.add_output("y");
+	graph.add_gate(Gate::Type::Not, {"a"}, "x");
+	graph.add_gate(Gate::Type::And, {"a", "b", "c"}, "t");
+	graph.add_gate(Gate::Type::Or, {"t", "c"}, "y");
+	CnfCostModel small_model(graph);
+	sample_both_cnfs(small_model, {graph.get_line("x")});
+	REQUIRE(small_model.choose_partial({graph.get_line("x")}));
+}
+
+TEST_CASE("cnf cost model counts clauses of the gate encoding") {
+	TestCircuitWithExpandableGates tc;
+	CircuitToCnfTransformer transformer;
+	REQUIRE(CnfCostModel(tc.graph).get_full_clauses() == transformer.make_cnf(tc.graph, true).get_clauses().size());
+	REQUIRE(CnfCostModel(tc.graph, false).get_full_clauses() == transformer.make_cnf(tc.graph, false).get_clauses().size());
+	REQUIRE(CnfCostModel(tc.graph, false).get_full_clauses() < CnfCostModel(tc.graph).get_full_clauses());
+}
+
+TEST_CASE("solver statistics") {
+	if (no_solver()) return;
+
+	S27Circuit s27;
+	FaultManager mgr(s27.graph);
+	FaultCnfMaker maker(s27.graph);
+	auto solver = SolverFactory::make_solver();
+	solver->set_count_conflicts(true);
+
+	Cnf cnf;
+	maker.make_fault(mgr.get_fault(0), cnf);
+	solver->solve(cnf);
+	REQUIRE(solver->get_clause_count() == cnf.get_clauses().size());
+	REQUIRE(solver->get_max_var() > 0);
+	REQUIRE(maker.get_last_info().cone_lines > 0);
+
+	solver->reset();
+	REQUIRE(solver->get_clause_count() == 0);
+}
@@ -0,0 +1,130 @@
+#include <catch.hpp>
+
+#include "circuits.h"
+#include "../fault_dictionary.h"
+#include "../fault_simulator.h"
+
+// All 32 patterns of c17 inputs, then the same in reverse order, so the set spans two simulator passes
+static std::vector<std::string> make_c17_patterns()
+{
+	std::vector<std::string> patterns;
+	for (size_t v = 0; v < 64; ++v) {
+		size_t value = v < 32 ? v : 63 - v;
+		std::string pattern;
+		for (size_t i = 0; i < 5; ++i) {
+			pattern += (value >> i) & 1 ? '1' : '0';
+		}
+		patterns.push_back(pattern);
+	}
+	patterns.push_back("1X1XX");
+	return patterns;
+}
+
+TEST_CASE("fault dictionary lookups match simulation") {
+	C17Circuit c17;
+	FaultManager mgr(c17.graph);
+	std::vector<std::string> patterns = make_c17_patterns();
+
+	FaultDictionary dictionary;
+	dictionary.build(c17.graph, mgr, patterns);
+	REQUIRE(dictionary.get_pattern_count() == patterns.size());
+	REQUIRE(dictionary.get_fault_count() == mgr.get_fault_count());
+
+	FaultSimulator simulator(c17.graph);
+	std::vector<FaultSimulator::OutputMask> outputs;
+	for (size_t first = 0; first < patterns.size(); first += FaultSimulator::patterns_per_pass) {
+		simulator.load_patterns(patterns, first);
+		for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+			uint64_t mask = simulator.simulate_fault(mgr.get_fault(id), outputs);
+			for (size_t p = 0; first + p < patterns.size() && p < FaultSimulator::patterns_per_pass; ++p) {
+				REQUIRE(dictionary.is_detected(id, first + p) == (((mask >> p) & 1) != 0));
+
+				std::vector<size_t> expected_outputs;
+				for (const FaultSimulator::OutputMask& output : outputs) {
+					if ((output.mask >> p) & 1) {
+						expected_outputs.push_back(output.output_idx);
+					}
+				}
+				REQUIRE(dictionary.get_failing_outputs(id, first + p) == expected_outputs);
+			}
+		}
+	}
+
+	for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+		for (size_t pattern : dictionary.get_detecting_patterns(id)) {
+			REQUIRE(dictionary.is_detected(id, pattern));
+		}
+	}
+}
+
+TEST_CASE("diagnosis ranks the fault that explains the failures first") {
+	C17Circuit c17;
+	FaultManager mgr(c17.graph);
+	std::vector<std::string> patterns = make_c17_patterns();
+
+	size_t fault_id = 0;
+	REQUIRE(mgr.find_fault("10/O S-A-1", fault_id));
+
+	SECTION("full response") {
+		FaultDictionary dictionary(FaultDictionary::Type::FullResponse);
+		dictionary.build(c17.graph, mgr, patterns);
+
+		std::vector<FaultDictionary::Failure> observed;
+		for (size_t pattern : dictionary.get_detecting_patterns(fault_id)) {
+			for (size_t output_idx : dictionary.get_failing_outputs(fault_id, pattern)) {
+				observed.push_back({pattern, output_idx});
+			}
+		}
+		REQUIRE(!observed.empty());
+
+		std::vector<FaultDictionary::Candidate> candidates = dictionary.diagnose(observed, 5);
+		REQUIRE(!candidates.empty());
+		REQUIRE(candidates.size() <= 5);
+		REQUIRE(candidates[0].mispredictions == 0);
+		REQUIRE(candidates[0].nonpredictions == 0);
+		REQUIRE(candidates[0].matches == observed.size());
+
+		// Equivalent faults have the same response, so the fault may share the first rank
+		bool found = false;
+		for (const FaultDictionary::Candidate& candidate : candidates) {
+			if (candidate.mispredictions + candidate.nonpredictions == 0) {
+				found = found || candidate.fault_id == fault_id;
+			}
+		}
+		REQUIRE(found);
+
+		// A failure no fault predicts only adds a nonprediction
+		observed.push_back({patterns.size() + 10, 0});
+		candidates = dictionary.diagnose(observed, 1);
+		REQUIRE(candidates.size() == 1);
+		REQUIRE(candidates[0].nonpredictions == 1);
+	}
+
+	SECTION("pass/fail") {
+		FaultDictionary dictionary(FaultDictionary::Type::PassFail);
+		dictionary.build(c17.graph, mgr, patterns);
+		REQUIRE(dictionary.get_failing_outputs(fault_id, 31).empty());
+
+		std::vector<FaultDictionary::Failure> observed;
+		for (size_t pattern : dictionary.get_detecting_patterns(fault_id)) {
+			// Duplicates are counted once
+			observed.push_back({pattern, 0});
+			observed.push_back({pattern, 1});
+		}
+
+		std::vector<FaultDictionary::Candidate> candidates = dictionary.diagnose(observed, 100);
+		REQUIRE(candidates[0].mispredictions == 0);
+		REQUIRE(candidates[0].nonpredictions == 0);
+		REQUIRE(candidates[0].matches == observed.size() / 2);
+		for (size_t i = 1; i < candidates.size(); ++i) {
+			size_t errors = candidates[i].mispredictions + candidates[i].nonpredictions;
+			REQUIRE(errors >= candidates[i - 1].mispredictions + candidates[i - 1].nonpredictions);
+		}
+	}
+
+	SECTION("nothing observed") {
+		FaultDictionary dictionary;
+		dictionary.build(c17.graph, mgr, patterns);
+		REQUIRE(dictionary.diagnose({}, 10).empty());
+	}
+}
@@ -208,3 +208,87 @@ TEST_CASE("output is used as gate input") {
 	CAPTURE(faults);
 	REQUIRE(faults.size() == 8);
 }
+
+TEST_CASE("skipped faults are not returned") {
+	C17Circuit c17;
+	FaultManager manager(c17.graph);
+	REQUIRE(manager.get_fault_count() == 22);
+
+	manager.skip_fault(0);
+	manager.skip_fault(5);
+	manager.skip_fault(21);
+
+	std::vector<size_t> ids;
+	while (manager.has_faults_left()) {
+		Fault f = manager.next_fault();
+		REQUIRE(f == manager.get_fault(manager.get_current_fault_id()));
+		ids.push_back(manager.get_current_fault_id());
+	}
+
+	REQUIRE(ids.size() == 19);
+	REQUIRE(ids.front() == 1);
+	REQUIRE(ids.back() == 20);
+	REQUIRE(std::find(ids.begin(), ids.end(), 5) == ids.end());
+}
+
+TEST_CASE("shards cover all faults once") {
+	S27Circuit s27;
+	const size_t shard_count = 3;
+
+	for (auto mode : {FaultManager::ShardMode::Interleaved, FaultManager::ShardMode::Cone}) {
+		std::vector<size_t> times_selected;
+		for (size_t shard = 0; shard < shard_count; ++shard) {
+			FaultManager manager(s27.graph);
+			times_selected.resize(manager.get_fault_count(), 0);
+			manager.select_shard(shard, shard_count, mode);
+
+			size_t shard_size = 0;
+			while (manager.has_faults_left()) {
+				manager.next_fault();
+				++times_selected[manager.get_current_fault_id()];
+				++shard_size;
+			}
+			REQUIRE(shard_size >= times_selected.size() / shard_count);
+			REQUIRE(shard_size <= times_selected.size() / shard_count + 1);
+		}
+		REQUIRE(std::count(times_selected.begin(), times_selected.end(), 1) == (long)times_selected.size());
+	}
+}
+
+TEST_CASE("fault names") {
+	S27Circuit s27;
+	FaultManager manager(s27.graph);
+
+	REQUIRE(get_fault_name(Fault(s27.l10, 0, true)) == "G10/O S-A-0");
+	REQUIRE(get_fault_name(Fault(s27.l14, 1, false, s27.g8, 0)) == "G8/I1 S-A-1");
+
+	for (size_t id = 0; id < manager.get_fault_count(); ++id) {
+		const Fault& fault = manager.get_fault(id);
+		size_t found_id = 0;
+		REQUIRE(manager.find_fault(get_unique_fault_name(fault), found_id));
+		REQUIRE(found_id == id);
+	}
+
+	size_t id = 0;
+	REQUIRE_FALSE(manager.find_fault("G10/O S-A-2", id));
+
+	SECTION("primary output with fanout") {
+		CircuitGraph graph;
+		graph.add_input("a");
+		graph.add_input("b");
+		graph.add_output("x");
+		graph.add_output("y");
+		graph.add_gate(Gate::Type::And, {"a", "b"}, "x");
+		graph.add_gate(Gate::Type::Or, {"x", "b"}, "y");
+		FaultManager output_manager(graph);
+
+		size_t stem_id = 0;
+		size_t output_id = 0;
+		REQUIRE(output_manager.find_fault("x/O S-A-1", stem_id));
+		REQUIRE(output_manager.find_fault("x/PO S-A-1", output_id));
+		REQUIRE(output_manager.get_fault(stem_id).is_stem);
+		REQUIRE(output_manager.get_fault(output_id).is_primary_output);
+		REQUIRE_FALSE(output_manager.get_fault(output_id).is_stem);
+		REQUIRE(get_fault_name(output_manager.get_fault(output_id)) == "x/O S-A-1");
+	}
+}
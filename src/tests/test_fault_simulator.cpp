@@ -0,0 +1,181 @@
+#include <catch.hpp>
+
+#include "circuits.h"
+#include "../fault_manager.h"
+#include "../fault_simulator.h"
+#include "../pattern_validator.h"
+
+std::vector<std::string> make_exhaustive_patterns(size_t inputs)
+{
+	std::vector<std::string> patterns;
+	for (size_t v = 0; v < (1u << inputs); ++v) {
+		std::string pattern;
+		for (size_t i = 0; i < inputs; ++i) {
+			pattern += (v >> i) & 1 ? '1' : '0';
+		}
+		patterns.push_back(pattern);
+	}
+	return patterns;
+}
+
+size_t count_detected_faults(const CircuitGraph& graph, const std::vector<std::string>& patterns)
+{
+	FaultManager mgr(graph);
+	FaultSimulator simulator(graph);
+
+	std::vector<uint8_t> detected(mgr.get_fault_count(), 0);
+	for (size_t first = 0; first < patterns.size(); first += FaultSimulator::patterns_per_pass) {
+		simulator.load_patterns(patterns, first);
+		for (size_t id = 0; id < mgr.get_fault_count(); ++id) {
+			if (simulator.simulate_fault(mgr.get_fault(id))) {
+				detected[id] = 1;
+			}
+		}
+	}
+	return std::count(detected.begin(), detected.end(), 1);
+}
+
+TEST_CASE("good circuit simulation") {
+	C17Circuit c17;
+	FaultSimulator simulator(c17.graph);
+
+	// inputs 1 2 3 6 7
+	REQUIRE(simulator.load_patterns({"00000", "11111", "1X1XX"}) == 3);
+
+	// Bit i of the mask corresponds to pattern i
+
+	REQUIRE(simulator.get_value(c17.l10).one == 0x1);
+	REQUIRE(simulator.get_value(c17.l10).zero == 0x6);
+
+	REQUIRE(simulator.get_value(c17.l22).one == 0x6);
+	REQUIRE(simulator.get_value(c17.l22).zero == 0x1);
+
+	// 23 = NAND(16, 19) depends on unknown inputs for the last pattern
+	REQUIRE(simulator.get_value(c17.l23).one == 0x0);
+	REQUIRE(simulator.get_value(c17.l23).zero == 0x3);
+}
+
+TEST_CASE("fault detection masks") {
+	C17Circuit c17;
+	FaultSimulator simulator(c17.graph);
+
+	simulator.load_patterns({"00000", "11111", "1X1XX"});
+
+	// 22 = NAND(10, 16), 10 = NAND(1, 3) is 0 for the second and third patterns,
+	// but 16 is unknown for the third one
+	SECTION("stem") {
+		Fault fault(c17.l10, 1, true);
+		REQUIRE(simulator.simulate_fault(fault) == 0x2);
+	}
+
+	SECTION("primary output") {
+		Fault fault(c17.l22, 1, true);
+		REQUIRE(simulator.simulate_fault(fault) == 0x1);
+		fault.stuck_at = 0;
+		REQUIRE(simulator.simulate_fault(fault) == 0x6);
+	}
+
+	SECTION("branch") {
+		Fault fault(c17.l1, 0, false, c17.g10, 0);
+		REQUIRE(simulator.simulate_fault(fault) == 0x2);
+		fault.stuck_at = 1;
+		REQUIRE(simulator.simulate_fault(fault) == 0x0);
+	}
+
+	SECTION("outputs") {
+		Fault fault(c17.l10, 1, true);
+		std::vector<FaultSimulator::OutputMask> outputs;
+		REQUIRE(simulator.simulate_fault(fault, outputs) == 0x2);
+		REQUIRE(outputs.size() == 1);
+		REQUIRE(c17.graph.get_outputs()[outputs[0].output_idx] == c17.l22);
+		REQUIRE(outputs[0].mask == 0x2);
+	}
+
+	SECTION("simulation doesn't change good values") {
+		Fault fault(c17.l11, 1, true);
+		REQUIRE(simulator.simulate_fault(fault) == 0x2);
+		REQUIRE(simulator.get_value(c17.l23).one == 0x0);
+		REQUIRE(simulator.get_value(c17.l23).zero == 0x3);
+	}
+}
+
+TEST_CASE("exhaustive simulation matches fault detectability") {
+	SECTION("c17") {
+		C17Circuit c17;
+		REQUIRE(count_detected_faults(c17.graph, make_exhaustive_patterns(5)) == 22);
+	}
+
+	SECTION("circuit with expandable gates") {
+		TestCircuitWithExpandableGates tc;
+		size_t inputs = tc.graph.get_inputs().size();
+		REQUIRE(count_detected_faults(tc.graph, make_exhaustive_patterns(inputs)) == 37);
+	}
+}
+
+TEST_CASE("pattern validation") {
+	C17Circuit c17;
+	FaultManager mgr(c17.graph);
+	PatternValidator validator(c17.graph, mgr);
+
+	size_t fault_id = 0;
+	REQUIRE(mgr.find_fault("10/O S-A-1", fault_id));
+
+	SECTION("coverage over several passes") {
+		std::vector<std::string> patterns = make_exhaustive_patterns(5);
+		for (size_t i = 0; i < 3; ++i) {
+			for (const std::string& pattern : patterns) {
+				validator.add_pattern(pattern);
+			}
+		}
+		validator.flush();
+		REQUIRE(validator.get_pattern_count() == 96);
+		REQUIRE(validator.get_detected_count() == 22);
+		REQUIRE(validator.get_failed_claims().empty());
+	}
+
+	SECTION("detections of every pattern") {
+		std::vector<std::vector<size_t>> detections;
+		validator.set_detection_function([&](size_t pattern_index, const std::vector<size_t>& fault_ids) {
+			REQUIRE(pattern_index == detections.size());
+			detections.push_back(fault_ids);
+		});
+		std::vector<std::string> patterns = make_exhaustive_patterns(5);
+		for (size_t i = 0; i < 3; ++i) {
+			for (const std::string& pattern : patterns) {
+				validator.add_pattern(pattern);
+			}
+		}
+		validator.flush();
+		REQUIRE(detections.size() == 96);
+		for (size_t i = 0; i < 32; ++i) {
+			// No fault dropping, repeated patterns detect the same faults
+			REQUIRE(detections[i] == detections[i + 32]);
+			REQUIRE(detections[i] == detections[i + 64]);
+		}
+		// 10 = NAND(1, 3) is 1 for "00000" (pattern 0) and 0 for "11111" (pattern 31)
+		REQUIRE(std::count(detections[31].begin(), detections[31].end(), fault_id) == 1);
+		REQUIRE(std::count(detections[0].begin(), detections[0].end(), fault_id) == 0);
+	}
+
+	SECTION("claimed tests") {
+		validator.add_pattern("11111", fault_id);
+		validator.add_pattern("00000", fault_id);
+		validator.flush();
+		REQUIRE(validator.get_claim_count() == 2);
+		REQUIRE(validator.get_failed_claims().size() == 1);
+		REQUIRE(validator.get_failed_claims()[0].fault_id == fault_id);
+		REQUIRE(validator.get_failed_claims()[0].pattern_index == 1);
+	}
+
+	SECTION("claims of dropped faults are checked") {
+		for (size_t i = 0; i < 70; ++i) {
+			validator.add_pattern("11111");
+		}
+		REQUIRE(validator.is_detected(fault_id));
+		validator.add_pattern("00000", fault_id);
+		validator.add_pattern("11111", fault_id);
+		validator.flush();
+		REQUIRE(validator.get_failed_claims().size() == 1);
+		REQUIRE(validator.get_failed_claims()[0].pattern_index == 70);
+	}
+}
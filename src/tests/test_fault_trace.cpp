@@ -0,0 +1,77 @@
+#include <catch.hpp>
+
+#include "../fault_trace.h"
+#include "../fault_manager.h"
+
+#include "circuits.h"
+
+#include <cstdio>
+#include <fstream>
+
+TEST_CASE("fault trace") {
+	S27Circuit s27;
+	FaultManager mgr(s27.graph);
+
+	const std::string path = "test_fault_trace.jsonl";
+	{
+		FaultTraceWriter trace;
+		REQUIRE(trace.open(path));
+
+		WorkerResult detected;
+		detected.record.status = FaultStatus::Detectable;
+		detected.record.solve_time_us = 5;
+		detected.cnf_time_us = 3;
+		detected.cone_lines = 7;
+		detected.is_partial_cnf = true;
+		detected.clauses = 120;
+		detected.variables = 40;
+		trace.write(mgr.get_fault(0), detected, false);
+
+		WorkerResult redundant;
+		redundant.record.status = FaultStatus::Undetectable;
+		redundant.is_redundant_by_implications = true;
+		redundant.cnf_time_us = 1;
+		trace.write(mgr.get_fault(1), redundant, false);
+
+		WorkerResult cubes;
+		cubes.used_cubes = true;
+		trace.write(mgr.get_fault(2), cubes, false);
+
+		REQUIRE(trace.write_summary());
+	}
+
+	std::ifstream ifs(path);
+	std::vector<std::string> lines;
+	std::string line;
+	while (std::getline(ifs, line)) {
+		lines.push_back(line);
+	}
+	ifs.close();
+	std::remove(path.c_str());
+
+	REQUIRE(lines.size() == 4);
+	REQUIRE(lines[0].find("\"fault\": \"" + get_fault_name(mgr.get_fault(0)) + "\"") != std::string::npos);
+	REQUIRE(lines[0].find("\"cnf\": \"partial\"") != std::string::npos);
+	REQUIRE(lines[0].find("\"clauses\": 120") != std::string::npos);
+	REQUIRE(lines[0].find("\"result\": \"detectable\"") != std::string::npos);
+	REQUIRE(lines[0].find("\"engine\": \"sat\"") != std::string::npos);
+	REQUIRE(lines[1].find("\"engine\": \"implications\"") != std::string::npos);
+	// No cube was solved, the fault still went to cube-and-conquer
+	REQUIRE(lines[2].find("\"result\": \"unknown\"") != std::string::npos);
+	REQUIRE(lines[2].find("\"engine\": \"cubes\"") != std::string::npos);
+
+	REQUIRE(lines[3].find("{\"summary\": {\"faults\": 3") == 0);
+	REQUIRE(lines[3].find("\"results\": {\"detectable\": 1, \"undetectable\": 1, \"unknown\": 1}") != std::string::npos);
+	// Encode times 0, 1 and 3 are in buckets up to 0, up to 1 and up to 3
+	REQUIRE(lines[3].find("\"encode_us\": {\"total\": 4, \"p50\": 1, \"p90\": 3, \"p99\": 3, \"max\": 3, "
+		"\"histogram\": [{\"max\": 0, \"count\": 1}, {\"max\": 1, \"count\": 1}, {\"max\": 3, \"count\": 1}]}") != std::string::npos);
+}
+
+#ifdef __linux__
+TEST_CASE("fault trace reports write errors") {
+	// Every write to /dev/full fails with no space left
+	FaultTraceWriter trace;
+	REQUIRE(trace.open("/dev/full"));
+	REQUIRE_FALSE(trace.write_summary());
+}
+#endif
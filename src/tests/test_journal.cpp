@@ -0,0 +1,120 @@
+#include <catch.hpp>
+
+#include "../journal.h"
+
+#include "circuits.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <unistd.h>
+
+TEST_CASE("journal reading") {
+	std::stringstream ss;
+	ss << "# sat_atpg journal 1f2e 10\n";
+	ss << "0 D 15 01X1\n";
+	ss << "3 U 120 -\n";
+	ss << "4 A 3000 -\n";
+	ss << "15 D 10 0000\n"; // out of range
+	ss << "5 D 1";           // interrupted write
+
+	JournalHeader header;
+	std::vector<FaultRecord> records;
+	REQUIRE(read_journal(ss, header, records));
+
+	REQUIRE(header.circuit_hash == 0x1f2e);
+	REQUIRE(header.fault_count == 10);
+
+	REQUIRE(records.size() == 3);
+
+	REQUIRE(records[0].fault_id == 0);
+	REQUIRE(records[0].status == FaultStatus::Detectable);
+	REQUIRE(records[0].solve_time_us == 15);
+	REQUIRE(records[0].pattern == "01X1");
+
+	REQUIRE(records[1].fault_id == 3);
+	REQUIRE(records[1].status == FaultStatus::Undetectable);
+	REQUIRE(records[1].pattern.empty());
+
+	REQUIRE_FALSE(records[2].is_classified());
+}
+
+TEST_CASE("journal with wrong header") {
+	std::stringstream ss("0 D 15 01X1\n");
+
+	JournalHeader header;
+	std::vector<FaultRecord> records;
+	REQUIRE_FALSE(read_journal(ss, header, records));
+}
+
+static std::vector<FaultRecord> read_journal_file(const std::string& path)
+{
+	std::ifstream ifs(path);
+	JournalHeader header;
+	std::vector<FaultRecord> records;
+	REQUIRE(read_journal(ifs, header, records));
+	REQUIRE(header.fault_count == 10);
+	return records;
+}
+
+TEST_CASE("journal resumed after interrupted write") {
+	const std::string path = "test_journal.txt";
+	std::remove(path.c_str());
+	JournalHeader header;
+	header.circuit_hash = 0x1f2e;
+	header.fault_count = 10;
+
+	FaultRecord record;
+	record.fault_id = 3;
+	record.status = FaultStatus::Undetectable;
+	record.solve_time_us = 120;
+	{
+		JournalWriter writer(header);
+		REQUIRE(writer.open(path));
+		REQUIRE(writer.write(record));
+		record.fault_id = 5;
+		record.status = FaultStatus::Detectable;
+		record.solve_time_us = 15;
+		record.pattern = "01X1";
+		REQUIRE(writer.write(record));
+		REQUIRE(writer.close());
+	}
+
+	// Cut the last record in the middle, as a killed run leaves it
+	std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+	std::streamoff size = ifs.tellg();
+	ifs.close();
+	REQUIRE(truncate(path.c_str(), size - 4) == 0);
+	REQUIRE(read_journal_file(path).size() == 1);
+
+	{
+		JournalWriter writer(header);
+		REQUIRE(writer.open(path));
+		record.fault_id = 7;
+		record.status = FaultStatus::Undetectable;
+		record.solve_time_us = 300;
+		record.pattern.clear();
+		REQUIRE(writer.write(record));
+		REQUIRE(writer.close());
+	}
+
+	std::vector<FaultRecord> records = read_journal_file(path);
+	std::remove(path.c_str());
+	REQUIRE(records.size() == 2);
+	REQUIRE(records[0].fault_id == 3);
+	REQUIRE(records[0].status == FaultStatus::Undetectable);
+	REQUIRE(records[1].fault_id == 7);
+	REQUIRE(records[1].status == FaultStatus::Undetectable);
+	REQUIRE(records[1].solve_time_us == 300);
+	REQUIRE(records[1].pattern.empty());
+}
+
+TEST_CASE("circuit hash") {
+	C17Circuit c17_1;
+	C17Circuit c17_2;
+	REQUIRE(c17_1.graph.get_hash() == c17_2.graph.get_hash());
+
+	S27Circuit s27;
+	REQUIRE(c17_1.graph.get_hash() != s27.graph.get_hash());
+}
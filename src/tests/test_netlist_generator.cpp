@@ -0,0 +1,90 @@
+#include <catch.hpp>
+
+#include "../netlist_generator.h"
+#include "../iscas89_parser.h"
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+
+static std::string make_bench(const NetlistGeneratorConfig& config)
+{
+	std::stringstream ss;
+	NetlistGenerator(config).write_bench(ss);
+	return ss.str();
+}
+
+TEST_CASE("netlist generator is reproducible") {
+	NetlistGeneratorConfig config;
+	config.gates = 500;
+	REQUIRE(make_bench(config) == make_bench(config));
+
+	NetlistGeneratorConfig other_seed = config;
+	other_seed.seed = 2;
+	REQUIRE(make_bench(config) != make_bench(other_seed));
+}
+
+TEST_CASE("generated netlist structure") {
+	NetlistGeneratorConfig config;
+	config.gates = 2000;
+	config.inputs = 100;
+	config.outputs = 50;
+	config.depth = 30;
+	config.redundancy = 0.1;
+
+	NetlistGenerator generator(config);
+	REQUIRE(generator.get_gate_count() == config.gates);
+
+	CircuitGraph built;
+	generator.build(built);
+	REQUIRE(built.get_gates().size() == config.gates);
+	REQUIRE(built.get_inputs().size() == config.inputs);
+	REQUIRE(built.get_outputs().size() >= config.outputs);
+
+	// Parsed .bench output is the same circuit
+	std::stringstream ss;
+	generator.write_bench(ss);
+	CircuitGraph parsed;
+	Iscas89Parser parser;
+	REQUIRE(parser.parse(ss, parsed));
+	REQUIRE(parsed.get_hash() == built.get_hash());
+
+	for (const Line* input : built.get_inputs()) {
+		REQUIRE_FALSE(input->destination_gates.empty());
+	}
+	for (const Line& line : built.get_lines()) {
+		REQUIRE((line.is_output || !line.destination_gates.empty()));
+	}
+
+	std::unordered_map<const Line*, size_t> levels;
+	size_t depth = 0;
+	for (const Gate* gate : make_topological_order(built)) {
+		size_t level = 0;
+		for (const Line* input : gate->get_inputs()) {
+			level = std::max(level, levels[input]);
+		}
+		levels[gate->get_output()] = level + 1;
+		depth = std::max(depth, level + 1);
+	}
+	REQUIRE(depth >= config.depth);
+}
+
+TEST_CASE("generated netlist with fewer inputs than max fanin") {
+	NetlistGeneratorConfig config;
+	config.inputs = 2;
+	config.gates = 100;
+	config.max_fanin = 16;
+	config.xor_density = 0;
+	config.inverter_density = 0;
+
+	NetlistGenerator generator(config);
+	REQUIRE(generator.get_gate_count() == config.gates);
+
+	CircuitGraph built;
+	generator.build(built);
+	for (const Gate& gate : built.get_gates()) {
+		std::vector<const Line*> inputs(gate.get_inputs().begin(), gate.get_inputs().end());
+		std::sort(inputs.begin(), inputs.end());
+		REQUIRE(std::unique(inputs.begin(), inputs.end()) == inputs.end());
+	}
+}
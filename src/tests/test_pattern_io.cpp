@@ -0,0 +1,105 @@
+#include <catch.hpp>
+
+#include "../pattern_io.h"
+
+#include "circuits.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+TEST_CASE("binary patterns writing and reading back") {
+	C17Circuit c;
+	const std::string path = "test_pattern_io.pat";
+	std::vector<std::string> patterns = {"01X10", "11111", "XXXXX", "00000", "10X01"};
+
+	{
+		PatternWriter writer;
+		REQUIRE(writer.open(path, c.graph));
+		for (const std::string& pattern : patterns) {
+			writer.write(pattern);
+		}
+		REQUIRE(writer.get_pattern_count() == patterns.size());
+	}
+
+	std::ifstream ifs(path, std::ios::binary);
+	std::stringstream data;
+	data << ifs.rdbuf();
+	ifs.close();
+	std::remove(path.c_str());
+
+	SECTION("all patterns") {
+		PatternReader reader(data);
+		REQUIRE(reader.open());
+		REQUIRE(reader.get_circuit_hash() == c.graph.get_hash());
+		REQUIRE(reader.get_input_names() == std::vector<std::string>({"1", "2", "3", "6", "7"}));
+
+		std::vector<std::string> read_patterns;
+		for (std::string pattern; reader.read(pattern);) {
+			read_patterns.push_back(pattern);
+		}
+		REQUIRE(read_patterns == patterns);
+	}
+
+	SECTION("truncated last pattern is ignored") {
+		// 5 inputs take 2 bytes per pattern
+		std::string truncated = data.str();
+		truncated.pop_back();
+		std::stringstream ss(truncated);
+		PatternReader reader(ss);
+		REQUIRE(reader.open());
+		size_t count = 0;
+		for (std::string pattern; reader.read(pattern);) {
+			++count;
+		}
+		REQUIRE(count == patterns.size() - 1);
+	}
+
+	SECTION("corrupt input name length") {
+		// First name length follows magic, circuit hash and input count
+		std::string corrupt = data.str();
+		corrupt.replace(20, 4, "\xf0\xff\xff\xff");
+		std::stringstream ss(corrupt);
+		PatternReader reader(ss);
+		REQUIRE_FALSE(reader.open());
+	}
+
+	SECTION("not a pattern file") {
+		std::stringstream ss("# sat_atpg journal 1f2e 10\n");
+		PatternReader reader(ss);
+		REQUIRE_FALSE(reader.open());
+	}
+}
+
+TEST_CASE("STIL export") {
+	C17Circuit c;
+	std::stringstream ss;
+	StilWriter writer(ss, c.graph);
+	writer.write_header();
+	// More than one simulation pass
+	for (size_t i = 0; i < 70; ++i) {
+		writer.write("00000");
+	}
+	writer.write("1X1X1");
+	REQUIRE(writer.finish());
+
+	std::string stil = ss.str();
+	REQUIRE(stil.compare(0, 9, "STIL 1.0;") == 0);
+	REQUIRE(stil.find("\"22\" Out;") != std::string::npos);
+	// 22 = NAND(NAND(1, 3), NAND(2, NAND(3, 6))), all zero inputs give 22 = 0, 23 = 0
+	REQUIRE(stil.find("\"pattern 0\": V { \"all_inputs\" = 00000; \"all_outputs\" = LL; }") != std::string::npos);
+	REQUIRE(stil.find("\"pattern 69\":") != std::string::npos);
+	// 1 = 3 = 1 gives 10 = 0 and 22 = 1, 23 depends on unknown inputs
+	REQUIRE(stil.find("\"pattern 70\": V { \"all_inputs\" = 1N1N1; \"all_outputs\" = HX; }") != std::string::npos);
+	REQUIRE(stil.substr(stil.size() - 2) == "}\n");
+}
+
+TEST_CASE("STIL export reports stream errors") {
+	C17Circuit c;
+	std::stringstream ss;
+	StilWriter writer(ss, c.graph);
+	writer.write_header();
+	writer.write("00000");
+	ss.setstate(std::ios::badbit);
+	REQUIRE_FALSE(writer.finish());
+}
@@ -0,0 +1,77 @@
+#include <catch.hpp>
+
+#include "../perf_baseline.h"
+
+#include <sstream>
+
+using Kind = PerfMetric::Kind;
+using Result = PerfComparison::Result;
+
+static Result compare(const PerfMetric& baseline, const PerfMetric& current)
+{
+	std::vector<PerfComparison> comparisons = compare_perf_metrics({baseline}, {current}, 0.05);
+	REQUIRE(comparisons.size() == 1);
+	return comparisons.front().result;
+}
+
+TEST_CASE("perf metrics writing and reading back") {
+	std::vector<PerfMetric> metrics = {
+		make_perf_metric(Kind::Time, "c17.bench/solve_us", {100, 110, 90}),
+		make_perf_metric(Kind::Count, "c17.bench/patterns", {12}),
+		make_perf_metric(Kind::Exact, "c17.bench/detected", {22}),
+	};
+	REQUIRE(metrics[0].mean == Approx(100));
+	REQUIRE(metrics[0].stddev == Approx(10));
+	REQUIRE(metrics[1].stddev == 0);
+
+	std::stringstream ss;
+	ss << "# baseline\n";
+	write_perf_metrics(ss, metrics);
+
+	std::vector<PerfMetric> read_metrics;
+	REQUIRE(read_perf_metrics(ss, read_metrics));
+	REQUIRE(read_metrics.size() == metrics.size());
+	for (size_t i = 0; i < metrics.size(); ++i) {
+		REQUIRE(read_metrics[i].kind == metrics[i].kind);
+		REQUIRE(read_metrics[i].name == metrics[i].name);
+		REQUIRE(read_metrics[i].mean == Approx(metrics[i].mean));
+		REQUIRE(read_metrics[i].stddev == Approx(metrics[i].stddev));
+		REQUIRE(read_metrics[i].samples == metrics[i].samples);
+	}
+
+	std::stringstream invalid("time solve_us 1.0\n");
+	REQUIRE_FALSE(read_perf_metrics(invalid, read_metrics));
+}
+
+TEST_CASE("perf metrics comparison") {
+	PerfMetric baseline = make_perf_metric(Kind::Time, "solve_us", {100, 102, 98, 101, 99});
+
+	SECTION("significant slowdown") {
+		REQUIRE(compare(baseline, make_perf_metric(Kind::Time, "solve_us", {120, 122, 118, 121, 119})) == Result::Regression);
+	}
+	SECTION("slowdown below threshold") {
+		REQUIRE(compare(baseline, make_perf_metric(Kind::Time, "solve_us", {103, 104, 102, 103, 103})) == Result::Same);
+	}
+	SECTION("slowdown hidden in noise") {
+		REQUIRE(compare(baseline, make_perf_metric(Kind::Time, "solve_us", {60, 200, 100})) == Result::Same);
+	}
+	SECTION("slowdown below absolute limit") {
+		std::vector<PerfMetric> current = {make_perf_metric(Kind::Time, "solve_us", {120, 122, 118, 121, 119})};
+		REQUIRE(compare_perf_metrics({baseline}, current, 0.05, 50).front().result == Result::Same);
+	}
+	SECTION("speedup") {
+		REQUIRE(compare(baseline, make_perf_metric(Kind::Time, "solve_us", {80, 81, 79, 80, 80})) == Result::Improvement);
+	}
+	SECTION("counts and exact values") {
+		REQUIRE(compare(make_perf_metric(Kind::Count, "unknown", {0}), make_perf_metric(Kind::Count, "unknown", {1})) == Result::Regression);
+		REQUIRE(compare(make_perf_metric(Kind::Count, "patterns", {100}), make_perf_metric(Kind::Count, "patterns", {90})) == Result::Improvement);
+		REQUIRE(compare(make_perf_metric(Kind::Exact, "detected", {100}), make_perf_metric(Kind::Exact, "detected", {101})) == Result::Regression);
+		REQUIRE(compare(make_perf_metric(Kind::Exact, "detected", {100}), make_perf_metric(Kind::Exact, "detected", {100})) == Result::Same);
+	}
+	SECTION("missing and new metrics") {
+		std::vector<PerfComparison> comparisons = compare_perf_metrics({baseline}, {make_perf_metric(Kind::Time, "parse_us", {1})}, 0.05);
+		REQUIRE(comparisons.size() == 2);
+		REQUIRE(comparisons[0].result == Result::Missing);
+		REQUIRE(comparisons[1].result == Result::New);
+	}
+}
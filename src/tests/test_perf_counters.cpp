@@ -0,0 +1,30 @@
+#include <catch.hpp>
+
+#include "../util/perf_counters.h"
+
+TEST_CASE("perf counters") {
+	PerfCounters counters;
+	PerfCounters::Values totals;
+	{
+		PerfScope scope(&counters, totals);
+		volatile uint64_t sum = 0;
+		for (uint64_t i = 0; i < 100000; ++i) {
+			sum += i;
+		}
+	}
+
+	if (counters.is_complete()) {
+		REQUIRE(counters.is_available());
+		REQUIRE(totals[PerfCounters::Instructions] > 0);
+	} else if (counters.is_available()) {
+		// Some counters are missing
+		REQUIRE_FALSE(counters.get_error().empty());
+	} else {
+		REQUIRE_FALSE(counters.get_error().empty());
+		REQUIRE(totals[PerfCounters::Cycles] == 0);
+		REQUIRE(totals[PerfCounters::Instructions] == 0);
+	}
+
+	// Scope without counters does nothing
+	PerfScope scope(nullptr, totals);
+}
@@ -0,0 +1,137 @@
+#include <catch.hpp>
+
+#include "../circuit_to_cnf.h"
+#include "../fault_simulator.h"
+#include "../implication.h"
+#include "../static_learning.h"
+
+#include "circuits.h"
+
+static CircuitGraph& parse(const std::string& str, CircuitGraph& graph)
+{
+	Iscas89Parser parser;
+	std::stringstream ss(str);
+	REQUIRE(parser.parse(ss, graph));
+	return graph;
+}
+
+// Checks clauses on all input patterns
+static void require_implied_by_circuit(const CircuitGraph& graph, const std::vector<clause_t>& clauses)
+{
+	size_t input_count = graph.get_inputs().size();
+	REQUIRE(input_count < 16);
+
+	std::vector<std::string> patterns;
+	for (size_t p = 0; p < (size_t(1) << input_count); ++p) {
+		std::string pattern;
+		for (size_t i = 0; i < input_count; ++i) {
+			pattern += (p >> i) & 1 ? '1' : '0';
+		}
+		patterns.push_back(pattern);
+	}
+
+	FaultSimulator simulator(graph);
+	std::vector<const Line*> lines(graph.line_id_end(), nullptr);
+	for (const Line& line : graph.get_lines()) {
+		lines[line.id] = &line;
+	}
+
+	for (size_t first = 0; first < patterns.size(); first += FaultSimulator::patterns_per_pass) {
+		size_t count = simulator.load_patterns(patterns, first);
+		uint64_t mask = count == 64 ? ~uint64_t(0) : (uint64_t(1) << count) - 1;
+		for (const clause_t& clause : clauses) {
+			uint64_t satisfied = 0;
+			for (literal_t l : clause) {
+				const FaultSimulator::Value& value = simulator.get_value(lines.at(literal_to_line(l)));
+				satisfied |= l > 0 ? value.one : value.zero;
+			}
+			CAPTURE(clause);
+			REQUIRE((satisfied & mask) == mask);
+		}
+	}
+}
+
+TEST_CASE("direct implications") {
+	TestCircuit tc;
+	ImplicationEngine engine(tc.graph);
+
+	REQUIRE(engine.assign(tc.y, 0));
+	REQUIRE(engine.get_value(tc.g) == 0);
+	REQUIRE(engine.get_value(tc.h) == 0);
+	REQUIRE(engine.get_value(tc.x1) == ImplicationEngine::unknown);
+
+	size_t trail_size = engine.get_trail_size();
+	REQUIRE(engine.assign(tc.x2, 0));
+	REQUIRE(engine.get_value(tc.f) == 1);
+	REQUIRE(engine.get_value(tc.x3) == 0);
+
+	engine.backtrack(trail_size);
+	REQUIRE(engine.get_value(tc.f) == ImplicationEngine::unknown);
+	REQUIRE(engine.is_unjustified(*tc.g->source));
+
+	REQUIRE(engine.assign(tc.x1, 1));
+	REQUIRE(engine.get_value(tc.x2) == 0);
+	REQUIRE(!engine.assign(tc.x3, 1));
+}
+
+TEST_CASE("static learning") {
+	CircuitGraph graph;
+	parse(R"(
+		INPUT(a)
+		INPUT(x)
+		INPUT(y)
+		OUTPUT(d)
+		OUTPUT(z)
+		b = OR(a, x)
+		c = OR(a, y)
+		d = AND(b, c)
+		n = NOT(a)
+		z = AND(a, n)
+	)", graph);
+
+	literal_t a = line_to_literal(graph.get_line("a")->id);
+	literal_t d = line_to_literal(graph.get_line("d")->id);
+	literal_t z = line_to_literal(graph.get_line("z")->id);
+
+	for (bool recursive : {false, true}) {
+		CAPTURE(recursive);
+		StaticLearner learner(graph);
+		learner.set_recursive_learning(recursive);
+		std::vector<clause_t> clauses = learner.learn();
+
+		// d=0 -> a=0 is not found by direct implications
+		REQUIRE((std::count(clauses.begin(), clauses.end(), clause_t{-a, d}) + std::count(clauses.begin(), clauses.end(), clause_t{d, -a})) == 1);
+
+		REQUIRE(learner.get_constant_lines() == 1);
+		REQUIRE(std::count(clauses.begin(), clauses.end(), clause_t{-z}) == 1);
+
+		require_implied_by_circuit(graph, clauses);
+	}
+}
+
+TEST_CASE("learned clauses are implied by circuit") {
+	for (bool recursive : {false, true}) {
+		CAPTURE(recursive);
+
+		SECTION("c17") {
+			C17Circuit c17;
+			StaticLearner learner(c17.graph);
+			learner.set_recursive_learning(recursive);
+			require_implied_by_circuit(c17.graph, learner.learn());
+		}
+
+		SECTION("s27") {
+			S27Circuit s27;
+			StaticLearner learner(s27.graph);
+			learner.set_recursive_learning(recursive);
+			require_implied_by_circuit(s27.graph, learner.learn());
+		}
+
+		SECTION("circuit with expandable gates") {
+			TestCircuitWithExpandableGates tc;
+			StaticLearner learner(tc.graph);
+			learner.set_recursive_learning(recursive);
+			require_implied_by_circuit(tc.graph, learner.learn());
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#include <catch.hpp>
+
+#include "../tuning_config.h"
+
+#include <sstream>
+
+TEST_CASE("tuning config reading") {
+	std::stringstream ss;
+	ss << "# comment\n";
+	ss << "threshold_ratio = 0.25\n";
+	ss << "\n";
+	ss << "incremental=1 # trailing comment\n";
+	ss << "dominators=1\n";
+	ss << "option.restartint=50\n";
+	ss << "option.phase=0\n";
+	ss << "option.restartint=100\n";
+
+	TuningConfig config;
+	REQUIRE(read_tuning_config(ss, config));
+	REQUIRE(config.threshold_ratio == Approx(0.25));
+	REQUIRE(config.incremental);
+	REQUIRE(config.use_dominators);
+	REQUIRE_FALSE(config.static_learning);
+	REQUIRE_FALSE(config.nary_gates);
+	REQUIRE(config.solver_options.size() == 2);
+	REQUIRE(config.solver_options[0] == std::make_pair(std::string("restartint"), 100));
+	REQUIRE(config.solver_options[1] == std::make_pair(std::string("phase"), 0));
+}
+
+TEST_CASE("tuning config writing and reading back") {
+	TuningConfig config;
+	config.threshold_ratio = 0.3f;
+	config.static_learning = true;
+	config.nary_gates = true;
+	config.solver_options = {{"rephase", 1}, {"restartint", 2000}};
+
+	std::stringstream ss;
+	write_tuning_config(ss, config);
+
+	TuningConfig read_config;
+	REQUIRE(read_tuning_config(ss, read_config));
+	REQUIRE(get_tuning_values(read_config) == get_tuning_values(config));
+}
+
+TEST_CASE("invalid tuning config") {
+	TuningConfig config;
+	REQUIRE_FALSE(set_tuning_value(config, "unknown", "1"));
+	REQUIRE_FALSE(set_tuning_value(config, "incremental", "2"));
+	REQUIRE_FALSE(set_tuning_value(config, "threshold_ratio", "0.5x"));
+	REQUIRE_FALSE(set_tuning_value(config, "option.", "1"));
+	REQUIRE_FALSE(set_tuning_value(config, "option.phase", "yes"));
+
+	std::stringstream ss("incremental\n");
+	REQUIRE_FALSE(read_tuning_config(ss, config));
+}
@@ -0,0 +1,51 @@
+#include <catch.hpp>
+
+#include "../worker_pool.h"
+
+#include <map>
+
+#ifdef __unix__
+#include <unistd.h>
+#endif
+
+TEST_CASE("worker pool") {
+	std::vector<size_t> fault_ids;
+	for (size_t i = 0; i < 100; ++i) {
+		fault_ids.push_back(i * 3);
+	}
+
+	auto solve = [](size_t fault_id, WorkerResult& result) {
+#ifdef __unix__
+		if (fault_id == 60) {
+			_exit(1);
+		}
+#endif
+		result.record.status = fault_id % 2 ? FaultStatus::Undetectable : FaultStatus::Detectable;
+		result.record.pattern = std::to_string(fault_id);
+		result.cnf_time_us = fault_id;
+	};
+
+	std::map<size_t, WorkerResult> results;
+	WorkerPool pool(3);
+	pool.set_range_size(7);
+	REQUIRE(pool.run(fault_ids, solve, [&](const WorkerResult& result) {
+		REQUIRE(results.count(result.record.fault_id) == 0);
+		results[result.record.fault_id] = result;
+	}));
+
+	REQUIRE(results.size() == fault_ids.size());
+	for (size_t fault_id : fault_ids) {
+		CAPTURE(fault_id);
+		const WorkerResult& result = results.at(fault_id);
+#ifdef __unix__
+		if (fault_id == 60) {
+			REQUIRE(result.record.status == FaultStatus::Unknown);
+			REQUIRE(pool.get_crashed_workers() == 1);
+			continue;
+		}
+#endif
+		REQUIRE(result.record.status == (fault_id % 2 ? FaultStatus::Undetectable : FaultStatus::Detectable));
+		REQUIRE(result.record.pattern == std::to_string(fault_id));
+		REQUIRE(result.cnf_time_us == fault_id);
+	}
+}
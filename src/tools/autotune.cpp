@@ -0,0 +1,378 @@
+#include "../circuit_graph.h"
+#include "../iscas89_parser.h"
+#include "../fault_cnf.h"
+#include "../fault_manager.h"
+#include "../incremental_solver.h"
+#include "../solver_proxy.h"
+#include "../static_learning.h"
+#include "../tuning_config.h"
+#include "../sat/sat_solver.h"
+
+#include "../util/log.h"
+#include "../util/timer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+// Searches ATPG settings and solver options that classify a fault sample of given circuits fastest.
+// Every configuration solves the same faults with a conflict limit per fault, configurations are ranked
+// by aborted faults first and total time second. The best one is written in the format of atpgSat --config.
+
+namespace
+{
+
+// Values of one configuration key tried by the search
+struct Dimension
+{
+	std::string key;
+	std::vector<std::string> values;
+};
+
+std::vector<Dimension> make_default_space()
+{
+	return {
+		{"cost_model", {"0", "1"}},
+		{"threshold_ratio", {"0", "0.3", "0.6", "1"}},
+		{"incremental", {"0", "1"}},
+		{"dominators", {"0", "1"}},
+		{"static_learning", {"0", "1"}},
+		{"nary_gates", {"0", "1"}},
+		{"option.rephase", {"0", "1"}},
+		{"option.restartint", {"50", "400", "2000"}},
+		{"option.phase", {"0", "1"}},
+	};
+}
+
+struct Circuit
+{
+	std::string path;
+	std::unique_ptr<CircuitGraph> graph;
+	std::unique_ptr<FaultManager> fault_manager;
+	std::vector<size_t> sample;
+
+	// Static learning is done once and its time is added to every configuration that uses it
+	bool has_learned_clauses = false;
+	std::vector<clause_t> learned_clauses;
+	uint64_t learning_time_us = 0;
+};
+
+struct Evaluation
+{
+	TuningConfig config;
+	std::string name;
+	uint64_t total_time_us = 0;
+	uint64_t p50_us = 0;
+	uint64_t p99_us = 0;
+	size_t aborts = 0;
+
+	bool operator<(const Evaluation& other) const
+	{
+		return std::tie(aborts, total_time_us) < std::tie(other.aborts, other.total_time_us);
+	}
+};
+
+uint64_t get_percentile(const std::vector<uint64_t>& sorted_times, size_t percent)
+{
+	if (sorted_times.empty()) {
+		return 0;
+	}
+	// Nearest rank
+	size_t rank = (sorted_times.size() * percent + 99) / 100;
+	return sorted_times[std::max<size_t>(rank, 1) - 1];
+}
+
+std::string get_config_name(const TuningConfig& config)
+{
+	std::string name;
+	for (const auto& value : get_tuning_values(config)) {
+		if (!name.empty()) {
+			name += ' ';
+		}
+		name += value.first + "=" + value.second;
+	}
+	return name;
+}
+
+std::unique_ptr<SatSolver> make_solver(const TuningConfig& config, int64_t conflict_limit)
+{
+	std::unique_ptr<SatSolver> solver = SolverFactory::make_solver();
+	if (!solver) {
+		return solver;
+	}
+	for (const auto& option : config.solver_options) {
+		if (!solver->set_option(option.first, option.second)) {
+			return nullptr;
+		}
+	}
+	solver->set_conflict_limit(conflict_limit);
+	return solver;
+}
+
+// Adds solve time of every sampled fault to fault_times, returns false if solver can't be made
+bool evaluate_circuit(const TuningConfig& config, Circuit& circuit, int64_t conflict_limit, std::vector<uint64_t>& fault_times, Evaluation& evaluation)
+{
+	const CircuitGraph& graph = *circuit.graph;
+	if (config.static_learning) {
+		if (!circuit.has_learned_clauses) {
+			ElapsedTimer timer(true);
+			StaticLearner learner(graph);
+			learner.set_max_assignments(200000000);
+			circuit.learned_clauses = learner.learn();
+			circuit.learning_time_us = timer.get_elapsed_us();
+			circuit.has_learned_clauses = true;
+		}
+		evaluation.total_time_us += circuit.learning_time_us;
+	}
+
+	std::unique_ptr<SatSolver> solver = make_solver(config, conflict_limit);
+	if (!solver) {
+		return false;
+	}
+
+	GateEncoding gate_encoding = config.nary_gates ? GateEncoding::Nary : GateEncoding::Expanded;
+	ElapsedTimer timer;
+	if (config.incremental) {
+		IncrementalFaultSolver incremental_solver(graph, std::move(solver), gate_encoding);
+		incremental_solver.get_fault_cnf_maker().set_use_dominators(config.use_dominators);
+		if (config.static_learning) {
+			incremental_solver.add_circuit_clauses(circuit.learned_clauses);
+		}
+		for (size_t fault_id : circuit.sample) {
+			timer.start();
+			SatSolver::SolveStatus status = incremental_solver.solve(circuit.fault_manager->get_fault(fault_id));
+			fault_times.push_back(timer.get_elapsed_us());
+			evaluation.aborts += status == SatSolver::Unknown;
+		}
+	} else {
+		FaultCnfMaker fault_cnf_maker(graph, gate_encoding);
+		fault_cnf_maker.set_use_cost_model(config.cost_model);
+		fault_cnf_maker.set_threshold_ratio(config.threshold_ratio);
+		fault_cnf_maker.set_use_dominators(config.use_dominators);
+		if (config.static_learning) {
+			fault_cnf_maker.set_learned_clauses(circuit.learned_clauses);
+		}
+		ProxyCnf proxy(*solver);
+		for (size_t fault_id : circuit.sample) {
+			timer.start();
+			fault_cnf_maker.make_fault(circuit.fault_manager->get_fault(fault_id), proxy);
+			SatSolver::SolveStatus status = solver->solve_prepared();
+			fault_times.push_back(timer.get_elapsed_us());
+			fault_cnf_maker.add_solve_time(fault_times.back());
+			evaluation.aborts += status == SatSolver::Unknown;
+		}
+	}
+	return true;
+}
+
+bool evaluate(const TuningConfig& config, std::vector<Circuit>& circuits, int64_t conflict_limit, Evaluation& evaluation)
+{
+	evaluation = Evaluation();
+	evaluation.config = config;
+	evaluation.name = get_config_name(config);
+
+	std::vector<uint64_t> fault_times;
+	for (Circuit& circuit : circuits) {
+		if (!evaluate_circuit(config, circuit, conflict_limit, fault_times, evaluation)) {
+			return false;
+		}
+	}
+
+	for (uint64_t time : fault_times) {
+		evaluation.total_time_us += time;
+	}
+	std::sort(fault_times.begin(), fault_times.end());
+	evaluation.p50_us = get_percentile(fault_times, 50);
+	evaluation.p99_us = get_percentile(fault_times, 99);
+	return true;
+}
+
+TuningConfig make_config(const std::vector<Dimension>& space, const std::vector<size_t>& choice)
+{
+	TuningConfig config;
+	for (size_t i = 0; i < space.size(); ++i) {
+		set_tuning_value(config, space[i].key, space[i].values[choice[i]]);
+	}
+	if (config.incremental || config.cost_model) {
+		// Ratio isn't used, configurations that only differ in it are the same
+		config.threshold_ratio = TuningConfig().threshold_ratio;
+	}
+	if (config.incremental) {
+		// Whole circuit is always loaded
+		config.cost_model = TuningConfig().cost_model;
+	}
+	return config;
+}
+
+// Replaces values of the key or adds a new dimension, spec is key=value1,value2,...
+bool parse_dimension(const std::string& spec, std::vector<Dimension>& space)
+{
+	size_t equals = spec.find('=');
+	if (equals == std::string::npos || equals + 1 == spec.size()) {
+		return false;
+	}
+	Dimension dimension;
+	dimension.key = spec.substr(0, equals);
+	std::istringstream values(spec.substr(equals + 1));
+	std::string value;
+	TuningConfig check;
+	while (std::getline(values, value, ',')) {
+		if (!set_tuning_value(check, dimension.key, value)) {
+			return false;
+		}
+		dimension.values.push_back(value);
+	}
+
+	auto it = std::find_if(space.begin(), space.end(), [&dimension](const Dimension& d) { return d.key == dimension.key; });
+	if (it != space.end()) {
+		*it = dimension;
+	} else {
+		space.push_back(dimension);
+	}
+	return true;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> circuit_paths;
+	std::string output_path = "atpg.cfg";
+	std::vector<Dimension> space = make_default_space();
+	bool grid = false;
+	size_t iterations = 20;
+	size_t sample_size = 200;
+	int64_t conflict_limit = 10000;
+	unsigned seed = 1;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		try {
+			if (arg == "--output" && has_value) {
+				output_path = argv[++i];
+			} else if (arg == "--grid") {
+				grid = true;
+			} else if (arg == "--iterations" && has_value) {
+				iterations = std::stoul(argv[++i]);
+			} else if (arg == "--sample" && has_value) {
+				sample_size = std::stoul(argv[++i]);
+			} else if (arg == "--conflicts" && has_value) {
+				conflict_limit = std::stol(argv[++i]);
+			} else if (arg == "--seed" && has_value) {
+				seed = std::stoul(argv[++i]);
+			} else if (arg == "--param" && has_value) {
+				if (!parse_dimension(argv[++i], space)) {
+					log_error() << "invalid parameter" << argv[i] << "expected key=value1,value2,...";
+					return 1;
+				}
+			} else if (arg.compare(0, 2, "--") == 0) {
+				log_error() << "unknown option" << arg;
+				return 1;
+			} else {
+				circuit_paths.push_back(arg);
+			}
+		} catch (const std::exception&) {
+			log_error() << "invalid value for" << arg << argv[i];
+			return 1;
+		}
+	}
+
+	if (circuit_paths.empty()) {
+		log_error() << "usage:" << argv[0] << "<circuit.bench>... [--grid | --iterations N] [--sample N] [--conflicts N] [--seed N]"
+			<< "[--param key=value1,value2,...] [--output <config file>]";
+		return 1;
+	}
+
+	std::mt19937 random(seed);
+
+	std::vector<Circuit> circuits(circuit_paths.size());
+	for (size_t i = 0; i < circuits.size(); ++i) {
+		Circuit& circuit = circuits[i];
+		circuit.path = circuit_paths[i];
+		circuit.graph.reset(new CircuitGraph());
+
+		std::ifstream ifs(circuit.path);
+		Iscas89Parser parser;
+		if (!ifs.good() || !parser.parse(ifs, *circuit.graph)) {
+			log_error() << "can't parse file" << circuit.path;
+			return 1;
+		}
+
+		circuit.fault_manager.reset(new FaultManager(*circuit.graph));
+		circuit.sample.resize(circuit.fault_manager->get_fault_count());
+		for (size_t id = 0; id < circuit.sample.size(); ++id) {
+			circuit.sample[id] = id;
+		}
+		std::shuffle(circuit.sample.begin(), circuit.sample.end(), random);
+		if (sample_size && circuit.sample.size() > sample_size) {
+			circuit.sample.resize(sample_size);
+		}
+		log_info() << circuit.path << ":" << circuit.sample.size() << "faults out of" << circuit.fault_manager->get_fault_count();
+	}
+
+	// Configurations to try, the first one is the baseline with default values
+	std::vector<TuningConfig> configs = {TuningConfig()};
+	std::set<std::string> known_names = {get_config_name(configs.front())};
+	std::vector<size_t> choice(space.size(), 0);
+	if (grid) {
+		while (true) {
+			TuningConfig config = make_config(space, choice);
+			if (known_names.insert(get_config_name(config)).second) {
+				configs.push_back(config);
+			}
+			size_t i = 0;
+			for (; i < space.size(); ++i) {
+				if (++choice[i] < space[i].values.size()) {
+					break;
+				}
+				choice[i] = 0;
+			}
+			if (i == space.size()) {
+				break;
+			}
+		}
+	} else {
+		// Duplicates are drawn again a limited number of times, small spaces may have fewer configurations
+		for (size_t attempt = 0; configs.size() <= iterations && attempt < iterations * 10; ++attempt) {
+			for (size_t i = 0; i < space.size(); ++i) {
+				choice[i] = std::uniform_int_distribution<size_t>(0, space[i].values.size() - 1)(random);
+			}
+			TuningConfig config = make_config(space, choice);
+			if (known_names.insert(get_config_name(config)).second) {
+				configs.push_back(config);
+			}
+		}
+	}
+	log_info() << "Trying" << configs.size() << "configurations";
+
+	std::vector<Evaluation> evaluations(configs.size());
+	for (size_t i = 0; i < configs.size(); ++i) {
+		Evaluation& evaluation = evaluations[i];
+		if (!evaluate(configs[i], circuits, conflict_limit, evaluation)) {
+			log_error() << "can't make solver for" << get_config_name(configs[i]);
+			return 1;
+		}
+		log_info() << "  " << "total:" << evaluation.total_time_us / 1000 << "ms p50:" << evaluation.p50_us << "us p99:" << evaluation.p99_us
+			<< "us aborts:" << evaluation.aborts << "|" << evaluation.name;
+	}
+
+	const Evaluation& baseline = evaluations.front();
+	const Evaluation& best = *std::min_element(evaluations.begin(), evaluations.end());
+	log_info() << "";
+	log_info() << "Baseline:" << baseline.total_time_us / 1000 << "ms," << baseline.aborts << "aborts";
+	log_info() << "Best:" << best.total_time_us / 1000 << "ms," << best.aborts << "aborts |" << best.name;
+
+	std::ofstream ofs(output_path);
+	if (!ofs.good()) {
+		log_error() << "can't write configuration" << output_path;
+		return 1;
+	}
+	write_tuning_config(ofs, best.config);
+	log_info() << "Configuration written to" << output_path;
+	return 0;
+}
@@ -0,0 +1,100 @@
+#include "../circuit_graph.h"
+#include "../iscas89_parser.h"
+#include "../pattern_io.h"
+
+#include "../util/log.h"
+
+#include <fstream>
+#include <memory>
+
+// Converts a binary pattern file written by atpgSat --patterns to text (same format as atpgMerge --patterns)
+// or STIL-like ASCII with expected output values.
+
+int main(int argc, char* argv[])
+{
+	std::string circuit_path;
+	std::string patterns_path;
+	std::string text_path;
+	std::string stil_path;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--text" && i + 1 < argc) {
+			text_path = argv[++i];
+		} else if (arg == "--stil" && i + 1 < argc) {
+			stil_path = argv[++i];
+		} else if (circuit_path.empty()) {
+			circuit_path = arg;
+		} else if (patterns_path.empty()) {
+			patterns_path = arg;
+		} else {
+			patterns_path.clear();
+			break;
+		}
+	}
+
+	if (circuit_path.empty() || patterns_path.empty()) {
+		log_error() << "usage:" << argv[0] << "<circuit.bench> <patterns> [--text <output file>] [--stil <output file>]";
+		return 1;
+	}
+
+	std::ifstream ifs(circuit_path);
+	CircuitGraph graph;
+	Iscas89Parser parser;
+	if (!ifs.good() || !parser.parse(ifs, graph)) {
+		log_error() << "can't parse file" << circuit_path;
+		return 1;
+	}
+
+	std::ifstream patterns_ifs(patterns_path, std::ios::binary);
+	PatternReader reader(patterns_ifs);
+	if (!patterns_ifs.good() || !reader.open()) {
+		log_error() << "can't read patterns" << patterns_path;
+		return 1;
+	}
+	if (!check_pattern_inputs(reader, graph)) {
+		return 1;
+	}
+
+	std::ofstream text_ofs;
+	if (!text_path.empty()) {
+		text_ofs.open(text_path);
+		if (!text_ofs.good()) {
+			log_error() << "can't open file" << text_path;
+			return 1;
+		}
+		text_ofs << "# inputs:";
+		for (const Line* input : graph.get_inputs()) {
+			text_ofs << " " << input->name;
+		}
+		text_ofs << "\n";
+	}
+
+	std::ofstream stil_ofs;
+	std::unique_ptr<StilWriter> stil_writer;
+	if (!stil_path.empty()) {
+		stil_ofs.open(stil_path);
+		if (!stil_ofs.good()) {
+			log_error() << "can't open file" << stil_path;
+			return 1;
+		}
+		stil_writer.reset(new StilWriter(stil_ofs, graph));
+		stil_writer->write_header();
+	}
+
+	size_t pattern_count = 0;
+	for (std::string pattern; reader.read(pattern); ++pattern_count) {
+		if (text_ofs.is_open()) {
+			text_ofs << pattern << "\n";
+		}
+		if (stil_writer) {
+			stil_writer->write(pattern);
+		}
+	}
+	if (stil_writer && !stil_writer->finish()) {
+		log_error() << "can't write file" << stil_path;
+		return 1;
+	}
+
+	log_info() << "Patterns:" << pattern_count << "for" << graph.get_inputs().size() << "inputs";
+	return 0;
+}
@@ -0,0 +1,135 @@
+#include "../circuit_graph.h"
+#include "../iscas89_parser.h"
+#include "../fault_dictionary.h"
+#include "../fault_manager.h"
+#include "../pattern_io.h"
+
+#include "../util/log.h"
+#include "../util/timer.h"
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+// Builds a fault dictionary for a binary pattern file (atpgSat --patterns) and ranks candidate faults
+// for failure logs of tested devices. A failure log has one failure per line, "<pattern index> <output name>",
+// the output is optional with --pass-fail. Lines starting with '#' are comments.
+
+static bool read_failures(const std::string& path, const CircuitGraph& graph, bool pass_fail, std::vector<FaultDictionary::Failure>& failures)
+{
+	std::ifstream ifs(path);
+	if (!ifs.good()) {
+		log_error() << "can't open file" << path;
+		return false;
+	}
+
+	std::unordered_map<std::string, size_t> output_indices;
+	for (size_t i = 0; i < graph.get_outputs().size(); ++i) {
+		output_indices[graph.get_outputs()[i]->name] = i;
+	}
+
+	size_t line_number = 0;
+	for (std::string line; std::getline(ifs, line); ) {
+		++line_number;
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+		std::istringstream ss(line);
+		FaultDictionary::Failure failure = {0, 0};
+		std::string output;
+		if (!(ss >> failure.pattern)) {
+			log_error() << path << ":" << line_number << "expected pattern index";
+			return false;
+		}
+		if (ss >> output) {
+			auto it = output_indices.find(output);
+			if (it == output_indices.end()) {
+				log_error() << path << ":" << line_number << "unknown output" << output;
+				return false;
+			}
+			failure.output_idx = it->second;
+		} else if (!pass_fail) {
+			log_error() << path << ":" << line_number << "expected output name";
+			return false;
+		}
+		failures.push_back(failure);
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string circuit_path;
+	std::string patterns_path;
+	std::vector<std::string> failures_paths;
+	bool pass_fail = false;
+	size_t max_candidates = 10;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--failures" && i + 1 < argc) {
+			failures_paths.push_back(argv[++i]);
+		} else if (arg == "--pass-fail") {
+			pass_fail = true;
+		} else if (arg == "--candidates" && i + 1 < argc) {
+			max_candidates = std::stoul(argv[++i]);
+		} else if (circuit_path.empty()) {
+			circuit_path = arg;
+		} else if (patterns_path.empty()) {
+			patterns_path = arg;
+		} else {
+			patterns_path.clear();
+			break;
+		}
+	}
+
+	if (circuit_path.empty() || patterns_path.empty()) {
+		log_error() << "usage:" << argv[0] << "<circuit.bench> <patterns> [--failures <file>]... [--pass-fail] [--candidates N]";
+		return 1;
+	}
+
+	std::ifstream ifs(circuit_path);
+	CircuitGraph graph;
+	Iscas89Parser parser;
+	if (!ifs.good() || !parser.parse(ifs, graph)) {
+		log_error() << "can't parse file" << circuit_path;
+		return 1;
+	}
+
+	std::ifstream patterns_ifs(patterns_path, std::ios::binary);
+	PatternReader reader(patterns_ifs);
+	if (!patterns_ifs.good() || !reader.open()) {
+		log_error() << "can't read patterns" << patterns_path;
+		return 1;
+	}
+	if (!check_pattern_inputs(reader, graph)) {
+		return 1;
+	}
+	std::vector<std::string> patterns;
+	for (std::string pattern; reader.read(pattern); ) {
+		patterns.push_back(pattern);
+	}
+
+	FaultManager fault_manager(graph);
+	FaultDictionary dictionary(pass_fail ? FaultDictionary::Type::PassFail : FaultDictionary::Type::FullResponse);
+	ElapsedTimer timer(true);
+	dictionary.build(graph, fault_manager, patterns);
+	log_info() << "Dictionary:" << dictionary.get_fault_count() << "faults," << dictionary.get_pattern_count() << "patterns,"
+		<< dictionary.get_block_count() << "blocks," << dictionary.get_memory_bytes() / 1024 << "KiB," << timer.get_elapsed_ms() << "ms";
+
+	for (const std::string& path : failures_paths) {
+		std::vector<FaultDictionary::Failure> failures;
+		if (!read_failures(path, graph, pass_fail, failures)) {
+			return 1;
+		}
+		timer.start();
+		std::vector<FaultDictionary::Candidate> candidates = dictionary.diagnose(failures, max_candidates);
+		log_info() << path << ":" << failures.size() << "failures," << timer.get_elapsed_us() << "us";
+		log_info() << "  rank fault matches mispredictions nonpredictions";
+		for (size_t i = 0; i < candidates.size(); ++i) {
+			const FaultDictionary::Candidate& candidate = candidates[i];
+			log_info() << "  " << i + 1 << get_fault_name(fault_manager.get_fault(candidate.fault_id))
+				<< candidate.matches << candidate.mispredictions << candidate.nonpredictions;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include "../netlist_generator.h"
+
+#include "../util/log.h"
+
+#include <fstream>
+#include <iostream>
+
+// Writes a random combinational netlist in .bench format, the same options and seed give the same netlist.
+
+static bool parse_option(NetlistGeneratorConfig& config, const std::string& name, const std::string& value)
+{
+	try {
+		if (name == "--seed") {
+			config.seed = std::stoull(value);
+		} else if (name == "--gates") {
+			config.gates = std::stoull(value);
+		} else if (name == "--inputs") {
+			config.inputs = std::stoull(value);
+		} else if (name == "--outputs") {
+			config.outputs = std::stoull(value);
+		} else if (name == "--depth") {
+			config.depth = std::stoull(value);
+		} else if (name == "--max-fanin") {
+			config.max_fanin = std::stoull(value);
+		} else if (name == "--level-span") {
+			config.level_span = std::stoull(value);
+		} else if (name == "--fanout-skew") {
+			config.fanout_skew = std::stod(value);
+		} else if (name == "--reconvergence") {
+			config.reconvergence = std::stod(value);
+		} else if (name == "--xor") {
+			config.xor_density = std::stod(value);
+		} else if (name == "--inverters") {
+			config.inverter_density = std::stod(value);
+		} else if (name == "--redundancy") {
+			config.redundancy = std::stod(value);
+		} else {
+			return false;
+		}
+	} catch (const std::exception&) {
+		log_error() << "Invalid value" << value << "for" << name;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	NetlistGeneratorConfig config;
+	std::string output_path;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (i + 1 >= argc) {
+			log_error() << "Missing value for" << arg;
+			return 1;
+		}
+		if (arg == "--output") {
+			output_path = argv[++i];
+		} else if (!parse_option(config, arg, argv[++i])) {
+			log_error() << "usage:" << argv[0] << "[--gates N] [--inputs N] [--outputs N] [--depth N] [--max-fanin N] [--level-span N]"
+				<< "[--fanout-skew X] [--reconvergence P] [--xor P] [--inverters P] [--redundancy P] [--seed N] [--output <file.bench>]";
+			return 1;
+		}
+	}
+
+	NetlistGenerator generator(config);
+
+	if (output_path.empty()) {
+		generator.write_bench(std::cout);
+	} else {
+		std::ofstream ofs(output_path);
+		generator.write_bench(ofs);
+		if (!ofs) {
+			log_error() << "Can't write" << output_path;
+			return 1;
+		}
+		// Log goes to stdout, so only when it doesn't mix with the netlist
+		log_info() << "Generated" << generator.get_gate_count() << "gates," << generator.get_output_count() << "outputs";
+	}
+	return 0;
+}
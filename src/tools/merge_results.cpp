@@ -0,0 +1,175 @@
+#include "../circuit_graph.h"
+#include "../iscas89_parser.h"
+#include "../fault_manager.h"
+#include "../fault_simulator.h"
+#include "../journal.h"
+
+#include "../util/log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_set>
+
+// Merges journals of sharded runs of the same circuit into one coverage report and pattern set.
+// Patterns are fault simulated against all faults and patterns that don't detect anything new are dropped.
+
+int main(int argc, char* argv[])
+{
+	std::string circuit_path;
+	std::string patterns_path;
+	std::vector<std::string> journal_paths;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--patterns" && i + 1 < argc) {
+			patterns_path = argv[++i];
+		} else if (circuit_path.empty()) {
+			circuit_path = arg;
+		} else {
+			journal_paths.push_back(arg);
+		}
+	}
+
+	if (circuit_path.empty() || journal_paths.empty()) {
+		log_error() << "usage:" << argv[0] << "<circuit.bench> <journal>... [--patterns <output file>]";
+		return 1;
+	}
+
+	std::ifstream ifs(circuit_path);
+	CircuitGraph graph;
+	Iscas89Parser parser;
+	if (!ifs.good() || !parser.parse(ifs, graph)) {
+		log_error() << "can't parse file" << circuit_path;
+		return 1;
+	}
+
+	FaultManager fault_manager(graph);
+	const size_t fault_count = fault_manager.get_fault_count();
+
+	std::vector<FaultStatus> statuses(fault_count, FaultStatus::Unknown);
+	std::vector<std::string> patterns;
+	std::unordered_set<std::string> unique_patterns;
+	size_t conflicts = 0;
+
+	for (const std::string& path : journal_paths) {
+		std::ifstream journal_ifs(path);
+		JournalHeader header;
+		std::vector<FaultRecord> records;
+		if (!journal_ifs.good() || !read_journal(journal_ifs, header, records)) {
+			log_error() << "can't read journal" << path;
+			return 1;
+		}
+		if (header.circuit_hash != graph.get_hash() || header.fault_count != fault_count) {
+			log_error() << "journal" << path << "was written for a different circuit";
+			return 1;
+		}
+
+		for (const FaultRecord& record : records) {
+			FaultStatus& status = statuses[record.fault_id];
+			if (record.status == FaultStatus::Detectable) {
+				if (status == FaultStatus::Undetectable) {
+					++conflicts;
+				}
+				status = FaultStatus::Detectable;
+				if (record.pattern.size() == graph.get_inputs().size() && unique_patterns.insert(record.pattern).second) {
+					patterns.push_back(record.pattern);
+				}
+			} else if (record.status == FaultStatus::Undetectable) {
+				if (status == FaultStatus::Detectable) {
+					++conflicts;
+				} else {
+					status = FaultStatus::Undetectable;
+				}
+			}
+		}
+	}
+
+	// Patterns generated later target harder faults and usually detect the easy ones too,
+	// so they are simulated first
+	std::reverse(patterns.begin(), patterns.end());
+
+	FaultSimulator simulator(graph);
+	std::vector<uint8_t> detected(fault_count, 0);
+	std::vector<uint8_t> keep_pattern(patterns.size(), 0);
+	for (size_t first = 0; first < patterns.size(); first += FaultSimulator::patterns_per_pass) {
+		simulator.load_patterns(patterns, first);
+		for (size_t id = 0; id < fault_count; ++id) {
+			if (detected[id] || statuses[id] == FaultStatus::Undetectable) {
+				continue;
+			}
+			uint64_t mask = simulator.simulate_fault(fault_manager.get_fault(id));
+			if (!mask) {
+				continue;
+			}
+			detected[id] = 1;
+
+			size_t first_detecting = 0;
+			while (!(mask & 1)) {
+				mask >>= 1;
+				++first_detecting;
+			}
+			keep_pattern[first + first_detecting] = 1;
+		}
+	}
+
+	size_t detectable = 0;
+	size_t undetectable = 0;
+	size_t unknown = 0;
+	size_t detected_by_simulation = 0;
+	size_t not_detected_by_patterns = 0;
+	for (size_t id = 0; id < fault_count; ++id) {
+		if (detected[id]) {
+			++detectable;
+			if (statuses[id] != FaultStatus::Detectable) {
+				++detected_by_simulation;
+			}
+		} else if (statuses[id] == FaultStatus::Detectable) {
+			++detectable;
+			++not_detected_by_patterns;
+		} else if (statuses[id] == FaultStatus::Undetectable) {
+			++undetectable;
+		} else {
+			++unknown;
+		}
+	}
+
+	std::vector<std::string> compacted;
+	for (size_t i = patterns.size(); i > 0; --i) {
+		if (keep_pattern[i - 1]) {
+			compacted.push_back(patterns[i - 1]);
+		}
+	}
+
+	log_info() << "Total:" << fault_count;
+	log_info() << "Detectable:" << detectable;
+	log_info() << "Undetectable:" << undetectable;
+	log_info() << "UNKNOWN:" << unknown;
+	log_info() << "Fault coverage:" << (fault_count ? 100.0 * detectable / fault_count : 100.0) << "%";
+	log_info() << "Patterns (merged/compacted):" << patterns.size() << compacted.size();
+	if (detected_by_simulation) {
+		log_info() << "Detected by simulation only:" << detected_by_simulation;
+	}
+	if (not_detected_by_patterns) {
+		log_warning() << not_detected_by_patterns << "detectable faults are not detected by any pattern";
+	}
+	if (conflicts) {
+		log_warning() << conflicts << "faults have conflicting results in different journals";
+	}
+
+	if (!patterns_path.empty()) {
+		std::ofstream ofs(patterns_path);
+		if (!ofs.good()) {
+			log_error() << "can't open file" << patterns_path;
+			return 1;
+		}
+		ofs << "# inputs:";
+		for (const Line* input : graph.get_inputs()) {
+			ofs << " " << input->name;
+		}
+		ofs << "\n";
+		for (const std::string& pattern : compacted) {
+			ofs << pattern << "\n";
+		}
+	}
+
+	return not_detected_by_patterns || conflicts ? 2 : 0;
+}
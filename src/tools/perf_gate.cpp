@@ -0,0 +1,298 @@
+#include "../circuit_graph.h"
+#include "../fault_cnf.h"
+#include "../fault_manager.h"
+#include "../incremental_solver.h"
+#include "../iscas89_parser.h"
+#include "../perf_baseline.h"
+#include "../solver_proxy.h"
+
+#include "../util/log.h"
+#include "../util/timer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <unordered_set>
+
+// Runs ATPG on circuits several times and compares phase times, fault classification and pattern counts
+// against a baseline written by an earlier run. Exits with 2 if anything regressed significantly.
+
+struct RunMetrics
+{
+	uint64_t parse_us = 0;
+	uint64_t faults_us = 0;
+	uint64_t encode_us = 0;
+	uint64_t solve_us = 0;
+	uint64_t total_us = 0;
+
+	size_t detected = 0;
+	size_t undetectable = 0;
+	size_t unknown = 0;
+	size_t patterns = 0;
+	uint64_t hash = 0;
+};
+
+static bool run_atpg(const std::string& netlist, int64_t conflict_limit, RunMetrics& metrics)
+{
+	std::unique_ptr<SatSolver> solver = SolverFactory::make_solver();
+	if (!solver) {
+		log_error() << "No SAT solver";
+		return false;
+	}
+	solver->set_conflict_limit(conflict_limit);
+
+	ElapsedTimer total_timer(true);
+	ElapsedTimer timer(true);
+	CircuitGraph graph;
+	std::istringstream is(netlist);
+	Iscas89Parser parser;
+	if (!parser.parse(is, graph)) {
+		return false;
+	}
+	metrics.parse_us = timer.get_elapsed_us();
+	metrics.hash = graph.get_hash();
+
+	timer.start();
+	FaultManager fault_manager(graph);
+	metrics.faults_us = timer.get_elapsed_us();
+
+	// Cost model choices depend on measured times, a fixed threshold gives the same CNFs and counts every run
+	FaultCnfMaker fault_cnf_maker(graph);
+	fault_cnf_maker.set_use_cost_model(false);
+	fault_cnf_maker.set_threshold_ratio(0.6f);
+	ProxyCnf proxy(*solver);
+	std::unordered_set<std::string> patterns;
+	for (size_t fault_id = 0; fault_id < fault_manager.get_fault_count(); ++fault_id) {
+		timer.start();
+		fault_cnf_maker.make_fault(fault_manager.get_fault(fault_id), proxy);
+		metrics.encode_us += timer.get_elapsed_us();
+
+		timer.start();
+		SatSolver::SolveStatus status = solver->solve_prepared();
+		uint64_t solve_us = timer.get_elapsed_us();
+		metrics.solve_us += solve_us;
+
+		if (status == SatSolver::Sat) {
+			++metrics.detected;
+			patterns.insert(make_pattern(*solver, graph));
+		} else if (status == SatSolver::Unsat) {
+			++metrics.undetectable;
+		} else {
+			++metrics.unknown;
+		}
+	}
+	metrics.patterns = patterns.size();
+	metrics.total_us = total_timer.get_elapsed_us();
+	return true;
+}
+
+static bool measure_circuit(const std::string& path, size_t runs, int64_t conflict_limit, std::vector<PerfMetric>& metrics)
+{
+	std::ifstream ifs(path);
+	std::stringstream netlist;
+	netlist << ifs.rdbuf();
+	if (!ifs.good()) {
+		log_error() << "can't read" << path;
+		return false;
+	}
+
+	// Warm-up run, also gives the deterministic counts
+	RunMetrics first;
+	if (!run_atpg(netlist.str(), conflict_limit, first)) {
+		log_error() << "can't parse file" << path;
+		return false;
+	}
+
+	std::map<std::string, std::vector<double>> times;
+	for (size_t run = 0; run < runs; ++run) {
+		RunMetrics current;
+		run_atpg(netlist.str(), conflict_limit, current);
+		times["parse_us"].push_back(current.parse_us);
+		times["faults_us"].push_back(current.faults_us);
+		times["encode_us"].push_back(current.encode_us);
+		times["solve_us"].push_back(current.solve_us);
+		times["total_us"].push_back(current.total_us);
+	}
+
+	std::string prefix = path.substr(path.find_last_of('/') + 1) + "/";
+	for (const auto& phase : times) {
+		metrics.push_back(make_perf_metric(PerfMetric::Kind::Time, prefix + phase.first, phase.second));
+	}
+	// Netlist changed if the hash differs, truncated to the bits a double holds exactly
+	metrics.push_back(make_perf_metric(PerfMetric::Kind::Exact, prefix + "hash", {static_cast<double>(first.hash % (1ull << 52))}));
+	metrics.push_back(make_perf_metric(PerfMetric::Kind::Exact, prefix + "detected", {static_cast<double>(first.detected)}));
+	metrics.push_back(make_perf_metric(PerfMetric::Kind::Exact, prefix + "undetectable", {static_cast<double>(first.undetectable)}));
+	metrics.push_back(make_perf_metric(PerfMetric::Kind::Count, prefix + "unknown", {static_cast<double>(first.unknown)}));
+	metrics.push_back(make_perf_metric(PerfMetric::Kind::Count, prefix + "patterns", {static_cast<double>(first.patterns)}));
+
+	log_info() << prefix << first.detected << "detected," << first.undetectable << "undetectable," << first.unknown << "unknown,"
+		<< first.patterns << "patterns";
+	return true;
+}
+
+// Reads results written by `bench --json`
+static bool read_bench_results(const std::string& path, std::vector<PerfMetric>& metrics)
+{
+	std::ifstream ifs(path);
+	if (!ifs.good()) {
+		log_error() << "can't read" << path;
+		return false;
+	}
+	static const std::regex result_regex(
+		R"r(.*"name": "([^"]+)".*"samples": (\d+),.*"mean_ns": ([0-9.]+), "stddev_ns": ([0-9.]+).*)r");
+	size_t found = 0;
+	for (std::string line; std::getline(ifs, line);) {
+		std::smatch matches;
+		if (!std::regex_match(line, matches, result_regex)) {
+			continue;
+		}
+		PerfMetric metric;
+		metric.kind = PerfMetric::Kind::Time;
+		metric.name = "bench/" + matches[1].str() + "_us";
+		metric.samples = std::stoul(matches[2]);
+		metric.mean = std::stod(matches[3]) / 1000;
+		metric.stddev = std::stod(matches[4]) / 1000;
+		metrics.push_back(metric);
+		++found;
+	}
+	if (!found) {
+		log_error() << "no benchmark results in" << path;
+		return false;
+	}
+	return true;
+}
+
+static const char* get_result_name(PerfComparison::Result result)
+{
+	switch (result) {
+		case PerfComparison::Result::Same:
+			return "ok";
+		case PerfComparison::Result::Regression:
+			return "REGRESSION";
+		case PerfComparison::Result::Improvement:
+			return "improvement";
+		case PerfComparison::Result::Missing:
+			return "MISSING";
+		case PerfComparison::Result::New:
+			return "new";
+	}
+	return "?";
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> circuit_paths;
+	std::vector<std::string> bench_paths;
+	std::string baseline_path;
+	std::string write_path;
+	size_t runs = 5;
+	int64_t conflict_limit = 10000;
+	double min_relative_change = 0.05;
+	double min_absolute_change_us = 500;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		bool has_value = i + 1 < argc;
+		try {
+			if (arg == "--baseline" && has_value) {
+				baseline_path = argv[++i];
+			} else if (arg == "--write-baseline" && has_value) {
+				write_path = argv[++i];
+			} else if (arg == "--bench-results" && has_value) {
+				bench_paths.push_back(argv[++i]);
+			} else if (arg == "--runs" && has_value) {
+				runs = std::max(1, std::stoi(argv[++i]));
+			} else if (arg == "--conflicts" && has_value) {
+				conflict_limit = std::stoll(argv[++i]);
+			} else if (arg == "--threshold" && has_value) {
+				min_relative_change = std::stod(argv[++i]);
+			} else if (arg == "--min-change-us" && has_value) {
+				min_absolute_change_us = std::stod(argv[++i]);
+			} else if (arg.compare(0, 2, "--") != 0) {
+				circuit_paths.push_back(arg);
+			} else {
+				circuit_paths.clear();
+				bench_paths.clear();
+				break;
+			}
+		} catch (const std::exception&) {
+			log_error() << "invalid value for" << arg;
+			return 1;
+		}
+	}
+
+	if ((circuit_paths.empty() && bench_paths.empty()) || (baseline_path.empty() && write_path.empty())) {
+		log_error() << "usage:" << argv[0] << "<circuit.bench>... [--bench-results <bench.json>]... (--baseline <file> | --write-baseline <file>)"
+			<< "[--runs N] [--conflicts N] [--threshold <relative change>] [--min-change-us N]";
+		return 1;
+	}
+
+	std::vector<PerfMetric> baseline;
+	if (!baseline_path.empty()) {
+		std::ifstream ifs(baseline_path);
+		if (!ifs.good() || !read_perf_metrics(ifs, baseline)) {
+			log_error() << "can't read baseline" << baseline_path;
+			return 1;
+		}
+	}
+
+	std::vector<PerfMetric> metrics;
+	for (const std::string& path : circuit_paths) {
+		if (!measure_circuit(path, runs, conflict_limit, metrics)) {
+			return 1;
+		}
+	}
+	for (const std::string& path : bench_paths) {
+		if (!read_bench_results(path, metrics)) {
+			return 1;
+		}
+	}
+
+	if (!write_path.empty()) {
+		std::ofstream ofs(write_path);
+		write_perf_metrics(ofs, metrics);
+		if (!ofs) {
+			log_error() << "can't write" << write_path;
+			return 1;
+		}
+		log_info() << "Baseline with" << metrics.size() << "metrics written to" << write_path;
+	}
+
+	if (baseline.empty()) {
+		return 0;
+	}
+
+	size_t name_width = 10;
+	for (const PerfMetric& metric : metrics) {
+		name_width = std::max(name_width, metric.name.size() + 2);
+	}
+
+	size_t regressions = 0;
+	size_t missing = 0;
+	std::cout << std::left << std::setw(name_width) << "metric" << std::right << std::setw(20) << "baseline" << std::setw(20) << "current"
+		<< std::setw(10) << "change" << "  result\n";
+	for (const PerfComparison& comparison : compare_perf_metrics(baseline, metrics, min_relative_change, min_absolute_change_us)) {
+		regressions += comparison.result == PerfComparison::Result::Regression;
+		missing += comparison.result == PerfComparison::Result::Missing;
+		std::cout << std::left << std::setw(name_width) << comparison.name << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(20) << comparison.baseline << std::setw(20) << comparison.current
+			<< std::setw(9) << comparison.relative_change * 100 << "%  " << get_result_name(comparison.result) << "\n";
+	}
+
+	if (regressions) {
+		log_error() << regressions << "metrics regressed";
+	}
+	// E.g. a circuit or benchmark was dropped from the run, it must not pass unnoticed
+	if (missing) {
+		log_error() << missing << "baseline metrics are missing from the current run";
+	}
+	if (regressions || missing) {
+		return 2;
+	}
+	log_info() << "No significant regressions";
+	return 0;
+}
@@ -0,0 +1,139 @@
+#include "../circuit_graph.h"
+#include "../iscas89_parser.h"
+#include "../fault_manager.h"
+#include "../journal.h"
+#include "../pattern_io.h"
+#include "../pattern_validator.h"
+
+#include "../util/log.h"
+#include "../util/timer.h"
+
+#include <fstream>
+
+// Validates patterns by fault simulation against the full fault list.
+// Patterns come from binary pattern files (atpgSat --patterns) and journals, every detected fault
+// of a journal claims its pattern as a test. Reports fault coverage, claimed tests that don't detect
+// their fault and undetectable faults detected by some pattern. Exit code is 2 if any check fails.
+
+int main(int argc, char* argv[])
+{
+	std::string circuit_path;
+	std::vector<std::string> patterns_paths;
+	std::vector<std::string> journal_paths;
+	std::string detections_path;
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		if (arg == "--patterns" && i + 1 < argc) {
+			patterns_paths.push_back(argv[++i]);
+		} else if (arg == "--journal" && i + 1 < argc) {
+			journal_paths.push_back(argv[++i]);
+		} else if (arg == "--detections" && i + 1 < argc) {
+			detections_path = argv[++i];
+		} else if (circuit_path.empty()) {
+			circuit_path = arg;
+		} else {
+			circuit_path.clear();
+			break;
+		}
+	}
+
+	if (circuit_path.empty() || (patterns_paths.empty() && journal_paths.empty())) {
+		log_error() << "usage:" << argv[0] << "<circuit.bench> [--patterns <file>]... [--journal <file>]... [--detections <output file>]";
+		return 1;
+	}
+
+	std::ifstream ifs(circuit_path);
+	CircuitGraph graph;
+	Iscas89Parser parser;
+	if (!ifs.good() || !parser.parse(ifs, graph)) {
+		log_error() << "can't parse file" << circuit_path;
+		return 1;
+	}
+
+	FaultManager fault_manager(graph);
+	const size_t fault_count = fault_manager.get_fault_count();
+	PatternValidator validator(graph, fault_manager);
+
+	std::ofstream detections_ofs;
+	if (!detections_path.empty()) {
+		detections_ofs.open(detections_path);
+		if (!detections_ofs.good()) {
+			log_error() << "can't open file" << detections_path;
+			return 1;
+		}
+		// One line per pattern: index and names of detected faults, tab separated
+		validator.set_detection_function([&](size_t pattern_index, const std::vector<size_t>& fault_ids) {
+			detections_ofs << pattern_index;
+			for (size_t id : fault_ids) {
+				detections_ofs << '\t' << get_fault_name(fault_manager.get_fault(id));
+			}
+			detections_ofs << '\n';
+		});
+	}
+
+	ElapsedTimer timer(true);
+	std::vector<uint8_t> undetectable(fault_count, 0);
+
+	for (const std::string& path : journal_paths) {
+		std::ifstream journal_ifs(path);
+		JournalHeader header;
+		std::vector<FaultRecord> records;
+		if (!journal_ifs.good() || !read_journal(journal_ifs, header, records)) {
+			log_error() << "can't read journal" << path;
+			return 1;
+		}
+		if (header.circuit_hash != graph.get_hash() || header.fault_count != fault_count) {
+			log_error() << "journal" << path << "was written for a different circuit";
+			return 1;
+		}
+
+		for (const FaultRecord& record : records) {
+			if (record.status == FaultStatus::Detectable && record.pattern.size() == graph.get_inputs().size()) {
+				validator.add_pattern(record.pattern, record.fault_id);
+			} else if (record.status == FaultStatus::Undetectable) {
+				undetectable[record.fault_id] = 1;
+			}
+		}
+	}
+
+	for (const std::string& path : patterns_paths) {
+		std::ifstream patterns_ifs(path, std::ios::binary);
+		PatternReader reader(patterns_ifs);
+		if (!patterns_ifs.good() || !reader.open()) {
+			log_error() << "can't read patterns" << path;
+			return 1;
+		}
+		if (!check_pattern_inputs(reader, graph)) {
+			return 1;
+		}
+		for (std::string pattern; reader.read(pattern); ) {
+			validator.add_pattern(pattern);
+		}
+	}
+	validator.flush();
+	uint64_t elapsed_ms = timer.get_elapsed_ms();
+
+	size_t wrongly_undetectable = 0;
+	for (size_t id = 0; id < fault_count; ++id) {
+		if (undetectable[id] && validator.is_detected(id)) {
+			log_error() << "fault" << get_fault_name(fault_manager.get_fault(id)) << "is classified undetectable but detected by patterns";
+			++wrongly_undetectable;
+		}
+	}
+	for (const PatternValidator::FailedClaim& claim : validator.get_failed_claims()) {
+		log_error() << "pattern" << claim.pattern_index << "doesn't detect fault" << get_fault_name(fault_manager.get_fault(claim.fault_id));
+	}
+
+	log_info() << "Patterns:" << validator.get_pattern_count();
+	log_info() << "Total:" << fault_count;
+	log_info() << "Detected:" << validator.get_detected_count();
+	log_info() << "Fault coverage:" << (fault_count ? 100.0 * validator.get_detected_count() / fault_count : 100.0) << "%";
+	log_info() << "Claimed tests (total/failed):" << validator.get_claim_count() << validator.get_failed_claims().size();
+	log_info() << "Undetectable but detected:" << wrongly_undetectable;
+	log_info() << "Validation time:" << elapsed_ms << "ms";
+
+	if (!validator.get_failed_claims().empty() || wrongly_undetectable) {
+		return 2;
+	}
+	return 0;
+}
@@ -0,0 +1,124 @@
+#include "tuning_config.h"
+
+#include "util/log.h"
+
+#include <algorithm>
+#include <sstream>
+
+static const std::string option_prefix = "option.";
+
+static std::string trim(const std::string& str)
+{
+	size_t begin = str.find_first_not_of(" \t\r");
+	if (begin == std::string::npos) {
+		return {};
+	}
+	size_t end = str.find_last_not_of(" \t\r");
+	return str.substr(begin, end - begin + 1);
+}
+
+static bool parse_int(const std::string& str, int& value)
+{
+	try {
+		size_t pos = 0;
+		value = std::stoi(str, &pos);
+		return pos == str.size();
+	} catch (const std::exception&) {
+		return false;
+	}
+}
+
+bool set_tuning_value(TuningConfig& config, const std::string& key, const std::string& value)
+{
+	int int_value = 0;
+	if (key == "threshold_ratio") {
+		try {
+			size_t pos = 0;
+			config.threshold_ratio = std::stof(value, &pos);
+			if (pos == value.size()) {
+				return true;
+			}
+		} catch (const std::exception&) {
+		}
+	} else if (key.compare(0, option_prefix.size(), option_prefix) == 0 && key.size() > option_prefix.size()) {
+		if (parse_int(value, int_value)) {
+			std::string name = key.substr(option_prefix.size());
+			auto it = std::find_if(config.solver_options.begin(), config.solver_options.end(),
+				[&name](const std::pair<std::string, int>& option) { return option.first == name; });
+			if (it != config.solver_options.end()) {
+				it->second = int_value;
+			} else {
+				config.solver_options.emplace_back(name, int_value);
+			}
+			return true;
+		}
+	} else if (key == "cost_model" || key == "incremental" || key == "dominators" || key == "static_learning" || key == "nary_gates") {
+		if (parse_int(value, int_value) && (int_value == 0 || int_value == 1)) {
+			bool* flag = &config.cost_model;
+			if (key == "incremental") {
+				flag = &config.incremental;
+			} else if (key == "dominators") {
+				flag = &config.use_dominators;
+			} else if (key == "static_learning") {
+				flag = &config.static_learning;
+			} else if (key == "nary_gates") {
+				flag = &config.nary_gates;
+			}
+			*flag = int_value;
+			return true;
+		}
+	} else {
+		log_error() << "unknown configuration key" << key;
+		return false;
+	}
+
+	log_error() << "invalid value" << value << "for" << key;
+	return false;
+}
+
+std::vector<std::pair<std::string, std::string>> get_tuning_values(const TuningConfig& config)
+{
+	std::ostringstream ratio;
+	ratio << config.threshold_ratio;
+
+	std::vector<std::pair<std::string, std::string>> values = {
+		{"cost_model", std::to_string(int(config.cost_model))},
+		{"threshold_ratio", ratio.str()},
+		{"incremental", std::to_string(int(config.incremental))},
+		{"dominators", std::to_string(int(config.use_dominators))},
+		{"static_learning", std::to_string(int(config.static_learning))},
+		{"nary_gates", std::to_string(int(config.nary_gates))},
+	};
+	for (const auto& option : config.solver_options) {
+		values.emplace_back(option_prefix + option.first, std::to_string(option.second));
+	}
+	return values;
+}
+
+bool read_tuning_config(std::istream& is, TuningConfig& config)
+{
+	std::string line;
+	for (size_t line_number = 1; std::getline(is, line); ++line_number) {
+		line = trim(line.substr(0, line.find('#')));
+		if (line.empty()) {
+			continue;
+		}
+		size_t equals = line.find('=');
+		if (equals == std::string::npos) {
+			log_error() << "configuration line" << line_number << "is not key=value";
+			return false;
+		}
+		if (!set_tuning_value(config, trim(line.substr(0, equals)), trim(line.substr(equals + 1)))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void write_tuning_config(std::ostream& os, const TuningConfig& config)
+{
+	os << "# sat_atpg configuration, load with atpgSat --config <file>\n";
+	for (const auto& value : get_tuning_values(config)) {
+		os << value.first << "=" << value.second << "\n";
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ATPG settings chosen by atpgTune and loaded by atpgSat with --config.
+// Stored as text with one key=value per line, '#' starts a comment:
+// 	cost_model=1
+// 	threshold_ratio=0.6
+// 	incremental=0
+// 	dominators=0
+// 	static_learning=0
+// 	nary_gates=0
+// 	option.<solver option>=<value>
+struct TuningConfig
+{
+	bool cost_model = true; // partial or full CNF is chosen by estimated cost, otherwise by threshold_ratio
+	float threshold_ratio = 0.6f;
+	bool incremental = false; // whole circuit stays loaded in one solver between faults
+	bool use_dominators = false;
+	bool static_learning = false;
+	bool nary_gates = false; // wide AND/OR gates encoded directly instead of as chains of two-input gates
+	std::vector<std::pair<std::string, int>> solver_options; // applied on top of solver defaults
+};
+
+// Returns false and logs an error for unknown keys and invalid values
+bool set_tuning_value(TuningConfig& config, const std::string& key, const std::string& value);
+
+// All values in file order, solver options last
+std::vector<std::pair<std::string, std::string>> get_tuning_values(const TuningConfig& config);
+
+bool read_tuning_config(std::istream& is, TuningConfig& config);
+void write_tuning_config(std::ostream& os, const TuningConfig& config);
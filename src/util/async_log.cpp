@@ -0,0 +1,130 @@
+#include "async_log.h"
+
+struct AsyncLogWriter::ThreadBuffer
+{
+	std::string data;
+
+	~ThreadBuffer()
+	{
+		AsyncLogWriter& writer = AsyncLogWriter::instance();
+		if (!data.empty() && writer.is_running()) {
+			writer.submit(data);
+		}
+	}
+};
+
+AsyncLogWriter& AsyncLogWriter::instance()
+{
+	static AsyncLogWriter writer;
+	return writer;
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+	stop();
+}
+
+AsyncLogWriter::ThreadBuffer& AsyncLogWriter::get_thread_buffer()
+{
+	static thread_local ThreadBuffer buffer;
+	return buffer;
+}
+
+void AsyncLogWriter::start(std::streambuf* output, size_t batch_size)
+{
+	stop();
+	m_output = output;
+	m_batch_size = batch_size;
+	m_stop = false;
+	m_thread = std::thread(&AsyncLogWriter::run, this);
+	m_running.store(true, std::memory_order_release);
+}
+
+void AsyncLogWriter::stop()
+{
+	if (!m_thread.joinable()) {
+		return;
+	}
+	if (is_running()) {
+		flush();
+	}
+	m_running.store(false, std::memory_order_release);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_work_cv.notify_one();
+	m_thread.join();
+}
+
+void AsyncLogWriter::write(const char* data, size_t size, bool urgent)
+{
+	std::string& buffer = get_thread_buffer().data;
+	buffer.append(data, size);
+	if (urgent || buffer.size() >= m_batch_size) {
+		submit(buffer);
+	}
+}
+
+void AsyncLogWriter::flush()
+{
+	std::string& buffer = get_thread_buffer().data;
+	if (!buffer.empty()) {
+		submit(buffer);
+	}
+	std::unique_lock<std::mutex> lock(m_mutex);
+	uint64_t request = ++m_flush_requests;
+	m_work_cv.notify_one();
+	m_done_cv.wait(lock, [this, request]() { return m_flushed >= request; });
+}
+
+void AsyncLogWriter::submit(std::string& buffer)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(std::move(buffer));
+		buffer.clear();
+		if (!m_free_buffers.empty()) {
+			buffer.swap(m_free_buffers.back());
+			m_free_buffers.pop_back();
+		}
+	}
+	m_work_cv.notify_one();
+	buffer.reserve(m_batch_size);
+}
+
+void AsyncLogWriter::run()
+{
+	std::vector<std::string> batches;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true) {
+		m_work_cv.wait(lock, [this]() { return !m_queue.empty() || m_flush_requests > m_flushed || m_stop; });
+		batches.swap(m_queue);
+		uint64_t flush_request = m_flush_requests;
+		bool stop = m_stop;
+		lock.unlock();
+
+		for (std::string& batch : batches) {
+			m_output->sputn(batch.data(), batch.size());
+		}
+		if (flush_request > m_flushed || stop) {
+			m_output->pubsync();
+		}
+
+		lock.lock();
+		for (std::string& batch : batches) {
+			if (m_free_buffers.size() < 16) {
+				batch.clear();
+				m_free_buffers.push_back(std::move(batch));
+			}
+		}
+		batches.clear();
+		if (flush_request > m_flushed) {
+			m_flushed = flush_request;
+			m_done_cv.notify_all();
+		}
+		if (stop && m_queue.empty()) {
+			break;
+		}
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Writes log records from a background thread, so logging threads never wait for output or flush per line.
+// Every thread collects whole records in its own buffer, full buffers are handed to the writer in batches.
+// Records of one thread keep their order, records of different threads are interleaved batch by batch.
+// Buffers of exiting threads are handed over automatically, stop() must be called after other logging threads finished.
+class AsyncLogWriter
+{
+public:
+	static AsyncLogWriter& instance();
+
+	~AsyncLogWriter();
+
+	// Output must not be used by anyone else until stop()
+	void start(std::streambuf* output, size_t batch_size = 1 << 16);
+	// Writes everything and flushes output
+	void stop();
+
+	bool is_running() const { return m_running.load(std::memory_order_acquire); }
+
+	// Appends to buffer of the calling thread, urgent records (e.g. errors) are handed to the writer right away
+	void write(const char* data, size_t size, bool urgent = false);
+
+	// Waits until everything the calling thread wrote is in output and output is flushed
+	void flush();
+
+	// For forked child processes: the writer thread doesn't exist there, logging goes back to direct output
+	void detach() { m_running.store(false, std::memory_order_release); }
+
+private:
+	struct ThreadBuffer;
+
+	AsyncLogWriter() = default;
+
+	void submit(std::string& buffer);
+	void run();
+	static ThreadBuffer& get_thread_buffer();
+
+	std::atomic<bool> m_running{false};
+	std::streambuf* m_output = nullptr;
+	size_t m_batch_size = 0;
+	std::thread m_thread;
+
+	std::mutex m_mutex;
+	std::condition_variable m_work_cv;
+	std::condition_variable m_done_cv;
+	std::vector<std::string> m_queue;
+	std::vector<std::string> m_free_buffers;
+	uint64_t m_flush_requests = 0;
+	uint64_t m_flushed = 0;
+	bool m_stop = false;
+};
+
+// Stops the writer when leaving scope, so every return path writes pending records
+class AsyncLogGuard
+{
+public:
+	~AsyncLogGuard() { AsyncLogWriter::instance().stop(); }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "timer.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Append-only file writer that keeps records in memory and hands them to the OS in large chunks.
+// Data is flushed when the buffer fills up, when flush interval passes or on destruction.
+// Once a write fails the writer stays failed, write(), flush() and close() return false from then on.
+class BufferedWriter
+{
+public:
+	BufferedWriter(size_t buffer_size = 1 << 16, uint64_t flush_interval_ms = 1000)
+		: m_buffer_size(buffer_size)
+		, m_flush_interval_ms(flush_interval_ms)
+	{
+		m_buffer.reserve(m_buffer_size);
+	}
+
+	BufferedWriter(const BufferedWriter&) = delete;
+
+	~BufferedWriter()
+	{
+		close();
+	}
+
+	bool open(const std::string& path, bool append = true)
+	{
+		close();
+		m_file = std::fopen(path.c_str(), append ? "ab" : "wb");
+		m_has_failed = false;
+		m_flush_timer.start();
+		return m_file;
+	}
+
+	bool is_open() const { return m_file; }
+	bool has_failed() const { return m_has_failed; }
+
+	bool close()
+	{
+		if (!m_file) {
+			return !m_has_failed;
+		}
+		flush();
+		if (std::fclose(m_file) != 0) {
+			m_has_failed = true;
+		}
+		m_file = nullptr;
+		return !m_has_failed;
+	}
+
+	bool write(const char* data, size_t size)
+	{
+		m_buffer.insert(m_buffer.end(), data, data + size);
+		if (m_buffer.size() >= m_buffer_size || m_flush_timer.get_elapsed_ms() >= m_flush_interval_ms) {
+			return flush();
+		}
+		return !m_has_failed;
+	}
+
+	bool write(const std::string& str)
+	{
+		return write(str.data(), str.size());
+	}
+
+	bool flush()
+	{
+		if (!m_file) {
+			return !m_has_failed;
+		}
+		if (!m_buffer.empty()) {
+			if (std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+				m_has_failed = true;
+			}
+			m_buffer.clear();
+		}
+		if (std::fflush(m_file) != 0) {
+			m_has_failed = true;
+		}
+		m_flush_timer.start();
+		return !m_has_failed;
+	}
+
+private:
+	std::FILE* m_file = nullptr;
+	bool m_has_failed = false;
+	std::vector<char> m_buffer;
+	size_t m_buffer_size = 0;
+	uint64_t m_flush_interval_ms = 0;
+	ElapsedTimer m_flush_timer;
+};
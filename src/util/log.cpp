@@ -1,6 +1,10 @@
 #include "log.h"
 
+#include "async_log.h"
+
 #include <iostream>
+#include <memory>
+#include <vector>
 
 #if DEBUG
 	Logger::LogLevel Logger::s_log_level = Logger::LogLevel::Debug;
@@ -9,3 +13,69 @@
 #endif
 
 std::ostream Logger::s_log_stream(std::cout.rdbuf());
+
+namespace
+{
+	class RecordBuffer : public std::streambuf
+	{
+	public:
+		std::string data;
+
+	protected:
+		int_type overflow(int_type ch) override
+		{
+			if (ch != traits_type::eof()) {
+				data.push_back(traits_type::to_char_type(ch));
+			}
+			return ch;
+		}
+
+		std::streamsize xsputn(const char* s, std::streamsize count) override
+		{
+			data.append(s, count);
+			return count;
+		}
+	};
+
+	struct Record
+	{
+		RecordBuffer buffer;
+		std::ostream stream{&buffer};
+	};
+
+	// Stack, because a value written to a logger can log something itself
+	struct RecordStack
+	{
+		std::vector<std::unique_ptr<Record>> records;
+		size_t depth = 0;
+	};
+
+	thread_local RecordStack t_records;
+}
+
+std::ostream& Logger::begin_record()
+{
+	if (t_records.depth == t_records.records.size()) {
+		t_records.records.emplace_back(new Record());
+	}
+	Record& record = *t_records.records[t_records.depth++];
+	record.buffer.data.clear();
+	record.stream.clear();
+	return record.stream;
+}
+
+void Logger::end_record(bool endl, bool urgent)
+{
+	std::string& data = t_records.records[--t_records.depth]->buffer.data;
+	if (endl) {
+		data.push_back('\n');
+	}
+
+	AsyncLogWriter& writer = AsyncLogWriter::instance();
+	if (writer.is_running()) {
+		writer.write(data.data(), data.size(), urgent);
+	} else {
+		s_log_stream.write(data.data(), data.size());
+		s_log_stream.flush();
+	}
+}
@@ -87,41 +87,40 @@ public:
 	{
 		m_level = level;
 		if (m_level <= s_log_level) {
+			m_stream = &begin_record();
 			if (m_level == LogLevel::Error) {
 				*this << (LogColor::fgBrightRed);
 			} else if (m_level == LogLevel::Warning) {
 				*this << (LogColor::fgBrightYellow);
 			}
 			if (prefix)
-				s_log_stream << prefix;
+				*m_stream << prefix;
 			if (file)
-				s_log_stream << '(' << file;
+				*m_stream << '(' << file;
 			if (line) {
-				s_log_stream << ':';
-				s_log_stream << line;
+				*m_stream << ':';
+				*m_stream << line;
 			}
 			if (file)
-				s_log_stream << ')';
+				*m_stream << ')';
 			if (prefix)
-				s_log_stream << ": ";
+				*m_stream << ": ";
 		}
 	}
 
 	~Logger()
 	{
-		if (m_level <= s_log_level) {
+		if (m_stream) {
 			if (m_need_reset_font) {
 				*this << LogColor::fgDefault << LogColor::bgDefaut;
 			}
-			if (m_endl)
-				s_log_stream << std::endl;
-			else
-				s_log_stream.flush();
+			end_record(m_endl, m_level <= LogLevel::Warning);
 		}
 	}
 
 	static void set_log_level(LogLevel level) { s_log_level = level; }
 	static void set_ostream(std::streambuf* buf) { s_log_stream.rdbuf(buf); }
+	static std::streambuf* get_streambuf() { return s_log_stream.rdbuf(); }
 
 	template<typename T>
 	Logger& operator<<(const T& val)
@@ -135,7 +134,8 @@ public:
 		(void)color_code;
 		m_need_reset_font = true;
 #if USE_ANSI_ESCAPE_CODES
-		s_log_stream << std::string("\033[") + std::to_string(color_code) + "m";
+		if (m_stream)
+			*m_stream << std::string("\033[") + std::to_string(color_code) + "m";
 #endif
 		return *this;
 	}
@@ -212,14 +212,19 @@ private:
 	auto write(const T& val) ->
 	typename std::enable_if<TypeSelector<T>::is_basic, void>::type
 	{
-		if (m_level <= s_log_level) {
-			s_log_stream << val;
+		if (m_stream) {
+			*m_stream << val;
 			if (m_space)
-				s_log_stream << ' ';
+				*m_stream << ' ';
 		}
 	}
 
+	// Whole record is collected in a thread local buffer and written at once, directly or by AsyncLogWriter
+	static std::ostream& begin_record();
+	static void end_record(bool endl, bool urgent);
+
 	LogLevel m_level = LogLevel::Info;
+	std::ostream* m_stream = nullptr; // record buffer, nullptr if level is disabled
 	bool m_endl = true;
 	bool m_space = true;
 
@@ -0,0 +1,116 @@
+#include "perf_counters.h"
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+static int open_counter(uint64_t config, int group_fd)
+{
+	perf_event_attr attr;
+	std::memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = config;
+	attr.disabled = group_fd < 0;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP;
+	return syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+PerfCounters::PerfCounters()
+{
+	static const uint64_t configs[CounterCount] = {
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES,
+	};
+
+	for (size_t i = 0; i < CounterCount; ++i) {
+		m_fds[i] = open_counter(configs[i], m_group_fd);
+		if (m_fds[i] < 0) {
+			if (m_error.empty()) {
+				m_error = std::strerror(errno);
+			}
+		} else if (m_group_fd < 0) {
+			m_group_fd = m_fds[i];
+		}
+	}
+
+	if (m_group_fd >= 0) {
+		ioctl(m_group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(m_group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+}
+
+PerfCounters::~PerfCounters()
+{
+	for (int fd : m_fds) {
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+}
+
+bool PerfCounters::is_complete() const
+{
+	for (int fd : m_fds) {
+		if (fd < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+PerfCounters::Values PerfCounters::read() const
+{
+	Values values;
+	if (m_group_fd < 0) {
+		return values;
+	}
+
+	// Group format: number of counters followed by their values in the order they were opened
+	uint64_t data[1 + CounterCount] = {};
+	if (::read(m_group_fd, data, sizeof(data)) <= 0) {
+		return values;
+	}
+	size_t next = 1;
+	for (size_t i = 0; i < CounterCount && next <= data[0]; ++i) {
+		if (m_fds[i] >= 0) {
+			values.values[i] = data[next++];
+		}
+	}
+	return values;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+	: m_error("only supported on Linux")
+{
+	for (int& fd : m_fds) {
+		fd = -1;
+	}
+}
+
+PerfCounters::~PerfCounters()
+{}
+
+bool PerfCounters::is_complete() const
+{
+	return false;
+}
+
+PerfCounters::Values PerfCounters::read() const
+{
+	return {};
+}
+
+#endif
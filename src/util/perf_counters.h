@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Hardware performance counters of the calling thread (perf_event_open on Linux).
+// If counters can't be opened (other OS, perf_event_paranoid, virtual machines without PMU)
+// is_available() is false and all values read as zero.
+class PerfCounters
+{
+public:
+	enum Counter
+	{
+		Cycles,
+		Instructions,
+		CacheMisses,
+		BranchMisses,
+
+		CounterCount,
+	};
+
+	struct Values
+	{
+		uint64_t values[CounterCount] = {};
+
+		uint64_t operator[](Counter counter) const { return values[counter]; }
+
+		Values& operator+=(const Values& other)
+		{
+			for (size_t i = 0; i < CounterCount; ++i) {
+				values[i] += other.values[i];
+			}
+			return *this;
+		}
+	};
+
+	PerfCounters();
+	~PerfCounters();
+
+	PerfCounters(const PerfCounters&) = delete;
+
+	bool is_available() const { return m_group_fd >= 0; }
+	// All counters could be opened, e.g. virtual machines often have cycles but no cache misses
+	bool is_complete() const;
+	// Reason why counters are not available
+	const std::string& get_error() const { return m_error; }
+
+	// Values since construction, counters that couldn't be opened stay zero
+	Values read() const;
+
+private:
+	int m_group_fd = -1;
+	int m_fds[CounterCount];
+	std::string m_error;
+};
+
+// Adds counter increments from construction to destruction to totals
+class PerfScope
+{
+public:
+	PerfScope(const PerfCounters* counters, PerfCounters::Values& totals)
+		: m_counters(counters && counters->is_available() ? counters : nullptr)
+		, m_totals(totals)
+	{
+		if (m_counters) {
+			m_start = m_counters->read();
+		}
+	}
+
+	PerfScope(const PerfScope&) = delete;
+
+	~PerfScope()
+	{
+		if (!m_counters) {
+			return;
+		}
+		PerfCounters::Values end = m_counters->read();
+		for (size_t i = 0; i < PerfCounters::CounterCount; ++i) {
+			m_totals.values[i] += end.values[i] - m_start.values[i];
+		}
+	}
+
+private:
+	const PerfCounters* m_counters;
+	PerfCounters::Values& m_totals;
+	PerfCounters::Values m_start;
+};
@@ -0,0 +1,89 @@
+#include "trace.h"
+
+#include "log.h"
+
+#if ENABLE_TRACING
+
+#include "buffered_writer.h"
+
+#include <map>
+
+constexpr size_t TraceBuffer::capacity;
+
+static void add_us(std::string& out, uint64_t ns)
+{
+	// Trace event timestamps are microseconds, fractions keep nanosecond precision
+	out += std::to_string(ns / 1000);
+	out += '.';
+	std::string fraction = std::to_string(ns % 1000);
+	out.append(3 - fraction.size(), '0');
+	out += fraction;
+}
+
+bool Tracer::write_chrome_trace(const std::string& path)
+{
+	BufferedWriter writer;
+	if (!writer.open(path, false)) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::string event;
+	bool is_first = true;
+	auto write_event = [&writer, &event, &is_first]() {
+		writer.write(is_first ? "{\"traceEvents\": [\n" : ",\n");
+		writer.write(event);
+		is_first = false;
+	};
+
+	// Every thread name gets one timeline row, whichever buffers its spans were recorded in,
+	// so threads running at the same time need different names.
+	// Spans recorded before a thread set its name stay in the row of their buffer.
+	std::map<std::string, std::string> name_tids;
+	std::vector<std::string> tids;
+	for (const auto& buffer : m_buffers) {
+		const std::vector<std::string>& names = buffer->get_thread_names();
+		tids.assign(1, std::to_string(buffer->get_thread_id()));
+		for (size_t i = 1; i < names.size(); ++i) {
+			auto it = name_tids.find(names[i]);
+			if (it == name_tids.end()) {
+				it = name_tids.emplace(names[i], std::to_string(m_buffers.size() + name_tids.size())).first;
+				event = "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " + it->second + ", \"args\": {\"name\": \"" + names[i] + "\"}}";
+				write_event();
+			}
+			tids.push_back(it->second);
+		}
+		for (const TraceBuffer::Span& span : buffer->get_spans()) {
+			event = "{\"name\": \"";
+			event += span.name;
+			event += "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " + tids[span.thread_name] + ", \"ts\": ";
+			add_us(event, span.start_ns);
+			event += ", \"dur\": ";
+			add_us(event, span.duration_ns);
+			event += "}";
+			write_event();
+		}
+	}
+	writer.write(is_first ? "{\"traceEvents\": [\n" : "\n");
+	writer.write("], \"displayTimeUnit\": \"ms\"}\n");
+	return writer.close();
+}
+
+bool write_trace_timeline(const std::string& path)
+{
+	if (!Tracer::instance().write_chrome_trace(path)) {
+		log_error() << "can't write trace timeline" << path;
+		return false;
+	}
+	return true;
+}
+
+#else
+
+bool write_trace_timeline(const std::string&)
+{
+	log_error() << "trace timeline is not available, build with -DENABLE_TRACING=ON";
+	return false;
+}
+
+#endif
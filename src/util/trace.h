@@ -0,0 +1,191 @@
+#pragma once
+
+// Timeline of ATPG phases exported in Chrome trace event format (opens in Perfetto or chrome://tracing).
+// TRACE_SCOPE("name") records a span until the end of the enclosing scope, name must be a string literal.
+// TRACE_THREAD_NAME(name) names the timeline row of the calling thread, threads running at the same time need different names.
+// Every thread records into its own ring buffer without locks, oldest spans are overwritten when it is full.
+// Tracing is compiled in only with ENABLE_TRACING (cmake -DENABLE_TRACING=ON), otherwise the macros are empty.
+
+#include <string>
+
+#if ENABLE_TRACING
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) Tracer::get_thread_buffer().set_thread_name(name)
+
+class TraceBuffer
+{
+public:
+	struct Span
+	{
+		const char* name;
+		uint64_t start_ns;
+		uint64_t duration_ns;
+		uint32_t thread_name; // index in get_thread_names()
+	};
+
+	static constexpr size_t capacity = 1 << 16;
+
+	TraceBuffer(size_t thread_id)
+		: m_thread_id(thread_id)
+		, m_thread_names(1)
+		, m_count(0)
+	{}
+
+	// Only called by the owning thread
+	void add(const char* name, uint64_t start_ns, uint64_t duration_ns)
+	{
+		uint64_t count = m_count.load(std::memory_order_relaxed);
+		if (m_spans.size() < capacity) {
+			m_spans.push_back({name, start_ns, duration_ns, m_thread_name});
+		} else {
+			m_spans[count % capacity] = {name, start_ns, duration_ns, m_thread_name};
+		}
+		m_count.store(count + 1, std::memory_order_release);
+	}
+
+	// Spans keep the name of the thread that recorded them, a reused buffer has several names
+	void set_thread_name(const std::string& name)
+	{
+		auto it = std::find(m_thread_names.begin(), m_thread_names.end(), name);
+		m_thread_name = it - m_thread_names.begin();
+		if (it == m_thread_names.end()) {
+			m_thread_names.push_back(name);
+		}
+	}
+
+	// Recorded spans, oldest first. Spans being overwritten at the same time may be inconsistent,
+	// so this should be called after the thread stopped recording.
+	std::vector<Span> get_spans() const
+	{
+		uint64_t count = m_count.load(std::memory_order_acquire);
+		uint64_t first = count > capacity ? count - capacity : 0;
+		std::vector<Span> spans;
+		spans.reserve(count - first);
+		for (uint64_t i = first; i < count; ++i) {
+			spans.push_back(m_spans[i % capacity]);
+		}
+		return spans;
+	}
+
+	size_t get_thread_id() const { return m_thread_id; }
+	// The first name is empty, it is used before a thread sets its name
+	const std::vector<std::string>& get_thread_names() const { return m_thread_names; }
+
+private:
+	std::vector<Span> m_spans;
+	size_t m_thread_id;
+	std::vector<std::string> m_thread_names;
+	uint32_t m_thread_name = 0;
+	std::atomic<uint64_t> m_count;
+};
+
+class Tracer
+{
+public:
+	static Tracer& instance()
+	{
+		static Tracer tracer;
+		return tracer;
+	}
+
+	// Buffer is taken on the first span of a thread and given to the next new thread after the thread exits,
+	// so short-lived threads (e.g. portfolio solvers) don't allocate a new ring buffer every time
+	static TraceBuffer& get_thread_buffer()
+	{
+		thread_local ThreadBuffer buffer;
+		return *buffer.buffer;
+	}
+
+	uint64_t now_ns() const
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+	}
+
+	// Spans of all threads as trace event JSON, should be called when other threads don't record anymore
+	bool write_chrome_trace(const std::string& path);
+
+private:
+	Tracer()
+		: m_start(std::chrono::steady_clock::now())
+	{}
+
+	struct ThreadBuffer
+	{
+		ThreadBuffer()
+			: buffer(instance().acquire_buffer())
+		{}
+
+		~ThreadBuffer()
+		{
+			instance().release_buffer(buffer);
+		}
+
+		TraceBuffer* buffer;
+	};
+
+	TraceBuffer* acquire_buffer()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_free_buffers.empty()) {
+			TraceBuffer* buffer = m_free_buffers.back();
+			m_free_buffers.pop_back();
+			buffer->set_thread_name(std::string());
+			return buffer;
+		}
+		m_buffers.emplace_back(new TraceBuffer(m_buffers.size()));
+		return m_buffers.back().get();
+	}
+
+	void release_buffer(TraceBuffer* buffer)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_free_buffers.push_back(buffer);
+	}
+
+	std::chrono::steady_clock::time_point m_start;
+	std::mutex m_mutex;
+	std::vector<std::unique_ptr<TraceBuffer>> m_buffers;
+	std::vector<TraceBuffer*> m_free_buffers;
+};
+
+class TraceScope
+{
+public:
+	TraceScope(const char* name)
+		: m_name(name)
+		, m_start_ns(Tracer::instance().now_ns())
+	{}
+
+	TraceScope(const TraceScope&) = delete;
+
+	~TraceScope()
+	{
+		uint64_t end_ns = Tracer::instance().now_ns();
+		Tracer::get_thread_buffer().add(m_name, m_start_ns, end_ns - m_start_ns);
+	}
+
+private:
+	const char* m_name;
+	uint64_t m_start_ns;
+};
+
+#else
+
+#define TRACE_SCOPE(name)
+#define TRACE_THREAD_NAME(name)
+
+#endif
+
+// Writes the timeline, returns false if tracing isn't compiled in or the file can't be written
+bool write_trace_timeline(const std::string& path);
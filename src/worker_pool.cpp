@@ -0,0 +1,405 @@
+#include "worker_pool.h"
+
+#include "util/async_log.h"
+#include "util/log.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+
+#ifdef __unix__
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+struct WorkerPool::Worker
+{
+	int pid = -1;
+	int task_fd = -1;
+	int result_fd = -1;
+
+	// Range of indices in fault id list that is being processed
+	size_t first = 0;
+	size_t count = 0;
+	size_t done = 0;
+	bool lost_range = false; // died before it got its next range, the range was handed out again
+
+	std::string buffer;
+
+	bool is_alive() const { return pid != -1; }
+	bool is_busy() const { return done < count; }
+};
+
+#ifdef __unix__
+
+namespace
+{
+
+struct Range
+{
+	uint64_t first;
+	uint64_t count;
+};
+
+// fault id, solve time, cnf time, pattern size, status, redundant by implications, used portfolio, portfolio winner, solved cubes,
+// cone lines, partial cnf, clauses, variables, conflicts
+const size_t result_header_size = 8 + 8 + 8 + 4 + 1 + 1 + 1 + 4 + 1 + 4 + 4 + 1 + 8 + 4 + 8;
+
+template <typename T>
+void put(std::string& buffer, T value)
+{
+	buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T get(const char*& data)
+{
+	T value;
+	memcpy(&value, data, sizeof(value));
+	data += sizeof(value);
+	return value;
+}
+
+void serialize_result(const WorkerResult& result, std::string& buffer)
+{
+	put<uint64_t>(buffer, result.record.fault_id);
+	put<uint64_t>(buffer, result.record.solve_time_us);
+	put<uint64_t>(buffer, result.cnf_time_us);
+	put<uint32_t>(buffer, result.record.pattern.size());
+	put<char>(buffer, static_cast<char>(result.record.status));
+	put<char>(buffer, result.is_redundant_by_implications);
+	put<char>(buffer, result.used_portfolio);
+	put<int32_t>(buffer, result.portfolio_winner);
+	put<char>(buffer, result.used_cubes);
+	put<uint32_t>(buffer, result.solved_cubes);
+	put<uint32_t>(buffer, result.cone_lines);
+	put<char>(buffer, result.is_partial_cnf);
+	put<uint64_t>(buffer, result.clauses);
+	put<uint32_t>(buffer, result.variables);
+	put<uint64_t>(buffer, result.conflicts);
+	buffer += result.record.pattern;
+}
+
+// Returns number of bytes used, 0 if buffer doesn't contain complete result
+size_t deserialize_result(const char* data, size_t size, WorkerResult& result)
+{
+	if (size < result_header_size) {
+		return 0;
+	}
+	result.record.fault_id = get<uint64_t>(data);
+	result.record.solve_time_us = get<uint64_t>(data);
+	result.cnf_time_us = get<uint64_t>(data);
+	uint32_t pattern_size = get<uint32_t>(data);
+	result.record.status = static_cast<FaultStatus>(get<char>(data));
+	result.is_redundant_by_implications = get<char>(data);
+	result.used_portfolio = get<char>(data);
+	result.portfolio_winner = get<int32_t>(data);
+	result.used_cubes = get<char>(data);
+	result.solved_cubes = get<uint32_t>(data);
+	result.cone_lines = get<uint32_t>(data);
+	result.is_partial_cnf = get<char>(data);
+	result.clauses = get<uint64_t>(data);
+	result.variables = get<uint32_t>(data);
+	result.conflicts = get<uint64_t>(data);
+	if (size < result_header_size + pattern_size) {
+		return 0;
+	}
+	result.record.pattern.assign(data, pattern_size);
+	return result_header_size + pattern_size;
+}
+
+bool write_all(int fd, const char* data, size_t size)
+{
+	while (size) {
+		ssize_t written = write(fd, data, size);
+		if (written < 0 && errno == EINTR) {
+			continue;
+		}
+		if (written <= 0) {
+			return false;
+		}
+		data += written;
+		size -= written;
+	}
+	return true;
+}
+
+// Returns false on end of file or error
+bool read_all(int fd, char* data, size_t size)
+{
+	while (size) {
+		ssize_t was_read = read(fd, data, size);
+		if (was_read < 0 && errno == EINTR) {
+			continue;
+		}
+		if (was_read <= 0) {
+			return false;
+		}
+		data += was_read;
+		size -= was_read;
+	}
+	return true;
+}
+
+void close_fd(int& fd)
+{
+	if (fd != -1) {
+		close(fd);
+		fd = -1;
+	}
+}
+
+[[noreturn]] void worker_main(int task_fd, int result_fd, const std::vector<size_t>& fault_ids, const WorkerPool::SolveFunction& solve)
+{
+	Range range;
+	std::string buffer;
+	WorkerResult result;
+	while (read_all(task_fd, reinterpret_cast<char*>(&range), sizeof(range))) {
+		for (size_t i = range.first; i < range.first + range.count; ++i) {
+			result = WorkerResult();
+			result.record.fault_id = fault_ids[i];
+			solve(fault_ids[i], result);
+
+			buffer.clear();
+			serialize_result(result, buffer);
+			if (!write_all(result_fd, buffer.data(), buffer.size())) {
+				_exit(1);
+			}
+		}
+	}
+	// _exit skips destructors and stdio buffers inherited from master
+	_exit(0);
+}
+
+}
+
+bool WorkerPool::start_worker(Worker& worker, std::vector<Worker>& workers, const std::vector<size_t>& fault_ids, const SolveFunction& solve)
+{
+	int task_pipe[2];
+	int result_pipe[2];
+	if (pipe(task_pipe) != 0) {
+		log_error() << "can't create pipe:" << strerror(errno);
+		return false;
+	}
+	if (pipe(result_pipe) != 0) {
+		log_error() << "can't create pipe:" << strerror(errno);
+		close(task_pipe[0]);
+		close(task_pipe[1]);
+		return false;
+	}
+
+	if (AsyncLogWriter::instance().is_running()) {
+		AsyncLogWriter::instance().flush();
+	}
+	std::cout.flush();
+	std::cerr.flush();
+	fflush(nullptr);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		log_error() << "can't start worker:" << strerror(errno);
+		for (int fd : {task_pipe[0], task_pipe[1], result_pipe[0], result_pipe[1]}) {
+			close(fd);
+		}
+		return false;
+	}
+
+	if (pid == 0) {
+		AsyncLogWriter::instance().detach();
+		// Pipes of other workers must be closed, otherwise master won't see their end of file
+		for (Worker& other : workers) {
+			close_fd(other.task_fd);
+			close_fd(other.result_fd);
+		}
+		close(task_pipe[1]);
+		close(result_pipe[0]);
+		worker_main(task_pipe[0], result_pipe[1], fault_ids, solve);
+	}
+
+	close(task_pipe[0]);
+	close(result_pipe[1]);
+	worker = Worker();
+	worker.pid = pid;
+	worker.task_fd = task_pipe[1];
+	worker.result_fd = result_pipe[0];
+	return true;
+}
+
+void WorkerPool::stop_worker(Worker& worker)
+{
+	close_fd(worker.task_fd);
+	close_fd(worker.result_fd);
+	if (worker.is_alive()) {
+		int status;
+		while (waitpid(worker.pid, &status, 0) < 0 && errno == EINTR) {
+		}
+		worker.pid = -1;
+	}
+}
+
+bool WorkerPool::run(const std::vector<size_t>& fault_ids, const SolveFunction& solve, const ResultFunction& on_result)
+{
+	if (fault_ids.empty()) {
+		return true;
+	}
+
+	size_t range_size = m_range_size;
+	if (!range_size) {
+		range_size = std::max<size_t>(1, std::min<size_t>(64, fault_ids.size() / (m_process_count * 8)));
+	}
+
+	std::deque<Range> ranges;
+	for (size_t first = 0; first < fault_ids.size(); first += range_size) {
+		ranges.push_back({first, std::min(range_size, fault_ids.size() - first)});
+	}
+
+	// Writes to pipe of a dead worker must fail instead of killing master
+	void (*prev_sigpipe)(int) = signal(SIGPIPE, SIG_IGN);
+
+	std::vector<Worker> workers(std::min(m_process_count, ranges.size()));
+	for (Worker& worker : workers) {
+		start_worker(worker, workers, fault_ids, solve);
+	}
+
+	std::vector<pollfd> poll_fds;
+	std::vector<Worker*> poll_workers;
+	char read_buffer[1 << 14];
+	WorkerResult result;
+	// Workers that die before taking a range are restarted, but not forever if they never get anything done
+	size_t restarts_without_result = 0;
+
+	while (true) {
+		for (Worker& worker : workers) {
+			if (!worker.is_alive() || worker.is_busy() || worker.task_fd == -1) {
+				continue;
+			}
+			if (ranges.empty()) {
+				// Worker exits when it sees end of file
+				close_fd(worker.task_fd);
+				continue;
+			}
+			Range range = ranges.front();
+			if (!write_all(worker.task_fd, reinterpret_cast<const char*>(&range), sizeof(range))) {
+				// Worker is dead and hasn't started the range, handled when its result pipe is closed
+				worker.lost_range = true;
+				close_fd(worker.task_fd);
+				continue;
+			}
+			ranges.pop_front();
+			worker.first = range.first;
+			worker.count = range.count;
+			worker.done = 0;
+		}
+
+		poll_fds.clear();
+		poll_workers.clear();
+		for (Worker& worker : workers) {
+			if (worker.result_fd != -1) {
+				poll_fds.push_back({worker.result_fd, POLLIN, 0});
+				poll_workers.push_back(&worker);
+			}
+		}
+		if (poll_fds.empty()) {
+			break;
+		}
+
+		if (poll(poll_fds.data(), poll_fds.size(), -1) < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			log_error() << "poll failed:" << strerror(errno);
+			break;
+		}
+
+		for (size_t i = 0; i < poll_fds.size(); ++i) {
+			if (!poll_fds[i].revents) {
+				continue;
+			}
+			Worker& worker = *poll_workers[i];
+			ssize_t was_read = read(worker.result_fd, read_buffer, sizeof(read_buffer));
+			if (was_read < 0 && errno == EINTR) {
+				continue;
+			}
+
+			if (was_read > 0) {
+				worker.buffer.append(read_buffer, was_read);
+				size_t used;
+				size_t offset = 0;
+				while ((used = deserialize_result(worker.buffer.data() + offset, worker.buffer.size() - offset, result)) != 0) {
+					offset += used;
+					++worker.done;
+					restarts_without_result = 0;
+					on_result(result);
+				}
+				worker.buffer.erase(0, offset);
+				continue;
+			}
+
+			bool crashed = worker.is_busy();
+			bool lost_range = worker.lost_range;
+			stop_worker(worker);
+			if (!crashed) {
+				if (lost_range && !ranges.empty() && restarts_without_result++ < workers.size()) {
+					start_worker(worker, workers, fault_ids, solve);
+				}
+				continue;
+			}
+
+			// Fault being solved is the first one without result
+			++m_crashed_workers;
+			result = WorkerResult();
+			result.record.fault_id = fault_ids[worker.first + worker.done];
+			on_result(result);
+			log_error() << "worker crashed, fault" << result.record.fault_id << "is reported as unknown";
+
+			if (worker.done + 1 < worker.count) {
+				ranges.push_front({worker.first + worker.done + 1, worker.count - worker.done - 1});
+			}
+			if (!ranges.empty()) {
+				start_worker(worker, workers, fault_ids, solve);
+			}
+		}
+	}
+
+	for (Worker& worker : workers) {
+		stop_worker(worker);
+	}
+	signal(SIGPIPE, prev_sigpipe);
+
+	if (!ranges.empty()) {
+		log_error() << "no workers left," << ranges.size() << "fault ranges are not processed";
+		return false;
+	}
+	return true;
+}
+
+#else
+
+bool WorkerPool::start_worker(Worker&, std::vector<Worker>&, const std::vector<size_t>&, const SolveFunction&)
+{
+	return false;
+}
+
+void WorkerPool::stop_worker(Worker&)
+{}
+
+// No fork, faults are processed in this process
+bool WorkerPool::run(const std::vector<size_t>& fault_ids, const SolveFunction& solve, const ResultFunction& on_result)
+{
+	WorkerResult result;
+	for (size_t fault_id : fault_ids) {
+		result = WorkerResult();
+		result.record.fault_id = fault_id;
+		solve(fault_id, result);
+		on_result(result);
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "journal.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+struct WorkerResult
+{
+	FaultRecord record;
+	uint64_t cnf_time_us = 0;
+	bool is_redundant_by_implications = false; // undetectable without SAT solving
+	bool used_portfolio = false;
+	int32_t portfolio_winner = -1; // index of portfolio config that solved the fault
+	bool used_cubes = false; // went to cube-and-conquer after the conflict budget
+	uint32_t solved_cubes = 0; // cubes solved by cube-and-conquer
+
+	// Fault details for tracing
+	uint32_t cone_lines = 0; // lines in the fanout cone of the fault
+	bool is_partial_cnf = false;
+	uint64_t clauses = 0; // clauses in the solver
+	uint32_t variables = 0; // highest variable in the solver
+	uint64_t conflicts = 0; // only counted when tracing
+};
+
+// Processes faults in forked worker processes.
+// Everything built before run() (circuit, fault list, CNF) is shared with workers through copy-on-write pages,
+// so workers don't parse or encode anything. Master hands out ranges of fault ids over a pipe
+// and collects results over another one. If a worker dies, the fault it was solving is reported as unknown,
+// rest of its range is handed out again and a new worker is started.
+class WorkerPool
+{
+public:
+	// Called in worker process, must fill the result for fault_id
+	using SolveFunction = std::function<void(size_t fault_id, WorkerResult& result)>;
+	// Called in master process for every fault in the order results arrive
+	using ResultFunction = std::function<void(const WorkerResult& result)>;
+
+	WorkerPool(size_t process_count)
+		: m_process_count(process_count)
+	{}
+
+	// Faults are handed out in ranges of at most range_size, 0 selects size from fault and process count
+	void set_range_size(size_t range_size) { m_range_size = range_size; }
+
+	bool run(const std::vector<size_t>& fault_ids, const SolveFunction& solve, const ResultFunction& on_result);
+
+	size_t get_crashed_workers() const { return m_crashed_workers; }
+
+private:
+	struct Worker;
+
+	bool start_worker(Worker& worker, std::vector<Worker>& workers, const std::vector<size_t>& fault_ids, const SolveFunction& solve);
+	void stop_worker(Worker& worker);
+
+	size_t m_process_count = 1;
+	size_t m_range_size = 0;
+	size_t m_crashed_workers = 0;
+};